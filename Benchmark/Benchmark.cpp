@@ -1,9 +1,14 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/generators/catch_generators.hpp>
 
 #include <iostream>
 #include "Bullet_Plain.h"
 #include "Bullet_Measured.h"
+#include "Plume_Plain.h"
+
+#include "Plume.h"
+#include "Workload.h"
 
 #include "Meter2.h"
 #include "Foot.h"
@@ -58,6 +63,90 @@ TEST_CASE("Bullet", "[!benchmark]")
     }
 }
 
+TEST_CASE("Plume", "[!benchmark]")
+{
+    using namespace CALINE3;
+
+    // Synthetic workloads: all link types, stability classes and BASE values (random winds),
+    // mixing heights below 1000 m, with and without settling/deposition:
+    WorkloadSpec spec;
+    spec.Links = 24;
+    spec.Receptors = 40;
+    spec.Meteos = 12;
+    spec.Geometry = GENERATE(Layout::Grid, Layout::SCurve);
+    spec.Types = { "AG", "BR", "FL", "DP" };
+    spec.MixingHeights = { 1000.0, 400.0, 150.0 };
+    spec.VS = GENERATE(0.0, 1.0);
+    spec.VD = 2.0 * spec.VS;
+    spec.Seed = 7;
+
+    Workload workload{ spec };
+    const Job site = workload.Generate();
+
+    // Plain (double) twins of the measured inputs:
+    const Plain::Site plainSite{ site.ATIM.value(), site.Z0.value(), site.VS1.value(), site.VD1.value() };
+    std::vector<Plain::Meteo> plainMeteos;
+    for (auto const& m : site.Meteos)
+    {
+        plainMeteos.emplace_back(m.U.value(), m.BRG1.value(), m.CLAS, m.MIXH.value());
+    }
+    std::vector<Plain::Link> plainLinks;
+    for (auto const& l : site.Links)
+    {
+        plainLinks.emplace_back(l.TYP, l.XL1.value(), l.YL1.value(), l.XL2.value(), l.YL2.value(), l.VPHL.value(), l.EFL.value(), l.HL.value(), l.WL.value());
+    }
+    std::vector<double> plainReceptors;
+    for (auto const& r : site.Receptors)
+    {
+        plainReceptors.insert(plainReceptors.end(), { r.XR.value(), r.YR.value(), r.ZR.value() });
+    }
+
+    std::vector<double> p;
+    std::vector<Microgram_Meter3> m;
+
+    BENCHMARK("plume plain")
+    {
+        p.clear();
+        for (auto const& meteo : plainMeteos)
+        {
+            for (auto const& link : plainLinks)
+            {
+                const Plain::Plume plume{ plainSite, meteo, link };
+                for (std::size_t R = 0; R < plainReceptors.size(); R += 3)
+                {
+                    p.push_back(plume.ConcentrationAt(plainReceptors[R], plainReceptors[R + 1], plainReceptors[R + 2]));
+                }
+            }
+        }
+        return p.size();
+    };
+
+    BENCHMARK("plume measured")
+    {
+        m.clear();
+        for (auto const& meteo : site.Meteos)
+        {
+            for (auto const& link : site.Links)
+            {
+                CALINE3::Plume plume{ site, meteo, link };
+                for (auto const& receptor : site.Receptors)
+                {
+                    m.push_back(plume.ConcentrationAt(receptor));
+                }
+            }
+        }
+        return m.size();
+    };
+
+    REQUIRE(p.size() == m.size());
+
+    for (std::size_t i = 0; i < m.size(); i++)
+    {
+        // Measured and plain results must be equal. Is this the case?
+        CHECK(p[i] == m[i].value());
+    }
+}
+
 TEST_CASE("Math", "[!benchmark]")
 {
     double x = MATH_PI;
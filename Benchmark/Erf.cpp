@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Plume_Plain.h"
+
+#include "Maths.h"
+#include "Workload.h"
+
+using namespace CALINE3;
+
+/*
+ * Error function variants (Maths::ErfVariant): speed [ns/call] and accuracy (maximum absolute
+ * and relative error against the long double std::erf) over the arguments LinkElement::SourceStrength
+ * actually produces, traced (by the plain twin of the plume path) on synthetic workloads.
+ */
+
+namespace
+{
+    constexpr int REPEAT = 5;
+
+    const char *VARIANT_LABEL[] = { "Abramowitz-Stegun 7.1.26", "std::erf", "fast (A&S 7.1.25)", "vector (A&S 7.1.26)" };
+    const ErfVariant VARIANTS[] = { ErfVariant::AbramowitzStegun, ErfVariant::Std, ErfVariant::Fast, ErfVariant::Vector };
+
+    std::vector<double> TraceArguments()
+    {
+        std::vector<double> args;
+        Plain::ErfTrace = &args;
+        for (Layout layout : { Layout::Grid, Layout::SCurve })
+        {
+            WorkloadSpec spec;
+            spec.Links = 12;
+            spec.Receptors = 24;
+            spec.Meteos = 8;
+            spec.Geometry = layout;
+            spec.Types = { "AG", "BR", "FL", "DP" };
+            spec.MixingHeights = { 1000.0, 150.0 };
+            spec.Seed = 5;
+            const Job site = Workload{ spec }.Generate();
+
+            const Plain::Site plainSite{ site.ATIM.value(), site.Z0.value(), site.VS1.value(), site.VD1.value() };
+            for (auto const& m : site.Meteos)
+            {
+                const Plain::Meteo meteo{ m.U.value(), m.BRG1.value(), m.CLAS, m.MIXH.value() };
+                for (auto const& l : site.Links)
+                {
+                    const Plain::Link link{ l.TYP, l.XL1.value(), l.YL1.value(), l.XL2.value(), l.YL2.value(), l.VPHL.value(), l.EFL.value(), l.HL.value(), l.WL.value() };
+                    const Plain::Plume plume{ plainSite, meteo, link };
+                    for (auto const& r : site.Receptors)
+                    {
+                        plume.ConcentrationAt(r.XR.value(), r.YR.value(), r.ZR.value());
+                    }
+                }
+            }
+        }
+        Plain::ErfTrace = nullptr;
+        return args;
+    }
+
+    double NanosecondsPerCall(ErfVariant variant, const std::vector<double>& x, std::vector<double>& y)
+    {
+        double best = 0.0;
+        for (int r = 0; r < REPEAT; r++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            Maths::Erf(variant, x.data(), y.data(), x.size());
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(x.size());
+            if ((r == 0) || (ns < best))
+                best = ns;
+        }
+        return best;
+    }
+}
+
+TEST_CASE("Erf", "[!benchmark]")
+{
+    const std::vector<double> args = TraceArguments();
+    REQUIRE(!args.empty());
+
+    auto [lo, hi] = std::minmax_element(args.begin(), args.end());
+    std::size_t tails = static_cast<std::size_t>(std::count_if(args.begin(), args.end(), [](double x) { return std::abs(x) > 4.0; }));
+    std::cout << std::endl
+        << "SourceStrength arguments: " << args.size() << " in [" << *lo << ", " << *hi << "], "
+        << std::fixed << std::setprecision(1) << 100.0 * tails / args.size() << "% beyond |x| > 4" << std::endl;
+
+    std::vector<long double> exact(args.size());
+    for (std::size_t i = 0; i < args.size(); i++)
+    {
+        exact[i] = std::erf(static_cast<long double>(args[i]));
+    }
+
+    std::vector<double> reference(args.size());
+    Maths::Erf(ErfVariant::AbramowitzStegun, args.data(), reference.data(), args.size());
+
+    std::cout << std::left << std::setw(28) << "variant" << std::right
+        << std::setw(10) << "ns/call" << std::setw(16) << "max abs error" << std::setw(16) << "max rel error" << std::endl;
+
+    std::vector<double> y(args.size());
+    for (ErfVariant variant : VARIANTS)
+    {
+        const double ns = NanosecondsPerCall(variant, args, y);
+
+        double abs_error = 0.0;
+        double rel_error = 0.0;
+        for (std::size_t i = 0; i < args.size(); i++)
+        {
+            double error = static_cast<double>(std::abs(y[i] - exact[i]));
+            abs_error = std::max(abs_error, error);
+            if (exact[i] != 0.0L)
+                rel_error = std::max(rel_error, static_cast<double>(error / std::abs(exact[i])));
+        }
+
+        std::cout << std::left << std::setw(28) << VARIANT_LABEL[static_cast<int>(variant)] << std::right
+            << std::fixed << std::setw(10) << std::setprecision(2) << ns
+            << std::scientific << std::setw(16) << std::setprecision(2) << abs_error << std::setw(16) << rel_error << std::endl;
+
+        // Documented accuracy:
+        switch (variant)
+        {
+            case ErfVariant::AbramowitzStegun: CHECK(abs_error <= 1.5e-7); break;
+            case ErfVariant::Std:              CHECK(abs_error <= 1e-15); break;
+            case ErfVariant::Fast:             CHECK(abs_error <= 2.5e-5); break;
+            case ErfVariant::Vector:           CHECK(y == reference); break;  // (bit for bit)
+        }
+    }
+    std::cout << std::defaultfloat;
+
+    for (ErfVariant variant : VARIANTS)
+    {
+        BENCHMARK(VARIANT_LABEL[static_cast<int>(variant)])
+        {
+            Maths::Erf(variant, args.data(), y.data(), args.size());
+            return y.back();
+        };
+    }
+}
@@ -0,0 +1,250 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Plume.h"
+
+using namespace CALINE3;
+using namespace CALINE3::Metrology;
+
+/*
+ * CALINE3 hot path kernels, measured one by one.
+ *
+ * Parameter regimes:
+ *  - element growth BASE (1.1, 1.5, 2.0, 4.0) selected by the wind angle to the link,
+ *  - mixing height below 1000 m (reflections evaluated in GaussianFactor),
+ *  - non-zero settling and deposition velocities (DepositionFactor/SettlingFactor in use).
+ */
+
+namespace
+{
+    // Wind angles (to the link) selecting each of the element growth BASE values:
+    const double WIND_ANGLE[] = { 10.0, 35.0, 60.0, 80.0 };
+    const char *BASE_TAG[] = { "BASE=1.1", "BASE=1.5", "BASE=2.0", "BASE=4.0" };
+
+    Job Site(const char *name, double vs, double vd)
+    {
+        return Job{ 0, name, Minute(60.0), Centimeter(100.0), Centimeter_Sec(vs), Centimeter_Sec(vd), 0, 1.0 };
+    }
+
+    Link Road(const char *typ, double hl)
+    {
+        return Link{ 0, "LINK", typ, Meter(-2000.0), Meter(0.0), Meter(2000.0), Meter(0.0), Vehicles_Hour(8000.0), Gram_Mile(30.0), Meter(hl), Meter(30.0) };
+    }
+
+    Meteo Wind(const Link& link, double angle, int clas, double mixh)
+    {
+        return Meteo{ 0, Meter_Sec(1.0), link.LBRG() + Degree(angle), clas, Meter(mixh), Ppm(0.0) };
+    }
+
+    std::vector<Receptor> Receptors()
+    {
+        // Along and across the link, both sides, at breathing height and above:
+        std::vector<Receptor> receptors;
+        for (double y : { -200.0, -50.0, -15.0, 15.0, 50.0, 200.0 })
+        {
+            for (double x : { -1000.0, 0.0, 1500.0 })
+            {
+                for (double z : { 1.8, 10.0 })
+                {
+                    receptors.emplace_back(receptors.size(), "R", Meter(x), Meter(y), Meter(z));
+                }
+            }
+        }
+        return receptors;
+    }
+}
+
+TEST_CASE("Kernels", "[!benchmark]")
+{
+    const Job still = Site("STILL", 0.0, 0.0);
+    const Job settling = Site("SETTLING", 1.0, 2.0);
+    const Link ag = Road("AG", 0.0);
+    const Link dp = Road("DP", -3.0);
+    const std::vector<Receptor> receptors = Receptors();
+
+    SECTION("Maths")
+    {
+        std::vector<double> args;
+        for (double x = -4.0; x <= 4.0; x += 0.125)
+        {
+            args.push_back(x);
+        }
+
+        BENCHMARK("Erf")
+        {
+            double sum = 0.0;
+            for (double x : args) sum += Erf(x);
+            return sum;
+        };
+
+        BENCHMARK("Azimuth")
+        {
+            Radian sum{ 0.0 };
+            for (auto const& r : receptors) sum += Azimuth(ag.XL1, ag.YL1, r.XR, r.YR);
+            return sum;
+        };
+
+        BENCHMARK("Distance")
+        {
+            Meter sum{ 0.0 };
+            for (auto const& r : receptors) sum += Distance(ag.XL1, ag.YL1, r.XR, r.YR);
+            return sum;
+        };
+    }
+
+    SECTION("Link")
+    {
+        for (const Link *link : { &ag, &dp })
+        {
+            BENCHMARK("TransformReceptorCoordinates " + link->TYP)
+            {
+                Meter sum{ 0.0 };
+                for (auto const& r : receptors)
+                {
+                    auto [D, L, Z] = link->TransformReceptorCoordinates(r);
+                    sum += D + L + Z;
+                }
+                return sum;
+            };
+        }
+    }
+
+    SECTION("LinkElement")
+    {
+        for (std::size_t b = 0; b < 4; b++)
+        {
+            const Meteo meteo = Wind(ag, WIND_ANGLE[b], 4, 1000.0);
+            const WindFlow flow{ meteo, ag };
+
+            // Elements growing from the receptor projection on the link:
+            std::vector<LinkElement> elements;
+            for (Meter start{ 0.0 }, EL = ag.WL; start + EL < ag.LL(); start += EL, EL *= flow.BASE())
+            {
+                elements.emplace_back(ag, flow, start, start + EL);
+            }
+
+            BENCHMARK(std::string("GetProfile ") + BASE_TAG[b])
+            {
+                int count = 0;
+                Microgram_Meter_Sec QE; Meter YE; Meter FET;
+                for (auto const& element : elements)
+                {
+                    for (double D : { -50.0, 15.0, 200.0 })
+                    {
+                        count += element.GetProfile(Meter(D), QE, YE, FET) ? 1 : 0;
+                    }
+                }
+                return count;
+            };
+
+            BENCHMARK(std::string("SourceStrength ") + BASE_TAG[b])
+            {
+                Microgram_Meter_Sec sum{ 0.0 };
+                for (auto const& element : elements)
+                {
+                    sum += element.SourceStrength(Microgram_Meter_Sec(100.0), Meter(20.0), Meter(5.0));
+                }
+                return sum;
+            };
+        }
+    }
+
+    SECTION("Plume")
+    {
+        for (int clas : { 1, 4, 6 })
+        {
+            const Meteo meteo = Wind(ag, 45.0, clas, 1000.0);
+            BENCHMARK("Plume construction CLAS=" + std::to_string(clas))
+            {
+                return Plume{ still, meteo, ag };
+            };
+        }
+
+        for (std::size_t b = 0; b < 4; b++)
+        {
+            const Meteo meteo = Wind(ag, WIND_ANGLE[b], 4, 1000.0);
+            Plume plume{ still, meteo, ag };
+
+            BENCHMARK(std::string("ConcentrationAt ") + BASE_TAG[b])
+            {
+                Microgram_Meter3 sum{ 0.0 };
+                for (auto const& r : receptors) sum += plume.ConcentrationAt(r);
+                return sum;
+            };
+        }
+
+        const Meteo low = Wind(ag, 45.0, 6, 50.0);
+        Plume mixing{ still, low, ag };
+        BENCHMARK("ConcentrationAt MIXH=50")
+        {
+            Microgram_Meter3 sum{ 0.0 };
+            for (auto const& r : receptors) sum += mixing.ConcentrationAt(r);
+            return sum;
+        };
+
+        const Meteo meteo = Wind(dp, 45.0, 4, 1000.0);
+        Plume depositing{ settling, meteo, dp };
+        BENCHMARK("ConcentrationAt VS=1 VD=2 (DP)")
+        {
+            Microgram_Meter3 sum{ 0.0 };
+            for (auto const& r : receptors) sum += depositing.ConcentrationAt(r);
+            return sum;
+        };
+
+        CHECK(std::isfinite(depositing.ConcentrationAt(receptors.front()).value()));
+    }
+
+    SECTION("Plume factors")
+    {
+        const Meteo meteo = Wind(ag, 45.0, 6, 1000.0);
+        const Meteo low = Wind(ag, 45.0, 6, 50.0);
+        Plume plume{ settling, meteo, ag };
+
+        std::vector<Meter> sigmas;
+        for (double sgz = 1.0; sgz <= 100.0; sgz *= 1.25)
+        {
+            sigmas.emplace_back(sgz);
+        }
+        const Meter Z{ 1.8 };
+        const Meter H{ 0.0 };
+
+        BENCHMARK("GaussianFactor MIXH=1000")
+        {
+            double sum = 0.0;
+            for (auto const& SGZ : sigmas) sum += plume.GaussianFactor(SGZ, Z, H, meteo.MIXH);
+            return sum;
+        };
+
+        BENCHMARK("GaussianFactor MIXH=50")
+        {
+            double sum = 0.0;
+            for (auto const& SGZ : sigmas) sum += plume.GaussianFactor(SGZ, Z, H, low.MIXH);
+            return sum;
+        };
+
+        BENCHMARK("DepositionFactor VS=1 VD=2")
+        {
+            double sum = 0.0;
+            for (auto const& SGZ : sigmas)
+            {
+                double FAC3 = plume.DepositionFactor(SGZ, Meter2_Sec(SGZ * SGZ / Second(200.0)), Z, H, settling.V1);
+                sum += std::isnan(FAC3) ? 0.0 : FAC3;
+            }
+            return sum;
+        };
+
+        BENCHMARK("SettlingFactor VS=1 VD=2")
+        {
+            double sum = 0.0;
+            for (auto const& SGZ : sigmas) sum += plume.SettlingFactor(SGZ, Meter2_Sec(SGZ * SGZ / Second(200.0)), Z, H, settling.VS);
+            return sum;
+        };
+
+        // Reflections at the mixing height only add up (in the Gaussian factor):
+        CHECK(plume.GaussianFactor(Meter(40.0), Z, H, low.MIXH) > plume.GaussianFactor(Meter(40.0), Z, H, meteo.MIXH));
+    }
+}
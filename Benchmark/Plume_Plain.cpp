@@ -0,0 +1,391 @@
+#include <algorithm>
+
+#include "Plume_Plain.h"
+
+namespace CALINE3::Plain
+{
+    // Unit factor ratios (as in the Metrology conversions):
+    constexpr double METER_SEC_FROM_CENTIMETER_SEC = 1.0 / 100.0;
+    constexpr double MICROGRAM_METER_FROM_GRAM_MILE = 1000000000.0 / 1609343.9999999998;
+    constexpr double HERTZ_FROM_VEHICLES_HOUR = 1.0 / 3600.0;
+    constexpr double DEGREE_FROM_RADIAN = DEGREES / 1.0;
+    constexpr double RADIAN_FROM_DEGREE = 1.0 / DEGREES;
+
+    constexpr double MAX_LENGTH = 10000.0;
+    constexpr double MIN_LENGTH = 1.0;
+    constexpr double HEIGHT_UNIT = 1.0;
+    constexpr double DEPRESSED_SECTION_DEPTH_THRESHOLD = -1.5;
+    constexpr double MAX_MIXH = 1000.0;
+
+    std::vector<double> *ErfTrace = nullptr;
+
+    const double SQRT_2{ std::sqrt(2.0) };
+    const double SQRT_2PI{ std::sqrt(2.0 * std::acos(-1.0)) };
+
+    //////////////////////////////////////////////////////////////////////
+    //
+    //  Maths
+    //
+
+    double Azimuth(double a, double b, double x, double y)
+    {
+        static const double PI{ std::acos(-1.0) };
+        static const double PI_2 = PI / 2.0;
+        static const double PI3_2 = PI_2 * 3.0;
+
+        return
+            (x > a) ? PI_2 - std::atan((y - b) / (x - a)) :
+            (x < a) ? PI3_2 - std::atan((y - b) / (x - a)) :
+            (y < b) ? PI : 0.0;
+    }
+
+    double Distance(double x1, double y1, double x2, double y2)
+    {
+        return std::sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+    }
+
+    double Erf(double x)
+    {
+        double t = 1.0 / (1.0 + 0.3275911 * ((x < 0) ? -x : x));
+        double erfx = std::exp(-x * x) * t * (0.254829592 + t * (-0.284496736 + t * (1.421413741 + t * (-1.453152027 + t * 1.061405429))));
+        return (x < 0) ? erfx - 1.0 : 1.0 - erfx;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //
+    //  Site, Meteo
+    //
+
+    Site::Site(double atim, double z0, double vs, double vd) :
+        VS(METER_SEC_FROM_CENTIMETER_SEC * vs),
+        V1(METER_SEC_FROM_CENTIMETER_SEC * vd - (METER_SEC_FROM_CENTIMETER_SEC * vs) / 2.0),
+        AFAC_3MIN_02(std::pow(atim / 3.0, 0.2)),
+        AFAC_30MIN_02(std::pow(atim / 30.0, 0.2)),
+        RFAC_3CM_02(std::pow(z0 / 3.0, 0.2)),
+        RFAC_3CM_007(std::pow(z0 / 3.0, 0.07)),
+        RFAC_10CM_007(std::pow(z0 / 10.0, 0.07))
+    {
+    }
+
+    static double vector_orientation(double brg)
+    {
+        brg += 180.0;
+        return (brg < 360.0) ? brg : brg - 360.0;
+    }
+
+    Meteo::Meteo(double u, double brg, int clas, double mixh) :
+        U(u), BRG(vector_orientation(brg)), CLAS(clas), MIXH(mixh)
+    {
+    }
+
+    double Meteo::AY1() const
+    {
+        static constexpr double _AY1[6]{ 0.46, 0.29, 0.18, 0.11, 0.087, 0.057 };
+        return _AY1[CLAS - 1];
+    }
+
+    double Meteo::AY2() const
+    {
+        static constexpr double _AY2[6]{ 1831.0, 1155.0, 717.0, 438.0, 346.0, 227.0 };
+        return _AY2[CLAS - 1];
+    }
+
+    double Meteo::AZ() const
+    {
+        static constexpr double _AZ[6]{ 1112.0, 556.0, 353.0, 219.0, 124.0, 56.0 };
+        return _AZ[CLAS - 1];
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //
+    //  Link
+    //
+
+    Link::Link(const std::string& typ, double xl1, double yl1, double xl2, double yl2, double vphl, double efl, double hl, double wl) :
+        XL1(xl1), YL1(yl1), XL2(xl2), YL2(yl2), HL(hl), WL(wl)
+    {
+        m_ll = Distance(XL1, YL1, XL2, YL2);
+        m_h = ((typ == "DP") || (typ == "FL")) ? 0.0 : HL;
+        m_slope = (typ != "AG") && (typ != "BR");
+        m_w2 = WL / 2.0;
+
+        if (HL < DEPRESSED_SECTION_DEPTH_THRESHOLD)
+        {
+            m_hds = HL;
+            m_dstr = 0.72 * std::pow(std::abs(m_hds / HEIGHT_UNIT), 0.83);
+        }
+        else
+        {
+            m_hds = 1.0;
+            m_dstr = 1.0;
+        }
+
+        m_lbrg = DEGREE_FROM_RADIAN * Azimuth(XL1, YL1, XL2, YL2);
+        m_q1 = (MICROGRAM_METER_FROM_GRAM_MILE * efl) * (HERTZ_FROM_VEHICLES_HOUR * vphl);
+    }
+
+    void Link::TransformReceptorCoordinates(double XR, double YR, double ZR, double& D, double& L, double& Z) const
+    {
+        double LR = Distance(XL1, YL1, XR, YR);
+        double lbrg = RADIAN_FROM_DEGREE * m_lbrg;
+        double GAMMA = Azimuth(XL1, YL1, XR, YR) - lbrg;
+
+        D = LR * std::sin(GAMMA);
+        L = LR * std::cos(GAMMA) - m_ll;
+
+        Z = ZR;
+        if (m_slope)
+        {
+            double D1 = m_w2 + 2.0 * std::abs(HL);
+            if (std::abs(D) < D1)
+            {
+                Z -= (std::abs(D) <= m_w2) ? HL : HL * (1.0 - (std::abs(D) - m_w2) / (2.0 * std::abs(HL)));
+            }
+        }
+    }
+
+    double Link::DepressedSectionFactor(double D) const
+    {
+        return ((m_hds >= DEPRESSED_SECTION_DEPTH_THRESHOLD) || (std::abs(D) >= (m_w2 - 3.0 * m_hds))) ? 1.0 :
+            (std::abs(D) <= m_w2) ? m_dstr : m_dstr - (m_dstr - 1.0) * ((std::abs(D) - m_w2) / (-3.0 * m_hds));
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //
+    //  WindFlow
+    //
+
+    WindFlow::WindFlow(const Meteo& meteo, const Link& link)
+    {
+        double phi = meteo.BRG - link.LBRG();
+
+        double teta = std::abs(phi);
+        if (teta >= 270.0) teta = 360.0 - teta;
+        else if (teta >= 180.0) teta -= 180.0;
+        else if (teta > 90.0) teta = 180.0 - teta;
+
+        m_phi = RADIAN_FROM_DEGREE * phi;
+        m_teta = RADIAN_FROM_DEGREE * teta;
+
+        m_base =
+            (teta < 20.0) ? 1.1 :
+            (teta < 50.0) ? 1.5 :
+            (teta < 70.0) ? 2.0 : 4.0;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //
+    //  LinkElement
+    //
+
+    LinkElement::LinkElement(const Link& master, const WindFlow& flow, double ED1, double ED2) :
+        master(master),
+        flow(flow),
+        EL2(std::abs(ED2 - ED1) / 2.0),
+        ECLD(-(ED1 + ED2) / 2.0),
+        ELL2(master.W2() * std::cos(flow.TETA()) + EL2 * std::sin(flow.TETA())),
+        CSL2((flow.TETA() >= std::atan(master.W2() / EL2)) ? master.W2() / std::sin(flow.TETA()) : EL2 / std::cos(flow.TETA())),
+        EM2(std::abs(EL2 * std::sin(flow.TETA()) - master.W2() * std::cos(flow.TETA()))),
+        EN2((ELL2 - EM2) / 2.0)
+    {
+    }
+
+    bool LinkElement::GetProfile(double D, double& QE, double& YE, double& FET) const
+    {
+        YE = ECLD * std::sin(flow.PHI()) - D * std::cos(flow.PHI());
+        FET = ECLD * std::cos(flow.PHI()) + D * std::sin(flow.PHI());
+
+        if (FET <= -CSL2)
+        {
+            return false;
+        }
+        else if (FET < CSL2)
+        {
+            FET = (CSL2 + FET) / 2.0;
+            QE = master.Q1() * (FET / master.W2());
+        }
+        else
+        {
+            QE = master.Q1() * (CSL2 / master.W2());
+        }
+        return true;
+    }
+
+    double LinkElement::SourceStrength(double QE, double SGY, double YE) const
+    {
+        static const double WT[] = { 0.25, 0.75, 1.0, 0.75, 0.25 };
+
+        double Y[6]{};
+        Y[0] = YE + ELL2;
+        Y[1] = Y[0] - EN2;
+        Y[2] = Y[1] - EN2;
+        Y[3] = Y[2] - 2.0 * EM2;
+        Y[4] = Y[3] - EN2;
+        Y[5] = Y[4] - EN2;
+
+        double E[6];
+        for (int j = 0; j < 6; j++)
+        {
+            E[j] = Erf(Y[j] / SGY / SQRT_2);
+            if (ErfTrace) ErfTrace->push_back(Y[j] / SGY / SQRT_2);
+        }
+
+        double FAC2{ 0.0 };
+        for (int j = 0; j < 5; j++)
+        {
+            FAC2 += QE * WT[j] * (E[j] - E[j + 1]) / 2.0;
+        }
+        return FAC2;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //
+    //  Plume
+    //
+
+    Plume::Plume(const Site& site, const Meteo& meteo, const Link& link) :
+        _site(site),
+        _meteo(meteo),
+        _link(link),
+        _flow(meteo, link)
+    {
+        PY1 = _meteo.AY1() * _site.RFAC_3CM_02 * _site.AFAC_3MIN_02;
+        double PY10 = _meteo.AY2() * _site.RFAC_3CM_007 * _site.AFAC_3MIN_02;
+        PY2 = std::log(PY10 / PY1) / std::log(MAX_LENGTH / MIN_LENGTH);
+
+        double TR = link.DSTR() * link.W2() / meteo.U;
+        double SGZI = 1.8 + 0.11 * TR;
+        double SGZ1 = SGZI * _site.AFAC_30MIN_02;
+        double SZ10 = _meteo.AZ() * _site.RFAC_10CM_007 * _site.AFAC_3MIN_02;
+
+        PZ2 = std::log(SZ10 / SGZ1) / std::log(MAX_LENGTH / _link.W2());
+        PZ1 = std::sqrt(SZ10 * SGZ1) / std::pow(std::sqrt(MAX_LENGTH * _link.W2()), PZ2);
+    }
+
+    double Plume::ConcentrationAt(double XR, double YR, double ZR) const
+    {
+        double D, L, Z;
+        _link.TransformReceptorCoordinates(XR, YR, ZR, D, L, Z);
+
+        double DWL = -(_link.LL() + L);
+        double UWL = -L;
+
+        double C{ 0.0 };
+
+        for (double elemEnd{ 0.0 }, EL = _link.WL; elemEnd < UWL; EL *= _flow.BASE())
+        {
+            double elemStart{ elemEnd };
+            elemEnd += EL;
+            if (elemEnd > DWL)
+            {
+                LinkElement elem{ _link, _flow, std::max(elemStart, DWL), std::min(elemEnd, UWL) };
+                C += ConcentrationFrom(elem, D, Z);
+            }
+        }
+
+        for (double elemStart{ 0.0 }, EL = _link.WL; elemStart > DWL; EL *= _flow.BASE())
+        {
+            double elemEnd{ elemStart };
+            elemStart -= EL;
+            if (elemStart < UWL)
+            {
+                LinkElement elem{ _link, _flow, std::max(elemStart, DWL), std::min(elemEnd, UWL) };
+                C += ConcentrationFrom(elem, D, Z);
+            }
+        }
+
+        return C;
+    }
+
+    double Plume::ConcentrationFrom(const LinkElement& element, double D, double Z) const
+    {
+        double QE, YE, FET;
+        if (!element.GetProfile(D, QE, YE, FET))
+        {
+            return 0.0;
+        }
+
+        double SGY{ PY1 * std::pow(FET, PY2) };
+        double SGZ{ PZ1 * std::pow(FET, PZ2) };
+        double KZ{ SGZ * SGZ / (2.0 * FET / _meteo.U) };
+
+        double FACT = element.SourceStrength(QE, SGY, YE) / (SQRT_2PI * SGZ * _meteo.U);
+        FACT *= _link.DepressedSectionFactor(D);
+
+        double FAC3 = DepositionFactor(SGZ, KZ, Z, _link.H(), _site.V1);
+        if (std::isnan(FAC3))
+        {
+            return 0.0;
+        }
+        else
+        {
+            FACT *= SettlingFactor(SGZ, KZ, Z, _link.H(), _site.VS);
+            double FAC5 = GaussianFactor(SGZ, Z, _link.H(), _meteo.MIXH);
+            return FACT * (FAC5 - FAC3);
+        }
+    }
+
+    double Plume::DepositionFactor(double SGZ, double KZ, double Z, double H, double V1) const
+    {
+        double FAC3 = 0.0;
+        if (V1 != 0.0)
+        {
+            double ARG = (V1 * SGZ / KZ + (Z + H) / SGZ) / SQRT_2;
+            if (ARG > 5.0)
+            {
+                FAC3 = std::nan("");
+            }
+            else
+            {
+                FAC3 =
+                    SQRT_2PI * V1 * SGZ
+                    * std::exp(V1 * (Z + H) / KZ + 0.5 * (V1 * SGZ / KZ) * (V1 * SGZ / KZ))
+                    * Erf(ARG)
+                    / KZ;
+
+                if (FAC3 > 2.0) FAC3 = 2.0;
+            }
+        }
+        return FAC3;
+    }
+
+    double Plume::SettlingFactor(double SGZ, double KZ, double Z, double H, double VS) const
+    {
+        return (VS == 0.0) ? 1.0 : std::exp(-VS * (Z - H) / (2.0 * KZ) - (VS * SGZ / KZ) * (VS * SGZ / KZ) / 8.0);
+    }
+
+    double Plume::GaussianFactor(double SGZ, double Z, double H, double MIXH) const
+    {
+        double FAC5 = 0.0;
+        double CNT = 0.0;
+        double EXLS = 0.0;
+        while (true)
+        {
+            double ARG1 = -0.5 * ((Z + H + 2.0 * CNT * MIXH) / SGZ) * ((Z + H + 2.0 * CNT * MIXH) / SGZ);
+            double EXP1 = (ARG1 < -44.0) ? 0.0 : std::exp(ARG1);
+
+            double ARG2 = -0.5 * ((Z - H + 2.0 * CNT * MIXH) / SGZ) * ((Z - H + 2.0 * CNT * MIXH) / SGZ);
+            double EXP2 = (ARG2 < -44.0) ? 0.0 : std::exp(ARG2);
+
+            FAC5 += EXP1 + EXP2;
+
+            if (MIXH >= MAX_MIXH)
+                break;
+
+            if (((EXP1 + EXP2 + EXLS) == 0.0) && (CNT <= 0.0))
+                break;
+
+            if (CNT <= 0.0)
+            {
+                CNT = std::abs(CNT) + 1.0;
+                EXLS = 0.0;
+            }
+            else
+            {
+                CNT = -1.0 * CNT;
+                EXLS = EXP1 + EXP2;
+            }
+        }
+        return FAC5;
+    }
+}
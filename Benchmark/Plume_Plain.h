@@ -0,0 +1,126 @@
+#ifndef PLUME_PLAIN_H
+#define PLUME_PLAIN_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+/*
+ * Plain-double twin of the CALINE3 plume path (Maths, Link, WindFlow, LinkElement, Plume):
+ * the same formulas, evaluated in the same order, on ordinary numbers instead of units
+ * of measure. Unit conversions are spelled out as the unit factor ratios Metrology uses.
+ * Units: [m], [s], [deg]/[rad], [cm/s] on input, [microgram] as in the measured code.
+ */
+namespace CALINE3::Plain
+{
+    /// @brief Degree/Radian unit factor.
+    constexpr double DEGREES = 57.29577951308232;
+
+    double Azimuth(double a, double b, double x, double y);
+    double Distance(double x1, double y1, double x2, double y2);
+    double Erf(double x);
+
+    /// @brief Erf arguments produced by LinkElement::SourceStrength are appended here (if not nullptr).
+    extern std::vector<double> *ErfTrace;
+
+    struct Site
+    {
+        const double VS;    // [m/s]
+        const double V1;    // [m/s]
+        const double AFAC_3MIN_02;
+        const double AFAC_30MIN_02;
+        const double RFAC_3CM_02;
+        const double RFAC_3CM_007;
+        const double RFAC_10CM_007;
+
+        /**
+         * @param atim - averaging time [min], z0 - surface roughness [cm],
+         * @param vs - settling velocity [cm/s], vd - deposition velocity [cm/s].
+         */
+        Site(double atim, double z0, double vs, double vd);
+    };
+
+    struct Meteo
+    {
+        const double U;     // [m/s]
+        const double BRG;   // [deg] (vector orientation)
+        const int CLAS;
+        const double MIXH;  // [m]
+
+        Meteo(double u, double brg, int clas, double mixh);
+
+        double AY1() const;
+        double AY2() const;
+        double AZ() const;
+    };
+
+    struct Link
+    {
+        const double XL1, YL1, XL2, YL2, HL, WL;    // [m]
+
+        /**
+         * @param typ - link type, vphl - traffic volume [vehicles/hour], efl - emission factor [g/mile],
+         * @param other - [m].
+         */
+        Link(const std::string& typ, double xl1, double yl1, double xl2, double yl2, double vphl, double efl, double hl, double wl);
+
+        double H() const { return m_h; }
+        double LL() const { return m_ll; }
+        double LBRG() const { return m_lbrg; }
+        double W2() const { return m_w2; }
+        double Q1() const { return m_q1; }
+        double DSTR() const { return m_dstr; }
+
+        void TransformReceptorCoordinates(double XR, double YR, double ZR, double& D, double& L, double& Z) const;
+        double DepressedSectionFactor(double D) const;
+
+    private:
+        double m_ll, m_h, m_w2, m_hds, m_dstr, m_lbrg, m_q1;
+        bool m_slope;
+    };
+
+    struct WindFlow
+    {
+        WindFlow(const Meteo& meteo, const Link& link);
+
+        double BASE() const { return m_base; }
+        double PHI() const { return m_phi; }
+        double TETA() const { return m_teta; }
+
+    private:
+        double m_base, m_phi, m_teta;
+    };
+
+    struct LinkElement
+    {
+        const Link& master;
+        const WindFlow& flow;
+        const double EL2, ECLD, ELL2, CSL2, EM2, EN2;
+
+        LinkElement(const Link& master, const WindFlow& flow, double ED1, double ED2);
+
+        bool GetProfile(double D, double& QE, double& YE, double& FET) const;
+        double SourceStrength(double QE, double SGY, double YE) const;
+    };
+
+    struct Plume
+    {
+        Plume(const Site& site, const Meteo& meteo, const Link& link);
+
+        /// @returns concentration [microgram/m3].
+        double ConcentrationAt(double XR, double YR, double ZR) const;
+
+    private:
+        double ConcentrationFrom(const LinkElement& element, double D, double Z) const;
+        double DepositionFactor(double SGZ, double KZ, double Z, double H, double V1) const;
+        double SettlingFactor(double SGZ, double KZ, double Z, double H, double VS) const;
+        double GaussianFactor(double SGZ, double Z, double H, double MIXH) const;
+
+        const Site& _site;
+        const Meteo& _meteo;
+        const Link& _link;
+        const WindFlow _flow;
+        double PY1, PY2, PZ1, PZ2;
+    };
+}
+#endif /* !PLUME_PLAIN_H */
@@ -0,0 +1,179 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Engine.h"
+#include "Workload.h"
+
+using namespace CALINE3;
+using namespace CALINE3::Metrology;
+
+/*
+ * Thread scaling of the Engine, for each matrix partition (Engine::Partition):
+ *  - strong scaling: the same job on 1, 2, 4, ... threads (speedup = T1 / TN),
+ *  - weak scaling: the job grows with the threads (links = LINKS_PER_THREAD x N; scaled speedup = N x T1 / TN),
+ * with efficiency = speedup / N and the mean idle time per thread (wall time less the time it spent on tasks).
+ *
+ * Threads are doubled up to the hardware concurrency (at least 2), or to CALINE3_SCALING_THREADS if set
+ * (e.g. CALINE3_SCALING_THREADS=128); wall times are the best of REPEAT runs.
+ */
+
+namespace
+{
+    constexpr std::size_t STRONG_LINKS = 192;
+    constexpr std::size_t LINKS_PER_THREAD = 32;
+    constexpr std::size_t RECEPTORS = 160;
+    constexpr std::size_t METEOS = 2;
+    constexpr int REPEAT = 3;
+
+    const char *PARTITION_NAME[] = { "links", "receptor blocks" };
+
+    struct Run
+    {
+        double Wall;    /// Wall time [s] (best of REPEAT).
+        double Idle;    /// Mean idle time per thread [s] (in the best run).
+    };
+
+    std::size_t MaxThreads()
+    {
+        if (const char *threads = std::getenv("CALINE3_SCALING_THREADS"))
+            return std::max<std::size_t>(1, std::stoul(threads));
+        return std::max(2u, std::thread::hardware_concurrency());
+    }
+
+    Job Generate(std::size_t links)
+    {
+        WorkloadSpec spec;
+        spec.Links = links;
+        spec.Receptors = RECEPTORS;
+        spec.Meteos = METEOS;
+        spec.Geometry = Layout::Grid;
+        spec.Types = { "AG", "BR", "FL", "DP" };
+        spec.MixingHeights = { 1000.0, 300.0 };
+        spec.Seed = 11;
+        return Workload{ spec }.Generate();
+    }
+
+    Run Measure(const Job& job, std::size_t threads, Partition partition, std::vector<ConcentrationMatrix>& MC)
+    {
+        // A single thread computes serially (the baseline):
+        std::unique_ptr<ThreadPool> pool;
+        if (threads > 1)
+            pool = std::make_unique<ThreadPool>(threads);
+        const Engine engine{ pool.get(), partition };
+
+        MC.resize(job.Meteos.size());
+        Run best{ 0.0, 0.0 };
+        for (int r = 0; r < REPEAT; r++)
+        {
+            if (pool)
+                pool->ResetBusyTimes();
+
+            auto start = std::chrono::steady_clock::now();
+            for (auto const& meteo : job.Meteos)
+            {
+                engine.Compute(job, meteo, MC[meteo.ORDINAL]);
+            }
+            double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            double idle = 0.0;
+            if (pool)
+            {
+                for (auto busy : pool->BusyTimes())
+                {
+                    idle += std::max(0.0, wall - std::chrono::duration<double>(busy).count());
+                }
+                idle /= static_cast<double>(threads);
+            }
+            if ((r == 0) || (wall < best.Wall))
+                best = Run{ wall, idle };
+        }
+        return best;
+    }
+
+    void Header(const char *title)
+    {
+        std::cout << std::endl << title << std::endl
+            << std::left << std::setw(17) << "partition" << std::right
+            << std::setw(8) << "threads" << std::setw(8) << "links" << std::setw(10) << "receptors"
+            << std::setw(12) << "wall [ms]" << std::setw(10) << "speedup" << std::setw(12) << "efficiency"
+            << std::setw(12) << "idle [ms]" << std::setw(9) << "idle %" << std::endl;
+    }
+
+    void Row(Partition partition, std::size_t threads, const Job& job, const Run& run, double speedup)
+    {
+        std::cout << std::fixed << std::left << std::setw(17) << PARTITION_NAME[static_cast<int>(partition)] << std::right
+            << std::setw(8) << threads << std::setw(8) << job.Links.size() << std::setw(10) << job.Receptors.size()
+            << std::setw(12) << std::setprecision(2) << run.Wall * 1e3
+            << std::setw(10) << std::setprecision(2) << speedup
+            << std::setw(11) << std::setprecision(1) << 100.0 * speedup / static_cast<double>(threads) << "%"
+            << std::setw(12) << std::setprecision(2) << run.Idle * 1e3
+            << std::setw(8) << std::setprecision(1) << 100.0 * run.Idle / run.Wall << "%" << std::endl;
+    }
+}
+
+TEST_CASE("Scaling", "[!benchmark]")
+{
+    const std::size_t max_threads = MaxThreads();
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t n = 1; n < max_threads; n *= 2)
+    {
+        thread_counts.push_back(n);
+    }
+    thread_counts.push_back(max_threads);
+
+    const Partition partitions[] = { Partition::Links, Partition::ReceptorBlocks };
+
+    SECTION("strong")
+    {
+        const Job job = Generate(STRONG_LINKS);
+        std::vector<ConcentrationMatrix> serial;
+        std::vector<ConcentrationMatrix> MC;
+        const Run base = Measure(job, 1, Partition::Links, serial);
+
+        Header("Strong scaling (fixed job):");
+        for (Partition partition : partitions)
+        {
+            for (std::size_t threads : thread_counts)
+            {
+                const Run run = (threads == 1) ? base : Measure(job, threads, partition, MC);
+                Row(partition, threads, job, run, base.Wall / run.Wall);
+
+                // The partition must not change the results (bit for bit):
+                if (threads > 1)
+                    CHECK(MC == serial);
+            }
+        }
+    }
+
+    SECTION("weak")
+    {
+        const Job unit = Generate(LINKS_PER_THREAD);
+        std::vector<ConcentrationMatrix> MC;
+        const Run base = Measure(unit, 1, Partition::Links, MC);
+
+        Header("Weak scaling (links grow with threads):");
+        for (Partition partition : partitions)
+        {
+            for (std::size_t threads : thread_counts)
+            {
+                if (threads == 1)
+                {
+                    Row(partition, threads, unit, base, 1.0);
+                    continue;
+                }
+                const Job job = Generate(LINKS_PER_THREAD * threads);
+                const Run run = Measure(job, threads, partition, MC);
+                Row(partition, threads, job, run, static_cast<double>(threads) * base.Wall / run.Wall);
+            }
+        }
+    }
+}
@@ -14,90 +14,504 @@
 
 ********************************************************************************/
 
+#include <cctype>
 #include <clocale>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
 
+#include "Counters.h"
+#include "Daemon.h"
+#include "Engine.h"
 #include "JobReader.h"
-#include "Plume.h"
+#include "LinkMerge.h"
+#include "Memory.h"
+#include "PerfCounters.h"
+#include "Phases.h"
 #include "Report.h"
+#include "ResultStore.h"
+#include "Roads.h"
+#include "ThreadPool.h"
+#include "Throughput.h"
+#include "Trace.h"
 
 using namespace CALINE3;
 
 // Elapsed time (in microseconds)
 using elapsed_t = std::chrono::duration<double, std::micro>;
 
+/**
+ * @brief Parses the number of threads given with an option (0 = number of hardware threads).
+ * @return @c true on success, @c false otherwise (error reported).
+ */
+static bool threads_arg(const char *option, const char *value, std::size_t &count)
+{
+    try
+    {
+        std::size_t pos;
+        count = std::stoul(value, &pos);
+        if (value[pos] == '\0')
+            return true;
+    }
+    catch (std::logic_error const&)
+    {
+    }
+    std::cerr << option << value << ": invalid number of threads." << std::endl;
+    return false;
+}
+
 int main(int argc, char* argv[])
 {
-    if (argc < 2)
+    const char *input_path = nullptr;   // input data file
+    const char *store_path = nullptr;   // binary result file (optional)
+    const char *parse_threads = nullptr;// number of parser threads (optional)
+    const char *threads = nullptr;      // number of compute threads (optional)
+    const char *daemon_path = nullptr;  // daemon socket path or "-" for stdin/stdout (optional)
+    const char *max_request = nullptr;  // daemon limit of the RUN input data length [bytes, K|M|G suffix] (optional)
+    const char *max_connections = nullptr;  // daemon limit of the connections served at once (optional)
+    bool benchmark = false;             // end-to-end throughput benchmark (optional)
+    const char *erf = nullptr;          // error function variant (optional)
+    const char *sum = nullptr;          // element summation (optional)
+    bool shared = false;                // shared dispersion of links differing in emission only (optional)
+    bool merge = false;                 // contiguous collinear links merged (optional)
+    const char *roads_path = nullptr;   // road network polylines appended to the links of each job (optional)
+    const char *counters = nullptr;     // hot path counters format: json|text (optional)
+    const char *phases = nullptr;       // phase times format: table|json (optional)
+    const char *trace_path = nullptr;   // Chrome trace-event file (optional)
+    bool perf = false;                  // hardware performance counters (optional)
+    const char *memory = nullptr;       // memory usage format: table|json (optional)
+    const char *budget = nullptr;       // memory budget [bytes, K|M|G suffix] (optional)
+
+    bool valid = true;
+    for (int i = 1; valid && (i < argc); i++)
     {
+        if (std::strncmp(argv[i], "--store=", 8) == 0)
+            store_path = argv[i] + 8;
+        else if (std::strncmp(argv[i], "--parse-threads=", 16) == 0)
+            parse_threads = argv[i] + 16;
+        else if (std::strncmp(argv[i], "--threads=", 10) == 0)
+            threads = argv[i] + 10;
+        else if (std::strncmp(argv[i], "--daemon=", 9) == 0)
+            daemon_path = argv[i] + 9;
+        else if (std::strncmp(argv[i], "--max-request=", 14) == 0)
+            max_request = argv[i] + 14;
+        else if (std::strncmp(argv[i], "--max-connections=", 18) == 0)
+            max_connections = argv[i] + 18;
+        else if (std::strcmp(argv[i], "--benchmark") == 0)
+            benchmark = true;
+        else if (std::strncmp(argv[i], "--erf=", 6) == 0)
+            erf = argv[i] + 6;
+        else if (std::strncmp(argv[i], "--sum=", 6) == 0)
+            sum = argv[i] + 6;
+        else if (std::strcmp(argv[i], "--shared-dispersion") == 0)
+            shared = true;
+        else if (std::strcmp(argv[i], "--merge-links") == 0)
+            merge = true;
+        else if ((std::strncmp(argv[i], "--roads=", 8) == 0) && argv[i][8])
+            roads_path = argv[i] + 8;
+        else if ((std::strcmp(argv[i], "--counters=json") == 0) || (std::strcmp(argv[i], "--counters=text") == 0))
+            counters = argv[i] + 11;
+        else if ((std::strcmp(argv[i], "--phases=table") == 0) || (std::strcmp(argv[i], "--phases=json") == 0))
+            phases = argv[i] + 9;
+        else if ((std::strncmp(argv[i], "--trace=", 8) == 0) && argv[i][8])
+            trace_path = argv[i] + 8;
+        else if (std::strcmp(argv[i], "--perf") == 0)
+            perf = true;
+        else if ((std::strcmp(argv[i], "--memory=table") == 0) || (std::strcmp(argv[i], "--memory=json") == 0))
+            memory = argv[i] + 9;
+        else if (std::strncmp(argv[i], "--memory-budget=", 16) == 0)
+            budget = argv[i] + 16;
+        else if (((argv[i][0] != '-') || (std::strcmp(argv[i], "-") == 0)) && !input_path)
+            input_path = argv[i];
+        else
+            valid = false;
+    }
+
+    if (!valid || (!input_path == !daemon_path) || (benchmark && (daemon_path || store_path)) || (counters && (daemon_path || benchmark)) || (phases && daemon_path) || (trace_path && daemon_path) || (perf && daemon_path) || ((memory || budget) && (daemon_path || benchmark)) || (budget && store_path) || ((merge || roads_path) && (daemon_path || benchmark)) || ((max_request || max_connections) && !daemon_path))
+    {
+        const char *app = argv[0] ? argv[0] : "CALINE3";
         std::cerr
             << "Missing or invalid command line arguments"
             << std::endl
-            << "Usage: " << (argv[0] ? argv[0] : "CALINE3") << " /path/to/input.data"
+            << "Usage: " << app << " [--store=/path/to/results.c3r] [--parse-threads=N] [--threads=N] [--erf=as|std|fast|vector] [--sum=sequential|pairwise|compensated] [--shared-dispersion] [--merge-links] [--roads=/path/to/roads.txt] [--counters=json|text] [--phases=table|json] [--trace=/path/to/trace.json] [--perf] [--memory=table|json] [--memory-budget=BYTES[K|M|G]] /path/to/input.data|-"
+            << std::endl
+            << "       " << app << " [--threads=N] [--erf=VARIANT] [--sum=SUMMATION] [--shared-dispersion] [--max-request=BYTES[K|M|G]] [--max-connections=N] --daemon=/path/to/caline3.sock|-"
+            << std::endl
+            << "       " << app << " --benchmark [--parse-threads=N] [--threads=N] [--erf=VARIANT] [--sum=SUMMATION] [--shared-dispersion] [--phases=table|json] [--trace=FILE] [--perf] /path/to/input.data|-"
             << std::endl;
         return 1;
     }
 
+#ifndef CALINE3_COUNTERS
+    if (counters)
+    {
+        std::cerr << "--counters=" << counters << ": hot path counters not compiled in (build with -DCALINE3_COUNTERS=ON)." << std::endl;
+        return 1;
+    }
+#endif
+
+    // Phase times (parse, plume setup, elements, report; wait apart) per job:
+    PhaseLog::Enable(phases != nullptr);
+    auto print_phases = [phases]()
+    {
+        if (phases && (std::strcmp(phases, "json") == 0))
+            PhaseLog::Global().PrintJSON(std::cerr);
+        else if (phases)
+            PhaseLog::Global().PrintTable(std::cerr);
+    };
+
+    // Execution timeline (reader, compute tasks, plumes, writer spans per thread):
+    TraceRecorder::Enable(trace_path != nullptr);
+    if (trace_path)
+        TraceRecorder::Global().NameThread("main");
+    auto write_trace = [trace_path]()
+    {
+        if (!trace_path)
+            return true;
+        std::ofstream os{ trace_path };
+        TraceRecorder::Global().WriteJSON(os);
+        if (!os.flush())
+        {
+            std::cerr << trace_path << ": failed to write the trace." << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    // Hardware counters (IPC, cache and branch miss rates) per stage, if the machine lets us:
+    if (perf && !PerfCounters::Enable())
+        std::cerr << "--perf: " << PerfCounters::Status() << "; not counting." << std::endl;
+    else if (perf && !PerfCounters::Status().empty())
+        std::cerr << "--perf: " << PerfCounters::Status() << "." << std::endl;
+
+    // Memory budget: jobs whose concentration matrix would not fit are computed and reported in tiles of receptors:
+    if (budget)
+    {
+        try
+        {
+            Memory::SetBudget(Memory::ParseBytes(budget));
+        }
+        catch (std::invalid_argument const& ex)
+        {
+            std::cerr << "--memory-budget=" << budget << ": " << ex.what() << std::endl;
+            return 1;
+        }
+    }
+
     // Locale required to read standard input file (CALINE3.EXP) and 
     // print results comparable to standard output file (CALINE3.LST):
     std::setlocale(LC_ALL, "en_US.UTF-8");
 
-    std::ifstream input(argv[1], std::ios::in);
-    if (!input.is_open())
+    // Concentrations computed serially or spread over a pool of compute threads:
+    std::unique_ptr<ThreadPool> compute_pool;
+    if (threads)
     {
-        std::cerr << argv[1] << ": failed to open." << std::endl;
-        return 2;
+        std::size_t count;
+        if (!threads_arg("--threads=", threads, count))
+            return 1;
+        compute_pool = std::make_unique<ThreadPool>(count);
     }
+    // Math functions (the original CALINE3 ones by default):
+    MathPolicy policy;
+    if (erf)
+    {
+        try
+        {
+            policy.Erf = Maths::ParseErfVariant(erf);
+        }
+        catch (std::invalid_argument const& ex)
+        {
+            std::cerr << "--erf=" << erf << ": " << ex.what() << std::endl;
+            return 1;
+        }
+    }
+    if (sum)
+    {
+        try
+        {
+            policy.Sum = Maths::ParseSummation(sum);
+        }
+        catch (std::invalid_argument const& ex)
+        {
+            std::cerr << "--sum=" << sum << ": " << ex.what() << std::endl;
+            return 1;
+        }
+    }
+    policy.SharedDispersion = shared;
+    const Engine engine{ compute_pool.get(), Partition::Links, 0, policy };
+
+    // Daemon mode (the engine stays warm between requests):
+    if (daemon_path)
+    {
+        std::size_t limit = Daemon::MAX_REQUEST;
+        if (max_request)
+        {
+            try
+            {
+                limit = Memory::ParseBytes(max_request);
+            }
+            catch (std::invalid_argument const& ex)
+            {
+                std::cerr << "--max-request=" << max_request << ": " << ex.what() << std::endl;
+                return 1;
+            }
+        }
+        std::size_t connections = Daemon::MAX_CONNECTIONS;
+        if (max_connections)
+        {
+            char *end;
+            connections = std::strtoul(max_connections, &end, 10);
+            if ((*end != '\0') || (connections == 0) || !std::isdigit(static_cast<unsigned char>(*max_connections)))
+            {
+                std::cerr << "--max-connections=" << max_connections << ": invalid number of connections (1 or more expected)." << std::endl;
+                return 1;
+            }
+        }
+        Daemon daemon{ engine, limit, connections };
+        if (std::strcmp(daemon_path, "-") != 0)
+            return daemon.Listen(daemon_path);
 
-    JobReader rdr{ argv[1], input };
+        std::ios::sync_with_stdio(false);
+        daemon.Serve(std::cin, std::cout);
+        return 0;
+    }
+
+    // Input file or standard input ("-"):
+    std::ifstream file;
+    if (std::strcmp(input_path, "-") == 0)
+    {
+        std::ios::sync_with_stdio(false);
+        input_path = "stdin";
+    }
+    else
+    {
+        file.open(input_path, std::ios::in);
+        if (!file.is_open())
+        {
+            std::cerr << input_path << ": failed to open." << std::endl;
+            return 2;
+        }
+    }
+    std::istream& input = file.is_open() ? static_cast<std::istream&>(file) : std::cin;
+
+    // Jobs parsed serially or concurrently (on a pool of parser threads):
+    std::unique_ptr<ThreadPool> parser_pool;
+    if (parse_threads)
+    {
+        std::size_t count;
+        if (!threads_arg("--parse-threads=", parse_threads, count))
+            return 1;
+        parser_pool = std::make_unique<ThreadPool>(count);
+    }
+
+    // End-to-end throughput benchmark (input read into memory first, report rendered to memory):
+    if (benchmark)
+    {
+        const std::string data{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+        Throughput throughput{ engine };
+        bool ok = throughput.Run(input_path, data, parser_pool.get());
+        throughput.PrintJSON(std::cout);
+        print_phases();
+        if (PerfCounters::Enabled())
+        {
+            std::cerr << "Hardware counters: ";
+            PerfCounters::PrintRates(std::cerr, PerfCounters::Total());
+            std::cerr << std::endl;
+        }
+        if (!write_trace())
+            return 2;
+        return ok ? 0 : 3;
+    }
+
+    // Binary (indexed) result file:
+    std::unique_ptr<ResultStore::Writer> store;
+    if (store_path)
+    {
+        try
+        {
+            store = std::make_unique<ResultStore::Writer>(store_path);
+        }
+        catch (std::runtime_error const& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            return 2;
+        }
+    }
+
+    // Road network (polylines segmented into links on the parser or compute threads):
+    std::vector<Link> roads;
+    if (roads_path)
+    {
+        std::ifstream network{ roads_path };
+        if (!network.is_open())
+        {
+            std::cerr << roads_path << ": failed to open." << std::endl;
+            return 2;
+        }
+        const RoadStats stats = RoadNetwork::Read(roads_path, network, parser_pool ? parser_pool.get() : compute_pool.get(), roads, std::cerr);
+        RoadNetwork::PrintSummary(std::cerr, stats);
+        if (stats.Error)
+            return 3;
+    }
+
+    std::unique_ptr<JobReader> reader;
+    if (parser_pool)
+    {
+        reader = std::make_unique<JobReader>(input_path, input, *parser_pool);
+    }
+    else
+    {
+        reader = std::make_unique<JobReader>(input_path, input);
+    }
+    JobReader& rdr = *reader;
     Report report{std::cout};
 
+    // Timings are printed in the format once left behind by the report:
+    std::cout << std::fixed << std::setprecision(1);
+
     // Total calculation time:
     elapsed_t total_elapsed{ 0.0 };
 
-    while (rdr.Read())
+    /// Mass concentration matrix (storage reused from one meteo to the next)
+    ConcentrationMatrix MC;
+
+    // Hardware counts at the end of the previous job (parsing the next one counts towards it):
+    StageCounts job_counts = PerfCounters::Total();
+
+    // Jobs are read one at a time (only the current one is kept in memory):
+    for (auto const& parsed : rdr)
     {
-        auto& site = rdr.LastJob();
+        // Road network links appended:
+        std::optional<Job> extended;
+        if (!roads.empty())
+            extended.emplace(RoadNetwork::Attach(parsed, roads));
+        const Job& job = extended ? *extended : parsed;
+
+        // Contiguous collinear links merged (reported per merged group):
+        std::optional<Job> merged;
+        if (merge)
+        {
+            std::vector<LinkGroup> groups;
+            merged.emplace(LinkMerger::Merge(job, groups));
+            LinkMerger::PrintSummary(std::cerr, job, groups);
+        }
+        const Job& site = merged ? *merged : job;
 
         // Job calculation time:
         elapsed_t job_elapsed{ 0.0 };
 
+        // Job memory peaks:
+        Memory::BeginWindow();
+
+        // Receptors per tile if the matrix does not fit the memory budget (0 = matrix computed whole):
+        std::size_t tile = 0;
+        if (!Memory::Fits(Engine::MatrixBytes(site.Links.size(), site.Receptors.size())))
+        {
+            ConcentrationMatrix().swap(MC);     // (storage of the previous job given back first)
+            tile = Engine::TileFor(site.Links.size(), site.Receptors.size(), Memory::Available());
+            if (tile >= site.Receptors.size())
+                tile = 0;
+        }
+
         for(auto const &meteo : site.Meteos)
         {
             const auto start_time = std::chrono::steady_clock::now();
 
-            /// Mass concentration matrix
-            std::vector<std::vector<Microgram_Meter3>> MC{ site.Links.size() };
-
-            for(auto const &link : site.Links)
+            if (tile)
             {
-                Plume plume(site, meteo, link);
-                MC[link.ORDINAL] = std::vector<Microgram_Meter3>( site.Receptors.size() );
-
-                for(auto const &receptor : site.Receptors)
-                {
-                    MC[link.ORDINAL][receptor.ORDINAL] = plume.ConcentrationAt(receptor);
-                }
+                // Streaming execution: tiles reported as soon as computed (report time excluded):
+                elapsed_t reporting{ 0.0 };
+                report.Print(site, meteo, [&](const Report::TileSink& sink) {
+                    engine.Stream(site, meteo, tile, MC, [&](const ConcentrationMatrix& part, std::size_t rfirst, std::size_t rlast) {
+                        const auto report_time = std::chrono::steady_clock::now();
+                        sink(part, rfirst, rlast);
+                        reporting += std::chrono::steady_clock::now() - report_time;
+                    });
+                });
+                job_elapsed += std::chrono::steady_clock::now() - start_time;
+                job_elapsed -= reporting;
+                continue;
             }
 
+            engine.Compute(site, meteo, MC);
+
             job_elapsed += std::chrono::steady_clock::now() - start_time;
 
             report.Print(site, meteo, MC);
+
+            if (store) store->Append(site, meteo, MC);
         }
 
+        if (memory)
+            MemoryLog::Global().Add(site.ORDINAL, MemoryLog::Entry{ site.JOB, Memory::Window(), tile });
+
         total_elapsed += job_elapsed;
+        Timing::Flush(site.ORDINAL, site.JOB);
 
         std::cout
             << std::endl
             << "Job computation time (excl. I/O): " << job_elapsed.count() << " us"
             << " :: " << site.JOB << " :: " << site.RUN
-            << std::endl
-            << std::endl
-        ;
+            << std::endl;
+
+        if (PerfCounters::Enabled())
+        {
+            const StageCounts counts = PerfCounters::Total();
+            std::cout << "Job hardware counters: ";
+            PerfCounters::PrintRates(std::cout, counts - job_counts);
+            std::cout << std::endl;
+            job_counts = counts;
+        }
+        std::cout << std::endl;
     }
 
     std::cout << "Total computation time (excl. I/O): " << total_elapsed.count() << " us." << std::endl;
 
+    if (PerfCounters::Enabled())
+    {
+        std::cout << "Total hardware counters: ";
+        PerfCounters::PrintRates(std::cout, PerfCounters::Total());
+        std::cout << std::endl;
+    }
+
+    print_phases();
+
+    if (!write_trace())
+        return 2;
+
+    // Memory peaks per job and subsystem:
+    if (memory && (std::strcmp(memory, "json") == 0))
+        MemoryLog::Global().PrintJSON(std::cerr);
+    else if (memory)
+        MemoryLog::Global().PrintTable(std::cerr);
+
+    // Hot path counts per job/meteo/link (to the standard error, not to mix with the report):
+    if (counters)
+    {
+        if (std::strcmp(counters, "json") == 0)
+            CounterLog::Global().PrintJSON(std::cerr);
+        else
+            CounterLog::Global().PrintText(std::cerr);
+    }
+
+    if (store)
+    {
+        try
+        {
+            store->Close();
+        }
+        catch (std::runtime_error const& ex)
+        {
+            std::cerr << store_path << ": " << ex.what() << std::endl;
+            return 4;
+        }
+    }
+
     return rdr.ErrorFound() ? 3 : 0;
 }
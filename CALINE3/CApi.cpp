@@ -0,0 +1,344 @@
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CApi.h"
+#include "Engine.h"
+
+using namespace CALINE3;
+
+static_assert((CALINE3_AG == int(Link::AG)) && (CALINE3_BR == int(Link::BR)) && (CALINE3_FL == int(Link::FL)) && (CALINE3_DP == int(Link::DP)),
+    "C API type codes must match Link::TypeCode.");
+
+/**
+ * @brief Session state behind the opaque C handle.
+ */
+struct caline3_session
+{
+    std::unique_ptr<ThreadPool> pool;           /// Compute threads (if any).
+    Engine engine;                              /// Engine (using the pool).
+    std::optional<Job> site;                    /// Current site.
+    std::vector<ConcentrationMatrix> results;   /// Results (per meteo).
+    bool evaluated;                             /// Results up to date?
+    std::string error;                          /// Last error message.
+
+    explicit caline3_session(unsigned threads)
+        : pool((threads == 1) ? nullptr : std::make_unique<ThreadPool>(threads)),
+          engine(pool.get()), site(), results(), evaluated(false), error()
+    {
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////
+///
+///      Helpers
+///
+
+/**
+ * @brief Call out of order (reported as CALINE3_INVALID_STATE).
+ */
+struct invalid_state : std::logic_error
+{
+    using std::logic_error::logic_error;
+};
+
+/**
+ * @brief Runs an API call body, translating exceptions into status codes.
+ */
+template<typename F>
+static caline3_status guarded(caline3_session *session, F&& body)
+{
+    if (!session)
+        return CALINE3_INVALID_ARGUMENT;
+
+    try
+    {
+        session->error.clear();
+        return body(*session);
+    }
+    catch (invalid_state const& ex)
+    {
+        session->error = ex.what();
+        return CALINE3_INVALID_STATE;
+    }
+    catch (std::invalid_argument const& ex)
+    {
+        session->error = ex.what();
+        return CALINE3_INVALID_ARGUMENT;
+    }
+    catch (std::exception const& ex)
+    {
+        session->error = ex.what();
+        return CALINE3_ERROR;
+    }
+    catch (...)
+    {
+        session->error = "unknown error.";
+        return CALINE3_ERROR;
+    }
+}
+
+/**
+ * @brief Fails unless a site has been created.
+ */
+static Job &site_of(caline3_session &s)
+{
+    if (!s.site)
+        throw invalid_state("no site created.");
+    return *s.site;
+}
+
+/**
+ * @brief Validates meteo conditions.
+ */
+static void validate(const caline3_meteo &m)
+{
+    if ((m.clas < 1) || (6 < m.clas))
+        throw std::invalid_argument("stability class " + std::to_string(m.clas) + " not within 1..6.");
+    if (!(m.u > 0.0))
+        throw std::invalid_argument("wind speed must be positive.");
+}
+
+static std::string text(const char *s)
+{
+    return s ? std::string(s) : std::string();
+}
+
+////////////////////////////////////////////////////////////////////////////
+///
+///      API
+///
+
+extern "C"
+{
+    caline3_session *caline3_session_create(unsigned threads)
+    {
+        try
+        {
+            return new caline3_session(threads);
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+    }
+
+    void caline3_session_destroy(caline3_session *session)
+    {
+        delete session;
+    }
+
+    const char *caline3_last_error(const caline3_session *session)
+    {
+        return session ? session->error.c_str() : "no session.";
+    }
+
+    caline3_status caline3_site_create(caline3_session *session, const char *job, double atim, double z0, double vs, double vd)
+    {
+        return guarded(session, [&](caline3_session &s)
+        {
+            if (!(atim > 0.0) || !(z0 > 0.0))
+                throw std::invalid_argument("averaging time and surface roughness must be positive.");
+
+            s.site.reset();
+            s.results.clear();
+            s.evaluated = false;
+            s.site.emplace(
+                /*ORDINAL*/ 0,
+                /*JOB*/     text(job),
+                /*ATIM*/    Minute(atim),
+                /*Z0*/      Centimeter(z0),
+                /*VS*/      Centimeter_Sec(vs),
+                /*VD*/      Centimeter_Sec(vd),
+                /*NR*/      0,
+                /*SCAL*/    1.0
+            );
+            return CALINE3_OK;
+        });
+    }
+
+    caline3_status caline3_add_receptors(caline3_session *session, const caline3_receptor *receptors, size_t count)
+    {
+        return guarded(session, [&](caline3_session &s)
+        {
+            Job &site = site_of(s);
+            if (!receptors && count)
+                throw std::invalid_argument("receptors: null pointer.");
+
+            site.Receptors.reserve(site.Receptors.size() + count);
+            for (size_t i = 0; i < count; i++)
+            {
+                const caline3_receptor &r = receptors[i];
+                site.Receptors.emplace_back(site.Receptors.size(), text(r.name), Meter(r.xr), Meter(r.yr), Meter(r.zr));
+            }
+            s.evaluated = false;
+            return CALINE3_OK;
+        });
+    }
+
+    caline3_status caline3_add_links(caline3_session *session, const caline3_link *links, size_t count)
+    {
+        return guarded(session, [&](caline3_session &s)
+        {
+            Job &site = site_of(s);
+            if (!links && count)
+                throw std::invalid_argument("links: null pointer.");
+
+            // Validate all the links before adding any:
+            std::vector<Link> added;
+            added.reserve(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                const caline3_link &l = links[i];
+                const std::string type = text(l.type);
+                if ((type != "AG") && (type != "BR") && (type != "FL") && (type != "DP"))
+                    throw std::invalid_argument("link type \"" + type + "\" not one of AG, BR, FL, DP.");
+
+                added.emplace_back(
+                    site.Links.size() + i, text(l.name), type,
+                    Meter(l.xl1), Meter(l.yl1), Meter(l.xl2), Meter(l.yl2),
+                    Vehicles_Hour(l.vphl), Gram_Mile(l.efl), Meter(l.hl), Meter(l.wl)
+                );
+            }
+
+            site.Links.reserve(site.Links.size() + count);
+            for (auto& link : added)
+            {
+                site.Links.push_back(std::move(link));
+            }
+            s.evaluated = false;
+            return CALINE3_OK;
+        });
+    }
+
+    caline3_status caline3_add_meteos(caline3_session *session, const caline3_meteo *meteos, size_t count)
+    {
+        return guarded(session, [&](caline3_session &s)
+        {
+            Job &site = site_of(s);
+            if (!meteos && count)
+                throw std::invalid_argument("meteos: null pointer.");
+
+            for (size_t i = 0; i < count; i++)
+            {
+                validate(meteos[i]);
+            }
+
+            site.Meteos.reserve(site.Meteos.size() + count);
+            for (size_t i = 0; i < count; i++)
+            {
+                const caline3_meteo &m = meteos[i];
+                site.Meteos.emplace_back(site.Meteos.size(), Meter_Sec(m.u), Degree(m.brg), m.clas, Meter(m.mixh), Ppm(m.amb));
+            }
+            s.evaluated = false;
+            return CALINE3_OK;
+        });
+    }
+
+    caline3_status caline3_clear_links(caline3_session *session)
+    {
+        return guarded(session, [&](caline3_session &s)
+        {
+            site_of(s).Links.clear();
+            s.evaluated = false;
+            return CALINE3_OK;
+        });
+    }
+
+    caline3_status caline3_clear_meteos(caline3_session *session)
+    {
+        return guarded(session, [&](caline3_session &s)
+        {
+            site_of(s).Meteos.clear();
+            s.evaluated = false;
+            return CALINE3_OK;
+        });
+    }
+
+    caline3_status caline3_get_dims(const caline3_session *session, size_t *links, size_t *receptors, size_t *meteos)
+    {
+        if (!session)
+            return CALINE3_INVALID_ARGUMENT;
+        if (!session->site)
+            return CALINE3_INVALID_STATE;
+
+        if (links) *links = session->site->Links.size();
+        if (receptors) *receptors = session->site->Receptors.size();
+        if (meteos) *meteos = session->site->Meteos.size();
+        return CALINE3_OK;
+    }
+
+    caline3_status caline3_evaluate(caline3_session *session)
+    {
+        return guarded(session, [&](caline3_session &s)
+        {
+            const Job &site = site_of(s);
+
+            // Matrices (storage) are reused from one evaluation to the next:
+            s.results.resize(site.Meteos.size());
+            for (auto const& meteo : site.Meteos)
+            {
+                s.engine.Compute(site, meteo, s.results[meteo.ORDINAL]);
+            }
+            s.evaluated = true;
+            return CALINE3_OK;
+        });
+    }
+
+    caline3_status caline3_get_matrix(const caline3_session *session, size_t meteo, double *mc, size_t capacity)
+    {
+        if (!session || !mc)
+            return CALINE3_INVALID_ARGUMENT;
+        if (!session->site || !session->evaluated)
+            return CALINE3_INVALID_STATE;
+        if (meteo >= session->results.size())
+            return CALINE3_INVALID_ARGUMENT;
+
+        const Job &site = *session->site;
+        const ConcentrationMatrix &MC = session->results[meteo];
+        if (capacity < site.Links.size() * site.Receptors.size())
+            return CALINE3_BUFFER_TOO_SMALL;
+
+        for (auto const& row : MC)
+        {
+            for (auto const& c : row)
+            {
+                *mc++ = c.value();
+            }
+        }
+        return CALINE3_OK;
+    }
+
+    caline3_status caline3_evaluate_columns(caline3_session *session,
+        const caline3_receptor_columns *receptors, const caline3_link_columns *links,
+        const caline3_meteo *meteo, double *mc, size_t capacity)
+    {
+        return guarded(session, [&](caline3_session &s)
+        {
+            const Job &site = site_of(s);
+            if (!receptors || !links || !meteo || !mc)
+                throw std::invalid_argument("null pointer.");
+            if (receptors->count && (!receptors->xr || !receptors->yr || !receptors->zr))
+                throw std::invalid_argument("receptors: null column.");
+            if (links->count && (!links->xl1 || !links->yl1 || !links->xl2 || !links->yl2 ||
+                !links->vphl || !links->efl || !links->hl || !links->wl || !links->type))
+                throw std::invalid_argument("links: null column.");
+            if (capacity < links->count * receptors->count)
+                return CALINE3_BUFFER_TOO_SMALL;
+            validate(*meteo);
+
+            const Meteo conditions(0, Meter_Sec(meteo->u), Degree(meteo->brg), meteo->clas, Meter(meteo->mixh), Ppm(meteo->amb));
+            const ReceptorColumns R{ receptors->xr, receptors->yr, receptors->zr, receptors->count };
+            const LinkColumns L{
+                links->xl1, links->yl1, links->xl2, links->yl2,
+                links->vphl, links->efl, links->hl, links->wl,
+                links->type, links->count
+            };
+            s.engine.Compute(site, conditions, R, L, mc);
+            return CALINE3_OK;
+        });
+    }
+}
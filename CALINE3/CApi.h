@@ -0,0 +1,221 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+/*
+ * CALINE3 core library C API.
+ *
+ * Typical use (error checking omitted):
+ *
+ *     caline3_session *s = caline3_session_create(0);
+ *     caline3_site_create(s, "SITE", 60.0, 100.0, 0.0, 0.0);
+ *     caline3_add_receptors(s, receptors, NR);
+ *     caline3_add_links(s, links, NL);
+ *     caline3_add_meteos(s, meteos, NM);
+ *     caline3_evaluate(s);
+ *     caline3_get_matrix(s, 0, mc, NL * NR);      // MC[link][receptor] for meteo 0
+ *     caline3_session_destroy(s);
+ *
+ * Alternatively, receptors and links kept by the caller in columns (arrays) may be
+ * evaluated in place with caline3_evaluate_columns(), without copying them into the session.
+ *
+ * Units: coordinates, heights and widths [m], ATIM [min], Z0 [cm], VS/VD [cm/s],
+ * VPHL [vehicles/hour], EFL [g/mile], U [m/s], BRG [deg], MIXH [m], AMB [ppm];
+ * concentrations returned in [ug/m3].
+ *
+ * A session is not thread-safe, but separate sessions can be used concurrently.
+ * Functions never throw; failures are reported by status codes with the details
+ * available from caline3_last_error().
+ */
+
+#ifndef CALINE3_CAPI_H
+#define CALINE3_CAPI_H
+
+#include <stddef.h>
+
+#if defined(CALINE3_CORE_SHARED)
+#  if defined(_WIN32)
+#    if defined(CALINE3_CORE_EXPORTS)
+#      define CALINE3_API __declspec(dllexport)
+#    else
+#      define CALINE3_API __declspec(dllimport)
+#    endif
+#  else
+#    define CALINE3_API __attribute__((visibility("default")))
+#  endif
+#else
+#  define CALINE3_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief API version (incremented on incompatible changes). */
+#define CALINE3_API_VERSION 1
+
+/** @brief Status codes. */
+typedef enum caline3_status
+{
+    CALINE3_OK = 0,                 /**< Success. */
+    CALINE3_INVALID_ARGUMENT = 1,   /**< Invalid argument (see caline3_last_error()). */
+    CALINE3_INVALID_STATE = 2,      /**< Call out of order, e.g. no site created or not evaluated yet. */
+    CALINE3_BUFFER_TOO_SMALL = 3,   /**< Output buffer too small. */
+    CALINE3_ERROR = 4               /**< Other (internal) error. */
+} caline3_status;
+
+/** @brief Session (opaque handle). */
+typedef struct caline3_session caline3_session;
+
+/** @brief Receptor. */
+typedef struct caline3_receptor
+{
+    const char *name;               /**< Description (may be NULL). */
+    double xr, yr, zr;              /**< Coordinates [m]. */
+} caline3_receptor;
+
+/** @brief Link. */
+typedef struct caline3_link
+{
+    const char *name;               /**< Description (may be NULL). */
+    const char *type;               /**< Type: "AG", "BR", "FL" or "DP". */
+    double xl1, yl1, xl2, yl2;      /**< Endpoint coordinates [m]. */
+    double vphl;                    /**< Traffic volume [vehicles/hour]. */
+    double efl;                     /**< Emission factor [g/mile]. */
+    double hl;                      /**< Source height [m]. */
+    double wl;                      /**< Mixing zone width [m]. */
+} caline3_link;
+
+/** @brief Meteo conditions. */
+typedef struct caline3_meteo
+{
+    double u;                       /**< Wind speed [m/s]. */
+    double brg;                     /**< Wind direction [deg]. */
+    int clas;                       /**< Stability class (1..6 = A..F). */
+    double mixh;                    /**< Mixing height [m]. */
+    double amb;                     /**< Ambient concentration [ppm]. */
+} caline3_meteo;
+
+/** @brief Receptors as caller-owned columns (each of count elements). */
+typedef struct caline3_receptor_columns
+{
+    const double *xr, *yr, *zr;     /**< Coordinates [m]. */
+    size_t count;                   /**< Number of receptors. */
+} caline3_receptor_columns;
+
+/** @brief Link type codes (as used in caline3_link_columns). */
+enum { CALINE3_AG = 0, CALINE3_BR = 1, CALINE3_FL = 2, CALINE3_DP = 3 };
+
+/** @brief Links as caller-owned columns (each of count elements). */
+typedef struct caline3_link_columns
+{
+    const double *xl1, *yl1, *xl2, *yl2;    /**< Endpoint coordinates [m]. */
+    const double *vphl;                     /**< Traffic volumes [vehicles/hour]. */
+    const double *efl;                      /**< Emission factors [g/mile]. */
+    const double *hl;                       /**< Source heights [m]. */
+    const double *wl;                       /**< Mixing zone widths [m]. */
+    const unsigned char *type;              /**< Type codes: CALINE3_AG, _BR, _FL or _DP. */
+    size_t count;                           /**< Number of links. */
+} caline3_link_columns;
+
+/**
+ * @brief Creates a session.
+ * @param threads - number of compute threads (1 = serial, 0 = number of hardware threads).
+ * @return session handle or NULL when out of resources.
+ */
+CALINE3_API caline3_session *caline3_session_create(unsigned threads);
+
+/**
+ * @brief Destroys the session (NULL is ignored).
+ */
+CALINE3_API void caline3_session_destroy(caline3_session *session);
+
+/**
+ * @brief Message describing the last error in the session ("" if none).
+ */
+CALINE3_API const char *caline3_last_error(const caline3_session *session);
+
+/**
+ * @brief Creates a site (replacing the previous one, with its links, receptors, meteos and results).
+ * @param job - site description (may be NULL),
+ * @param atim - averaging time [min],
+ * @param z0 - surface roughness [cm],
+ * @param vs - settling velocity [cm/s],
+ * @param vd - deposition velocity [cm/s].
+ */
+CALINE3_API caline3_status caline3_site_create(caline3_session *session, const char *job, double atim, double z0, double vs, double vd);
+
+/**
+ * @brief Appends receptors to the site.
+ */
+CALINE3_API caline3_status caline3_add_receptors(caline3_session *session, const caline3_receptor *receptors, size_t count);
+
+/**
+ * @brief Appends links to the site.
+ */
+CALINE3_API caline3_status caline3_add_links(caline3_session *session, const caline3_link *links, size_t count);
+
+/**
+ * @brief Appends meteo conditions to the site.
+ */
+CALINE3_API caline3_status caline3_add_meteos(caline3_session *session, const caline3_meteo *meteos, size_t count);
+
+/**
+ * @brief Removes all links (keeping receptors and meteos), e.g. to evaluate another road layout.
+ */
+CALINE3_API caline3_status caline3_clear_links(caline3_session *session);
+
+/**
+ * @brief Removes all meteo conditions (keeping links and receptors), e.g. to evaluate another hour.
+ */
+CALINE3_API caline3_status caline3_clear_meteos(caline3_session *session);
+
+/**
+ * @brief Site dimensions: number of links, receptors and meteos (any pointer may be NULL).
+ */
+CALINE3_API caline3_status caline3_get_dims(const caline3_session *session, size_t *links, size_t *receptors, size_t *meteos);
+
+/**
+ * @brief Evaluates concentration matrices for all meteo conditions.
+ */
+CALINE3_API caline3_status caline3_evaluate(caline3_session *session);
+
+/**
+ * @brief Copies the concentration matrix MC[link][receptor] [ug/m3] (row-major) evaluated for a meteo.
+ * @param meteo - meteo index (in the order added),
+ * @param mc - output buffer,
+ * @param capacity - output buffer size (number of doubles; at least links * receptors).
+ */
+CALINE3_API caline3_status caline3_get_matrix(const caline3_session *session, size_t meteo, double *mc, size_t capacity);
+
+/**
+ * @brief Evaluates the concentration matrix directly on caller-owned columns (zero-copy).
+ * @param receptors - receptor columns,
+ * @param links - link columns,
+ * @param meteo - meteo conditions,
+ * @param mc - output buffer for MC[link][receptor] [ug/m3] (row-major),
+ * @param capacity - output buffer size (number of doubles; at least links * receptors).
+ * @remarks Uses the site parameters (ATIM, Z0, VS, VD) only: the links, receptors, meteos
+ * and results held by the session are neither used nor changed.
+ */
+CALINE3_API caline3_status caline3_evaluate_columns(caline3_session *session,
+    const caline3_receptor_columns *receptors, const caline3_link_columns *links,
+    const caline3_meteo *meteo, double *mc, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !CALINE3_CAPI_H */
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "Counters.h"
+#include "Json.h"
+
+namespace CALINE3
+{
+    namespace
+    {
+        /// @brief Counts as JSON object members.
+        void members(std::ostream& os, const Counters& c)
+        {
+            os << "\"pairs\": " << c.Pairs
+               << ", \"elements\": " << c.Elements
+               << ", \"no_profile\": " << c.NoProfile
+               << ", \"deposition_nan\": " << c.DepositionNaN
+               << ", \"gaussian_iterations\": " << c.GaussianIterations;
+        }
+
+        /// @brief Counts as text table columns.
+        void columns(std::ostream& os, const Counters& c)
+        {
+            os << std::setw(12) << c.Pairs << std::setw(14) << c.Elements << std::setw(12) << c.NoProfile
+               << std::setw(12) << c.DepositionNaN << std::setw(14) << c.GaussianIterations;
+        }
+
+        void header(std::ostream& os, const char *title)
+        {
+            os << std::left << std::setw(24) << title << std::right
+               << std::setw(12) << "pairs" << std::setw(14) << "elements" << std::setw(12) << "no profile"
+               << std::setw(12) << "dep. NaN" << std::setw(14) << "gauss. iter." << std::endl;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Methods
+    ///
+
+    void CounterLog::Add(std::size_t job, const std::string& title, std::size_t meteo, std::size_t link, const Counters& counts)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries[Key{ job, meteo, link }] += counts;
+        m_titles.emplace(job, title);
+    }
+
+    std::map<CounterLog::Key, Counters> CounterLog::Entries() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries;
+    }
+
+    Counters CounterLog::Total() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Counters total;
+        for (auto const& entry : m_entries)
+        {
+            total += entry.second;
+        }
+        return total;
+    }
+
+    void CounterLog::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+        m_titles.clear();
+    }
+
+    void CounterLog::PrintJSON(std::ostream& os) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Counters total;
+        for (auto const& entry : m_entries)
+        {
+            total += entry.second;
+        }
+
+        std::ostringstream json;
+        json << "{\n  \"total\": { ";
+        members(json, total);
+        json << " },\n  \"entries\": [";
+        const char *separator = "\n";
+        for (auto const& [key, counts] : m_entries)
+        {
+            auto [job, meteo, link] = key;
+            json << separator
+                 << "    { \"job\": " << job + 1 << ", \"title\": " << Json::Quoted(m_titles.at(job))
+                 << ", \"meteo\": " << meteo + 1 << ", \"link\": " << link + 1 << ", ";
+            members(json, counts);
+            json << " }";
+            separator = ",\n";
+        }
+        json << "\n  ]\n}\n";
+        os << json.str();
+    }
+
+    void CounterLog::PrintText(std::ostream& os, std::size_t top) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Totals per job, meteo and link:
+        Counters total;
+        std::map<std::size_t, Counters> jobs;
+        std::map<std::pair<std::size_t, std::size_t>, Counters> meteos;
+        std::map<std::pair<std::size_t, std::size_t>, Counters> links;
+        for (auto const& [key, counts] : m_entries)
+        {
+            auto [job, meteo, link] = key;
+            total += counts;
+            jobs[job] += counts;
+            meteos[{ job, meteo }] += counts;
+            links[{ job, link }] += counts;
+        }
+
+        std::ostringstream text;
+        header(text, "JOB");
+        for (auto const& [job, counts] : jobs)
+        {
+            text << std::left << std::setw(24) << (std::to_string(job + 1) + " " + m_titles.at(job)).substr(0, 23) << std::right;
+            columns(text, counts);
+            text << std::endl;
+        }
+        text << std::left << std::setw(24) << "TOTAL" << std::right;
+        columns(text, total);
+        text << std::endl << std::endl;
+
+        header(text, "JOB / METEO");
+        for (auto const& [key, counts] : meteos)
+        {
+            text << std::left << std::setw(24) << (std::to_string(key.first + 1) + " / " + std::to_string(key.second + 1)) << std::right;
+            columns(text, counts);
+            text << std::endl;
+        }
+        text << std::endl;
+
+        header(text, "JOB / LINK");
+        for (auto const& [key, counts] : links)
+        {
+            text << std::left << std::setw(24) << (std::to_string(key.first + 1) + " / " + std::to_string(key.second + 1)) << std::right;
+            columns(text, counts);
+            text << std::endl;
+        }
+        text << std::endl;
+
+        // The most costly (job, meteo, link) entries (by elements built):
+        std::vector<std::pair<Key, Counters>> costly(m_entries.begin(), m_entries.end());
+        std::stable_sort(costly.begin(), costly.end(), [](auto const& a, auto const& b) { return a.second.Elements > b.second.Elements; });
+        costly.resize(std::min(top, costly.size()));
+
+        header(text, "JOB / METEO / LINK (TOP)");
+        for (auto const& [key, counts] : costly)
+        {
+            auto [job, meteo, link] = key;
+            text << std::left << std::setw(24) << (std::to_string(job + 1) + " / " + std::to_string(meteo + 1) + " / " + std::to_string(link + 1)) << std::right;
+            columns(text, counts);
+            text << std::endl;
+        }
+        os << text.str();
+    }
+
+    CounterLog& CounterLog::Global()
+    {
+        static CounterLog log;
+        return log;
+    }
+}
@@ -0,0 +1,148 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace CALINE3
+{
+    /**
+     * @brief Hot path event counts.
+     */
+    struct Counters
+    {
+        std::uint64_t Pairs = 0;                /// Link-receptor pairs evaluated (Plume::ConcentrationAt calls, ConcentrationProfile levels).
+        std::uint64_t Elements = 0;             /// LinkElements evaluated per receptor (a profile counts each of its levels).
+        std::uint64_t NoProfile = 0;            /// LinkElement::GetProfile returning false per receptor (element not contributing).
+        std::uint64_t DepositionNaN = 0;        /// Plume::DepositionFactor returning NaN (element dropped).
+        std::uint64_t GaussianIterations = 0;   /// Plume::GaussianFactor loop iterations (mixing height reflections).
+
+        Counters& operator+=(const Counters& other)
+        {
+            Pairs += other.Pairs;
+            Elements += other.Elements;
+            NoProfile += other.NoProfile;
+            DepositionNaN += other.DepositionNaN;
+            GaussianIterations += other.GaussianIterations;
+            return *this;
+        }
+    };
+
+    /**
+     * @brief Counters aggregated per job, meteo and link (from any number of threads).
+     */
+    class CounterLog
+    {
+    public:
+
+        /// @brief (job, meteo, link) ordinals.
+        using Key = std::tuple<std::size_t, std::size_t, std::size_t>;
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Adds counts to the job/meteo/link entry.
+         * @param job - job ordinal,
+         * @param title - job title (JOB),
+         * @param meteo - meteo ordinal,
+         * @param link - link ordinal,
+         * @param counts - counts to add.
+         * @remarks Thread-safe.
+         */
+        void Add(std::size_t job, const std::string& title, std::size_t meteo, std::size_t link, const Counters& counts);
+
+        /**
+         * @brief Entries (ordered by job, meteo, link).
+         */
+        std::map<Key, Counters> Entries() const;
+
+        /**
+         * @brief Total counts.
+         */
+        Counters Total() const;
+
+        /**
+         * @brief Forgets all the entries.
+         */
+        void Clear();
+
+        /**
+         * @brief Prints totals and (job, meteo, link) entries as JSON.
+         */
+        void PrintJSON(std::ostream& os) const;
+
+        /**
+         * @brief Prints totals, per job/meteo/link entries and the links that built the most elements as text.
+         * @param top - number of the most costly entries to list.
+         */
+        void PrintText(std::ostream& os, std::size_t top = 10) const;
+
+        /**
+         * @brief Log the instrumented code reports to (CALINE3_COUNTERS builds only).
+         */
+        static CounterLog& Global();
+
+    private:
+
+        mutable std::mutex m_mutex;                     /// Entries guard.
+        std::map<Key, Counters> m_entries;              /// Counts per (job, meteo, link).
+        std::map<std::size_t, std::string> m_titles;    /// Job titles.
+    };
+
+    namespace Counting
+    {
+#ifdef CALINE3_COUNTERS
+        /// @brief Counts of the current thread (since the last Flush).
+        inline thread_local Counters t_counters;
+
+        /**
+         * @brief Moves the counts of the current thread to the global log (job/meteo/link entry).
+         */
+        inline void Flush(std::size_t job, const std::string& title, std::size_t meteo, std::size_t link)
+        {
+            CounterLog::Global().Add(job, title, meteo, link, t_counters);
+            t_counters = Counters{};
+        }
+#endif
+    }
+}
+
+/*
+ * Instrumentation points: compiled in with CALINE3_COUNTERS defined
+ * (cmake -DCALINE3_COUNTERS=ON), expanded to nothing otherwise.
+ */
+#ifdef CALINE3_COUNTERS
+#define CALINE3_COUNT(counter) (++::CALINE3::Counting::t_counters.counter)
+#define CALINE3_COUNT_ADD(counter, n) (::CALINE3::Counting::t_counters.counter += (n))
+#define CALINE3_COUNT_FLUSH(job, title, meteo, link) (::CALINE3::Counting::Flush((job), (title), (meteo), (link)))
+#else
+#define CALINE3_COUNT(counter) ((void)0)
+#define CALINE3_COUNT_ADD(counter, n) ((void)0)
+#define CALINE3_COUNT_FLUSH(job, title, meteo, link) ((void)0)
+#endif
+
+#endif /* !COUNTERS_H */
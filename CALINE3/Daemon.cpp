@@ -0,0 +1,273 @@
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "FdStream.h"
+#endif
+
+#include "Daemon.h"
+#include "JobReader.h"
+#include "Report.h"
+
+namespace CALINE3
+{
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Result formats
+    ///
+
+    /**
+     * @brief Appends CSV lines (JOB,METEO,LINK,RECEPTOR,MC) of the concentration matrix.
+     */
+    static void PrintCSV(std::ostream &os, const Job& site, const Meteo& meteo, const ConcentrationMatrix &MC)
+    {
+        char buf[32];
+        for (auto const& link : site.Links)
+        {
+            for (auto const& receptor : site.Receptors)
+            {
+                auto result = std::to_chars(buf, buf + sizeof(buf), MC[link.ORDINAL][receptor.ORDINAL].value());
+                os
+                    << (site.ORDINAL + 1) << ','
+                    << (meteo.ORDINAL + 1) << ','
+                    << (link.ORDINAL + 1) << ','
+                    << (receptor.ORDINAL + 1) << ',';
+                os.write(buf, result.ptr - buf);
+                os.put('\n');
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Methods
+    ///
+
+    bool Daemon::Run(const std::string &format, const std::string &input, std::string &output) const
+    {
+        const bool lst = (format == "lst");
+        if (!lst && (format != "csv"))
+        {
+            output = "unknown result format: " + format + ".";
+            return false;
+        }
+
+        std::istringstream is{ input };
+        std::ostringstream log;
+        std::ostringstream os;
+
+        JobReader rdr{ "request", is, log };
+        Report report{ os };
+        ConcentrationMatrix MC;
+
+        if (!lst)
+        {
+            os << "JOB,METEO,LINK,RECEPTOR,MC\n";
+        }
+
+        for (auto const& site : rdr)
+        {
+            for (auto const& meteo : site.Meteos)
+            {
+                m_engine.Compute(site, meteo, MC);
+                if (lst)
+                    report.Print(site, meteo, MC);
+                else
+                    PrintCSV(os, site, meteo, MC);
+            }
+        }
+
+        if (rdr.ErrorFound())
+        {
+            output = log.str();
+            return false;
+        }
+
+        output = os.str();
+        return true;
+    }
+
+    void Daemon::Serve(std::istream &is, std::ostream &os) const
+    {
+        std::string line;
+        while (std::getline(is, line))
+        {
+            std::istringstream request{ line };
+            std::string command;
+            request >> command;
+
+            if (command.empty())
+                continue;
+            if (command == "QUIT")
+                break;
+
+            bool ok = false;
+            bool close = false;     // (stream out of step with the protocol)
+            std::string output;
+            try
+            {
+                if (command == "PING")
+                {
+                    ok = true;
+                }
+                else if (command == "RUN")
+                {
+                    std::string format;
+                    std::size_t length;
+                    if (!(request >> format >> length))
+                    {
+                        output = "invalid request: " + line;
+                    }
+                    else if (length > m_max_request)
+                    {
+                        output = "request too large: " + std::to_string(length) + " bytes (limit " + std::to_string(m_max_request) + ").";
+                        close = true;
+                    }
+                    else
+                    {
+                        std::string input;
+                        try
+                        {
+                            input.resize(length);
+                        }
+                        catch (std::exception const&)
+                        {
+                            close = true;
+                            throw;
+                        }
+                        if (!is.read(input.data(), static_cast<std::streamsize>(length)))
+                        {
+                            output = "incomplete request: " + std::to_string(is.gcount()) + " of " + std::to_string(length) + " bytes.";
+                            close = true;
+                        }
+                        else
+                        {
+                            ok = Run(format, input, output);
+                        }
+                    }
+                }
+                else
+                {
+                    output = "unknown request: " + command;
+                }
+            }
+            catch (std::exception const& ex)
+            {
+                ok = false;
+                output = ex.what();
+            }
+
+            os << (ok ? "OK " : "ERROR ") << output.size() << '\n';
+            os.write(output.data(), static_cast<std::streamsize>(output.size()));
+            if (!os.flush() || close)
+                break;
+        }
+    }
+
+    int Daemon::Listen(const std::string &path) const
+    {
+#ifdef _WIN32
+        std::cerr << path << ": UNIX domain sockets are not supported on this platform (use stdin/stdout)." << std::endl;
+        return 5;
+#else
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << path << ": socket path too long." << std::endl;
+            return 5;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0)
+        {
+            std::cerr << path << ": " << std::strerror(errno) << std::endl;
+            return 5;
+        }
+
+        // Only a socket (left by a previous daemon) is replaced:
+        struct stat existing;
+        if (::lstat(path.c_str(), &existing) == 0)
+        {
+            if (!S_ISSOCK(existing.st_mode))
+            {
+                std::cerr << path << ": file exists and is not a socket (not replaced)." << std::endl;
+                ::close(listener);
+                return 5;
+            }
+            ::unlink(path.c_str());
+        }
+        if ((::bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) ||
+            (::listen(listener, SOMAXCONN) != 0))
+        {
+            std::cerr << path << ": " << std::strerror(errno) << std::endl;
+            ::close(listener);
+            return 5;
+        }
+
+        // Clients going away must not kill the daemon:
+        std::signal(SIGPIPE, SIG_IGN);
+
+        // Connections served at once (new ones are not accepted while at the limit):
+        std::mutex mutex;
+        std::condition_variable closed;
+        std::size_t active = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock{ mutex };
+                closed.wait(lock, [this, &active]() { return active < m_max_connections; });
+            }
+
+            int fd = ::accept(listener, nullptr, nullptr);
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                std::cerr << path << ": " << std::strerror(errno) << std::endl;
+                break;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{ mutex };
+                active++;
+            }
+            std::thread([this, fd, &mutex, &closed, &active]()
+            {
+                {
+                    FdStreamBuf buffer{ fd };
+                    std::istream is{ &buffer };
+                    std::ostream os{ &buffer };
+                    Serve(is, os);
+                }
+                ::close(fd);
+                std::lock_guard<std::mutex> lock{ mutex };
+                active--;
+                closed.notify_all();
+            }).detach();
+        }
+
+        ::close(listener);
+        ::unlink(path.c_str());
+
+        // The connections refer to the counter (wait for them to close):
+        std::unique_lock<std::mutex> lock{ mutex };
+        closed.wait(lock, [&active]() { return active == 0; });
+        return 5;
+#endif
+    }
+}
@@ -0,0 +1,116 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "Engine.h"
+
+namespace CALINE3
+{
+    /*
+     * Daemon protocol (the same over a UNIX domain socket and stdin/stdout):
+     *
+     *   request:   RUN <format> <length>\n<length bytes of input data (CALINE3.EXP format)>
+     *              PING\n
+     *              QUIT\n
+     *
+     *   response:  OK <length>\n<length bytes of results>
+     *              ERROR <length>\n<length bytes of error message>
+     *
+     * Result formats:
+     *
+     *   lst - report pages as printed by the application (without timing lines),
+     *   csv - JOB,METEO,LINK,RECEPTOR,MC lines (1-based ordinals; MC in [ug/m3], full precision).
+     *
+     * Requests are served one after another, until QUIT or end of the input stream.
+     * A RUN longer than the daemon limit (Daemon::MAX_REQUEST by default) or with input data
+     * that cannot be read in full gets an ERROR response and the connection is closed
+     * (the rest of the stream cannot be told apart from the unread data).
+     */
+
+    /**
+     * @brief Serves CALINE3 jobs to (local) clients, keeping the engine warm between requests.
+     */
+    class Daemon
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Constructor(s)
+        ///
+
+        /// @brief Default limit of the RUN input data length [bytes].
+        static constexpr std::size_t MAX_REQUEST = std::size_t{ 64 } << 20;
+
+        /// @brief Default limit of the connections served at once.
+        static constexpr std::size_t MAX_CONNECTIONS = 16;
+
+        /**
+         * @brief Daemon constructor.
+         * @param engine - engine computing concentration matrices (shared by all connections),
+         * @param max_request - limit of the RUN input data length [bytes],
+         * @param max_connections - limit of the connections served at once (at least 1).
+         */
+        explicit Daemon(const Engine &engine, std::size_t max_request = MAX_REQUEST, std::size_t max_connections = MAX_CONNECTIONS)
+            : m_engine(engine), m_max_request(max_request), m_max_connections(max_connections ? max_connections : 1)
+        {
+        }
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Serves requests read from the input stream.
+         * @param is - request stream,
+         * @param os - response stream.
+         */
+        void Serve(std::istream &is, std::ostream &os) const;
+
+        /**
+         * @brief Listens for connections on a UNIX domain socket (and serves each on its own thread).
+         * @param path - socket path (a socket left there is replaced; any other file is an error).
+         * @return never returns unless an error occurs (non-zero exit code then).
+         * @remarks At most max_connections are served at once (so at most that many RUN requests
+         * are buffered); further clients wait in the listen backlog until a connection closes.
+         */
+        int Listen(const std::string &path) const;
+
+        /**
+         * @brief Runs the jobs of the input data.
+         * @param format - result format ("lst" or "csv"),
+         * @param input - input data (CALINE3.EXP format),
+         * @param output - results (or error message).
+         * @return @c true on success, @c false on error.
+         */
+        bool Run(const std::string &format, const std::string &input, std::string &output) const;
+
+    private:
+
+        const Engine &m_engine;     /// Shared engine.
+        std::size_t m_max_request;  /// Limit of the RUN input data length [bytes].
+        std::size_t m_max_connections;  /// Limit of the connections served at once.
+    };
+}
+
+#endif /* !DAEMON_H */
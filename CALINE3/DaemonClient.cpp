@@ -0,0 +1,147 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "FdStream.h"
+
+using namespace CALINE3;
+
+static int usage(const char *app)
+{
+    const char *name = app ? app : "Caline3Client";
+    std::cerr
+        << "Usage: " << name << " /path/to/caline3.sock [--format=lst|csv] /path/to/input.data|-" << std::endl
+        << "       " << name << " /path/to/caline3.sock --ping" << std::endl
+        << "(sends input data to the daemon started with: Caline3 --daemon=/path/to/caline3.sock)" << std::endl;
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    const char *socket_path = (argc > 1) ? argv[1] : nullptr;
+    const char *input_path = nullptr;
+    std::string format{ "lst" };
+    bool ping = false;
+
+    bool valid = (socket_path != nullptr);
+    for (int i = 2; valid && (i < argc); i++)
+    {
+        if (std::strncmp(argv[i], "--format=", 9) == 0)
+            format = argv[i] + 9;
+        else if (std::strcmp(argv[i], "--ping") == 0)
+            ping = true;
+        else if (((argv[i][0] != '-') || (std::strcmp(argv[i], "-") == 0)) && !input_path)
+            input_path = argv[i];
+        else
+            valid = false;
+    }
+
+    if (!valid || (!ping && !input_path))
+    {
+        return usage(argv[0]);
+    }
+
+    // Request:
+    std::string request;
+    if (ping)
+    {
+        request = "PING\n";
+    }
+    else
+    {
+        std::string input;
+        if (std::strcmp(input_path, "-") == 0)
+        {
+            input.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        }
+        else
+        {
+            std::ifstream file(input_path, std::ios::in | std::ios::binary);
+            if (!file.is_open())
+            {
+                std::cerr << input_path << ": failed to open." << std::endl;
+                return 2;
+            }
+            input.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        request = "RUN " + format + " " + std::to_string(input.size()) + "\n" + input;
+    }
+
+    // Connection:
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        std::cerr << socket_path << ": socket path too long." << std::endl;
+        return 2;
+    }
+    std::strcpy(address.sun_path, socket_path);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if ((fd < 0) || (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0))
+    {
+        std::cerr << socket_path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return 2;
+    }
+
+    // Exchange:
+    int exit_code = 0;
+    {
+        FdStreamBuf buffer{ fd };
+        std::iostream stream{ &buffer };
+
+        stream << request << "QUIT\n" << std::flush;
+
+        std::string status;
+        std::size_t length = 0;
+        std::string header;
+        if (!std::getline(stream, header) || !(std::istringstream{ header } >> status >> length))
+        {
+            std::cerr << socket_path << ": no response." << std::endl;
+            exit_code = 2;
+        }
+        else
+        {
+            std::string response(length, '\0');
+            stream.read(response.data(), static_cast<std::streamsize>(length));
+
+            if (status == "OK")
+            {
+                std::cout << (ping ? "OK\n" : response) << std::flush;
+            }
+            else
+            {
+                std::cerr << response << std::flush;
+                exit_code = 3;
+            }
+        }
+    }
+
+    ::close(fd);
+    return exit_code;
+}
@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Counters.h"
+#include "Engine.h"
+#include "PerfCounters.h"
+#include "Phases.h"
+#include "Plume.h"
+#include "Trace.h"
+
+namespace CALINE3
+{
+    /**
+     * @brief Receptors grouped by their XY location (vertical profiles) within units of receptors.
+     * @remarks Units are the receptor ranges the tiles are made of (e.g. receptor blocks), so that
+     * a tile takes the groups of its units without regrouping (groups do not span units).
+     */
+    struct Engine::Profiles
+    {
+        std::vector<std::size_t> Order;     /// Receptor indices, grouped per unit (in the order of their first receptor).
+        std::vector<std::size_t> Start;     /// Group starts in Order (followed by Order.size()).
+        std::vector<std::size_t> Units;     /// First receptor of each unit (followed by NR).
+        std::vector<std::size_t> Groups;    /// First group of each unit (followed by the group count).
+    };
+
+    namespace
+    {
+        /**
+         * @brief Groups receptors [0, NR) of the same XY location (xy(R) = std::pair{ XR, YR }) within units:
+         * receptor blocks of the given size within each streamed tile of the given size.
+         */
+        template<typename Profiles, typename XY>
+        Profiles GroupByXY(std::size_t NR, std::size_t stream, std::size_t block, XY&& xy)
+        {
+            Profiles profiles;
+            profiles.Order.resize(NR);
+            for (std::size_t R = 0; R < NR; R++)
+            {
+                profiles.Order[R] = R;
+            }
+            stream = std::max<std::size_t>(1, stream);
+            block = std::max<std::size_t>(1, std::min(block, stream));
+            for (std::size_t s = 0; s < NR; s += stream)
+            {
+                for (std::size_t u = s; u < std::min(NR, s + stream); u += block)
+                {
+                    profiles.Units.push_back(u);
+                }
+            }
+            profiles.Units.push_back(NR);
+
+            for (std::size_t u = 0; u + 1 < profiles.Units.size(); u++)
+            {
+                const auto first = profiles.Order.begin() + profiles.Units[u];
+                const auto last = profiles.Order.begin() + profiles.Units[u + 1];
+                std::stable_sort(first, last, [&xy](std::size_t a, std::size_t b) { return xy(a) < xy(b); });
+                profiles.Groups.push_back(profiles.Start.size());
+                for (std::size_t i = profiles.Units[u]; i < profiles.Units[u + 1]; i++)
+                {
+                    if ((i == profiles.Units[u]) || (xy(profiles.Order[i - 1]) != xy(profiles.Order[i])))
+                        profiles.Start.push_back(i);
+                }
+            }
+            profiles.Groups.push_back(profiles.Start.size());
+            profiles.Start.push_back(NR);
+            return profiles;
+        }
+
+        /**
+         * @brief Profile buffers of a tile: sized once (for its largest group), reused for each link of the tile.
+         */
+        struct Scratch
+        {
+            std::vector<Meter> ZR;
+            std::vector<Microgram_Meter3> C;
+            ProfileScratch Profile;
+
+            template<typename Profiles>
+            Scratch(const Profiles& profiles, std::size_t gfirst, std::size_t glast, Summation sum)
+            {
+                std::size_t levels = 0;
+                for (std::size_t g = gfirst; g < glast; g++)
+                {
+                    levels = std::max(levels, profiles.Start[g + 1] - profiles.Start[g]);
+                }
+                // (lone receptors need none)
+                if (levels < 2)
+                    return;
+                ZR.resize(levels);
+                C.resize(levels);
+                Profile.Reserve(levels, sum);
+            }
+        };
+
+        /**
+         * @brief Evaluates the receptor profiles [gfirst, glast) with the plume of a link.
+         * @param xyz - xyz(R) = std::tuple{ XR, YR, ZR } of the receptor R,
+         * @param store - store(R, C) saves the concentration C at the receptor R.
+         * @remarks Lone receptors are evaluated one by one, the others a profile at a time
+         * (the same results, see Plume::ConcentrationProfile).
+         */
+        template<typename Profiles, typename XYZ, typename Store>
+        void EvaluateProfiles(Plume& plume, const Profiles& profiles, std::size_t gfirst, std::size_t glast, Scratch& scratch, XYZ&& xyz, Store&& store)
+        {
+            for (std::size_t g = gfirst; g < glast; g++)
+            {
+                const std::size_t first = profiles.Start[g];
+                const std::size_t levels = profiles.Start[g + 1] - first;
+                auto [XR, YR, ZR] = xyz(profiles.Order[first]);
+                if (levels == 1)
+                {
+                    store(profiles.Order[first], plume.ConcentrationAt(XR, YR, ZR));
+                    continue;
+                }
+                for (std::size_t k = 0; k < levels; k++)
+                {
+                    scratch.ZR[k] = std::get<2>(xyz(profiles.Order[first + k]));
+                }
+                plume.ConcentrationProfile(XR, YR, scratch.ZR.data(), levels, scratch.C.data(), scratch.Profile);
+                for (std::size_t k = 0; k < levels; k++)
+                {
+                    store(profiles.Order[first + k], scratch.C[k]);
+                }
+            }
+        }
+
+        /**
+         * @brief Groups [gfirst, glast) of the receptors [rfirst, rlast) (a range of whole units).
+         */
+        template<typename Profiles>
+        std::pair<std::size_t, std::size_t> GroupsOf(const Profiles& profiles, std::size_t rfirst, std::size_t rlast)
+        {
+            const auto u1 = std::lower_bound(profiles.Units.begin(), profiles.Units.end(), rfirst) - profiles.Units.begin();
+            const auto u2 = std::lower_bound(profiles.Units.begin(), profiles.Units.end(), rlast) - profiles.Units.begin();
+            return { profiles.Groups[u1], profiles.Groups[u2] };
+        }
+    }
+
+    template<typename F>
+    void Engine::Spread(std::size_t NL, std::size_t NR, F&& tiles) const
+    {
+        if (!m_pool || (m_pool->Size() < 2) || (NL * NR < 2))
+        {
+            tiles(0, NL, 0, NR);
+            return;
+        }
+
+        std::vector<std::future<void>> done;
+        std::atomic<std::size_t> next{ 0 };
+        if (m_partition == Partition::Links)
+        {
+            // Links are independent: spread them (in contiguous blocks) over the workers.
+            const std::size_t tasks = std::min(NL, m_pool->Size());
+            done.reserve(tasks);
+            for (std::size_t t = 0; t < tasks; t++)
+            {
+                const std::size_t first = NL * t / tasks;
+                const std::size_t last = NL * (t + 1) / tasks;
+                done.push_back(m_pool->Submit([&tiles, first, last, NR]() {
+                    TraceSpan task{ "compute task", "compute" };
+                    ScopedCounters counters{ Stage::Compute };
+                    tiles(first, last, 0, NR);
+                }));
+            }
+        }
+        else
+        {
+            // So are receptors: workers pick (link, receptor block) tiles one by one until none is left.
+            const std::size_t blocks = (NR + m_block - 1) / m_block;
+            const std::size_t count = NL * blocks;
+            const std::size_t tasks = std::min(count, m_pool->Size());
+            done.reserve(tasks);
+            for (std::size_t t = 0; t < tasks; t++)
+            {
+                done.push_back(m_pool->Submit([&tiles, &next, count, blocks, NR, B = m_block]() {
+                    TraceSpan task{ "compute task", "compute" };
+                    ScopedCounters counters{ Stage::Compute };
+                    for (std::size_t i = next++; i < count; i = next++)
+                    {
+                        const std::size_t L = i / blocks;
+                        const std::size_t R = (i % blocks) * B;
+                        tiles(L, L + 1, R, std::min(NR, R + B));
+                    }
+                }));
+            }
+        }
+        // Wait for all the tasks (they refer to MC and next) before passing on any exception:
+        ScopedPhase wait_phase{ Phase::Wait };
+        TraceSpan wait{ "wait", "compute" };
+        for (auto& task : done)
+        {
+            task.wait();
+        }
+        for (auto& task : done)
+        {
+            task.get();
+        }
+    }
+
+    void Engine::Compute(const Job& site, const Meteo& meteo, ConcentrationMatrix& MC) const
+    {
+        const std::size_t NL = site.Links.size();
+
+        TraceSpan compute{ "compute", "compute", site.ORDINAL, meteo.ORDINAL };
+        ScopedCounters counters{ Stage::Compute };
+
+        MC.resize(NL);
+        for (auto& row : MC)
+        {
+            row.resize(site.Receptors.size());
+        }
+
+        const std::size_t NR = site.Receptors.size();
+        const Profiles profiles = GroupReceptors(site, NR);
+        if (m_policy.SharedDispersion)
+        {
+            ComputeShared(site, meteo, profiles, MC, NR, 0);
+            return;
+        }
+        Spread(NL, NR, [this, &site, &meteo, &profiles, &MC](std::size_t first, std::size_t last, std::size_t rfirst, std::size_t rlast) {
+            ComputeLinks(site, meteo, m_policy, profiles, MC, first, last, rfirst, rlast);
+        });
+    }
+
+    void Engine::Stream(const Job& site, const Meteo& meteo, std::size_t block, ConcentrationMatrix& tile,
+        const std::function<void(const ConcentrationMatrix& tile, std::size_t rfirst, std::size_t rlast)>& sink) const
+    {
+        const std::size_t NL = site.Links.size();
+        const std::size_t NR = site.Receptors.size();
+        block = std::max<std::size_t>(1, std::min(block, NR));
+
+        tile.resize(NL);
+        for (auto& row : tile)
+        {
+            row.resize(block);
+        }
+        const Profiles profiles = GroupReceptors(site, block);
+
+        for (std::size_t rbase = 0; rbase < NR; rbase += block)
+        {
+            const std::size_t rend = std::min(NR, rbase + block);
+            {
+                TraceSpan compute{ "compute", "compute", site.ORDINAL, meteo.ORDINAL };
+                ScopedCounters counters{ Stage::Compute };
+                if (m_policy.SharedDispersion)
+                {
+                    ComputeShared(site, meteo, profiles, tile, rend - rbase, rbase);
+                }
+                else
+                {
+                    Spread(NL, rend - rbase, [this, &site, &meteo, &profiles, &tile, rbase](std::size_t first, std::size_t last, std::size_t rfirst, std::size_t rlast) {
+                        ComputeLinks(site, meteo, m_policy, profiles, tile, first, last, rbase + rfirst, rbase + rlast, rbase);
+                    });
+                }
+            }
+            sink(tile, rbase, rend);
+        }
+    }
+
+    std::size_t Engine::Block(std::size_t stream) const
+    {
+        return (m_partition == Partition::ReceptorBlocks) ? m_block : stream;
+    }
+
+    Engine::Profiles Engine::GroupReceptors(const Job& site, std::size_t stream) const
+    {
+        return GroupByXY<Profiles>(site.Receptors.size(), stream, Block(stream), [&site](std::size_t R) { return std::make_pair(site.Receptors[R].XR.value(), site.Receptors[R].YR.value()); });
+    }
+
+    void Engine::ComputeShared(const Job& site, const Meteo& meteo, const Profiles& profiles, ConcentrationMatrix& MC, std::size_t NR, std::size_t rbase) const
+    {
+        const std::vector<std::size_t> sources = DispersionSources(site);
+        std::vector<std::size_t> distinct;
+        for (std::size_t L = 0; L < sources.size(); L++)
+        {
+            if (sources[L] == L)
+                distinct.push_back(L);
+        }
+
+        // Source links (any thread may do any of them; each row is computed whole by one tile as usual):
+        Spread(distinct.size(), NR, [this, &site, &meteo, &profiles, &MC, &distinct, rbase](std::size_t first, std::size_t last, std::size_t rfirst, std::size_t rlast) {
+            for (std::size_t i = first; i < last; i++)
+            {
+                ComputeLinks(site, meteo, m_policy, profiles, MC, distinct[i], distinct[i] + 1, rbase + rfirst, rbase + rlast, rbase);
+            }
+        });
+
+        // Links sharing their dispersion:
+        for (std::size_t L = 0; L < sources.size(); L++)
+        {
+            const std::size_t S = sources[L];
+            if (S == L)
+                continue;
+            const double ratio = site.Links[L].Q1() / site.Links[S].Q1();
+            for (std::size_t R = 0; R < NR; R++)
+            {
+                MC[L][R] = MC[S][R] * ratio;
+            }
+        }
+    }
+
+    std::vector<std::size_t> Engine::DispersionSources(const Job& site)
+    {
+        const std::size_t NL = site.Links.size();
+        auto geometry = [&site](std::size_t L) {
+            const Link& link = site.Links[L];
+            return std::make_tuple(link.TYP, link.XL1.value(), link.YL1.value(), link.XL2.value(), link.YL2.value(), link.HL.value(), link.WL.value());
+        };
+
+        std::vector<std::size_t> order(NL);
+        for (std::size_t L = 0; L < NL; L++)
+        {
+            order[L] = L;
+        }
+        std::stable_sort(order.begin(), order.end(), [&geometry](std::size_t a, std::size_t b) { return geometry(a) < geometry(b); });
+
+        std::vector<std::size_t> sources(NL);
+        for (std::size_t first = 0, last; first < NL; first = last)
+        {
+            // Group of links of the same geometry (in link order) and its first link with non-zero emission:
+            std::size_t source = order[first];
+            for (last = first + 1; (last < NL) && (geometry(order[last]) == geometry(order[first])); last++)
+            {
+            }
+            for (std::size_t i = first; i < last; i++)
+            {
+                if (site.Links[order[i]].Q1().value() != 0.0)
+                {
+                    source = order[i];
+                    break;
+                }
+            }
+            for (std::size_t i = first; i < last; i++)
+            {
+                sources[order[i]] = (site.Links[source].Q1().value() != 0.0) ? source : order[i];
+            }
+        }
+        return sources;
+    }
+
+    std::size_t Engine::MatrixBytes(std::size_t NL, std::size_t NR)
+    {
+        return NL * (sizeof(ConcentrationMatrix::value_type) + NR * sizeof(Microgram_Meter3));
+    }
+
+    std::size_t Engine::TileFor(std::size_t NL, std::size_t NR, std::size_t bytes)
+    {
+        if ((NL == 0) || (MatrixBytes(NL, NR) <= bytes))
+            return NR;
+        // Row headers plus as many receptor columns as fit:
+        const std::size_t rows = MatrixBytes(NL, 0);
+        return std::max<std::size_t>(1, (bytes > rows) ? (bytes - rows) / (NL * sizeof(Microgram_Meter3)) : 1);
+    }
+
+    void Engine::Compute(const Job& site, const Meteo& meteo, const ReceptorColumns& receptors, const LinkColumns& links, double *MC) const
+    {
+        for (std::size_t L = 0; L < links.NL; L++)
+        {
+            if (links.TYP[L] > Link::DP)
+                throw std::invalid_argument("link " + std::to_string(L + 1) + ": type code " + std::to_string(links.TYP[L]) + " not within 0..3 (AG, BR, FL, DP).");
+        }
+
+        TraceSpan compute{ "compute", "compute", site.ORDINAL, meteo.ORDINAL };
+        ScopedCounters counters{ Stage::Compute };
+        const Profiles profiles = GroupByXY<Profiles>(receptors.NR, receptors.NR, Block(receptors.NR), [&receptors](std::size_t R) { return std::make_pair(receptors.XR[R], receptors.YR[R]); });
+        Spread(links.NL, receptors.NR, [&](std::size_t first, std::size_t last, std::size_t rfirst, std::size_t rlast) {
+            ComputeLinks(site, meteo, m_policy, receptors, links, profiles, MC, first, last, rfirst, rlast);
+        });
+    }
+
+    void Engine::ComputeLinks(const Job& site, const Meteo& meteo, MathPolicy policy, const Profiles& profiles, ConcentrationMatrix& MC, std::size_t first, std::size_t last, std::size_t rfirst, std::size_t rlast, std::size_t rbase)
+    {
+        auto xyz = [&site](std::size_t R) { const Receptor& r = site.Receptors[R]; return std::make_tuple(r.XR, r.YR, r.ZR); };
+        const auto [gfirst, glast] = GroupsOf(profiles, rfirst, rlast);
+        Scratch scratch{ profiles, gfirst, glast, policy.Sum };
+        for (std::size_t L = first; L < last; L++)
+        {
+            const Link& link = site.Links[L];
+            TraceSpan span{ "plume", "plume", site.ORDINAL, meteo.ORDINAL, link.ORDINAL };
+            ScopedPhase setup{ Phase::PlumeSetup };
+            Plume plume(site, meteo, link, policy);
+            setup.Stop();
+            ScopedPhase elements{ Phase::Elements };
+            auto& row = MC[link.ORDINAL];
+            EvaluateProfiles(plume, profiles, gfirst, glast, scratch, xyz, [&site, &row, rbase](std::size_t R, Microgram_Meter3 C) { row[site.Receptors[R].ORDINAL - rbase] = C; });
+            CALINE3_COUNT_FLUSH(site.ORDINAL, site.JOB, meteo.ORDINAL, link.ORDINAL);
+            Timing::Flush(site.ORDINAL, site.JOB);
+        }
+    }
+
+    void Engine::ComputeLinks(const Job& site, const Meteo& meteo, MathPolicy policy, const ReceptorColumns& receptors, const LinkColumns& links, const Profiles& profiles, double *MC, std::size_t first, std::size_t last, std::size_t rfirst, std::size_t rlast)
+    {
+        auto xyz = [&receptors](std::size_t R) { return std::make_tuple(Meter(receptors.XR[R]), Meter(receptors.YR[R]), Meter(receptors.ZR[R])); };
+        const auto [gfirst, glast] = GroupsOf(profiles, rfirst, rlast);
+        Scratch scratch{ profiles, gfirst, glast, policy.Sum };     // (allocated once per tile, if it has any profiles)
+        for (std::size_t L = first; L < last; L++)
+        {
+            // Short (SSO) strings only: the link is set up without touching the heap.
+            const Link link(
+                L, std::to_string(L + 1), Link::TYPE_NAME[links.TYP[L]],
+                Meter(links.XL1[L]), Meter(links.YL1[L]), Meter(links.XL2[L]), Meter(links.YL2[L]),
+                Vehicles_Hour(links.VPHL[L]), Gram_Mile(links.EFL[L]), Meter(links.HL[L]), Meter(links.WL[L])
+            );
+            TraceSpan span{ "plume", "plume", site.ORDINAL, meteo.ORDINAL, L };
+            ScopedPhase setup{ Phase::PlumeSetup };
+            Plume plume(site, meteo, link, policy);
+            setup.Stop();
+            ScopedPhase elements{ Phase::Elements };
+            double *row = MC + L * receptors.NR;
+            EvaluateProfiles(plume, profiles, gfirst, glast, scratch, xyz, [row](std::size_t R, Microgram_Meter3 C) { row[R] = C.value(); });
+            CALINE3_COUNT_FLUSH(site.ORDINAL, site.JOB, meteo.ORDINAL, L);
+            Timing::Flush(site.ORDINAL, site.JOB);
+        }
+    }
+}
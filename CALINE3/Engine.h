@@ -0,0 +1,230 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Job.h"
+#include "ThreadPool.h"
+
+// Units required/suplementary:
+#include "Microgram_Meter3.h"
+
+namespace CALINE3
+{
+    using namespace Metrology;
+
+    /**
+     * @brief Receptors as caller-owned columns (coordinates [m]), e.g. XR[0..NR).
+     */
+    struct ReceptorColumns
+    {
+        const double *XR;
+        const double *YR;
+        const double *ZR;
+        std::size_t NR;
+    };
+
+    /**
+     * @brief Links as caller-owned columns, e.g. XL1[0..NL).
+     * @remarks Units as in Link; TYP holds Link::TypeCode values.
+     */
+    struct LinkColumns
+    {
+        const double *XL1;
+        const double *YL1;
+        const double *XL2;
+        const double *YL2;
+        const double *VPHL;
+        const double *EFL;
+        const double *HL;
+        const double *WL;
+        const std::uint8_t *TYP;
+        std::size_t NL;
+    };
+
+    /**
+     * @brief Ways to spread a concentration matrix over worker threads.
+     */
+    enum class Partition
+    {
+        Links,          /// Coarse: contiguous blocks of links (matrix rows), one block per thread.
+        ReceptorBlocks  /// Fine: (link, receptor block) tiles, handed out to the threads one at a time.
+    };
+
+    /**
+     * @brief Computes concentration matrices (serially or on a pool of worker threads).
+     */
+    class Engine
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Constructor(s)
+        ///
+
+        /**
+         * @brief Engine constructor.
+         * @param pool - worker threads to spread links over (nullptr = serial computation),
+         * @param partition - how to spread the matrix over the workers,
+         * @param block - receptors per tile (Partition::ReceptorBlocks only; 0 = DEFAULT_BLOCK),
+         * @param policy - math functions to use (e.g. the Erf variant).
+         * @remarks The pool is not owned; it must outlive the Engine.
+         * The partition does not affect the results, only the load balance (and overheads):
+         * receptor blocks balance better when links are few or uneven, at the cost of setting up
+         * the plume of a link once per block.
+         */
+        explicit Engine(ThreadPool *pool = nullptr, Partition partition = Partition::Links, std::size_t block = 0, MathPolicy policy = MathPolicy{})
+            : m_pool(pool), m_partition(partition), m_block(block ? block : DEFAULT_BLOCK), m_policy(policy)
+        {
+        }
+
+        /// @brief Default receptors per tile.
+        static constexpr std::size_t DEFAULT_BLOCK = 16;
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Computes mass concentration matrix for a given site and meteo conditions.
+         * @param site - site conditions,
+         * @param meteo - meteo conditions,
+         * @param MC - mass concentration matrix (MC[links][receptors]); resized as needed,
+         * so the storage can be reused from one meteo (or job) to the next.
+         * @remarks Safe to call from multiple threads at once (for different matrices).
+         */
+        void Compute(const Job& site, const Meteo& meteo, ConcentrationMatrix& MC) const;
+
+        /**
+         * @brief Computes mass concentration matrix for columnar receptors and links.
+         * @param site - site conditions (its own links and receptors are ignored),
+         * @param meteo - meteo conditions,
+         * @param receptors - receptor columns,
+         * @param links - link columns,
+         * @param MC - output buffer for MC[links][receptors] [ug/m3] (row-major, NL * NR doubles).
+         * @remarks The columns are read in place; no Receptor objects are created and
+         * links are set up one at a time, on the stack of the computing thread.
+         * @throws std::invalid_argument for an invalid link (e.g. type code out of range).
+         */
+        void Compute(const Job& site, const Meteo& meteo, const ReceptorColumns& receptors, const LinkColumns& links, double *MC) const;
+
+        /**
+         * @brief Computes mass concentration matrix in tiles of receptors, handing each tile over as soon as it is done.
+         * @param site - site conditions,
+         * @param meteo - meteo conditions,
+         * @param block - receptors per tile,
+         * @param tile - tile storage (tile[links][0..block)); resized as needed, reused from one tile to the next,
+         * @param sink - sink(tile, rfirst, rlast) called for receptors [rfirst, rlast), in receptor order.
+         * @remarks Streaming execution: the matrix is never held whole (e.g. to fit a memory budget);
+         * the results are the same as the ones of Compute. Each tile is spread over the pool (if any).
+         */
+        void Stream(const Job& site, const Meteo& meteo, std::size_t block, ConcentrationMatrix& tile,
+            const std::function<void(const ConcentrationMatrix& tile, std::size_t rfirst, std::size_t rlast)>& sink) const;
+
+        /**
+         * @brief Bytes the concentration matrix takes (or its tile: NR receptors).
+         */
+        static std::size_t MatrixBytes(std::size_t NL, std::size_t NR);
+
+        /**
+         * @brief Receptors per tile for the tile to fit the given bytes (NR if the whole matrix fits; at least 1).
+         */
+        static std::size_t TileFor(std::size_t NL, std::size_t NR, std::size_t bytes);
+
+        /**
+         * @brief Links whose concentrations are those of another link scaled by their emission.
+         * @returns sources[L] - the link (index) the link L shares its dispersion with (L itself if none).
+         * @remarks Concentrations are linear in the link emission (Link::Q1): links of the same type,
+         * endpoints, height and width but different VPHL or EFL (e.g. lanes or vehicle classes modeled
+         * as separate links) differ in a factor only. Each group is computed once, for its first link
+         * with non-zero emission; with MathPolicy::SharedDispersion the others are scaled from it
+         * (within rounding of their own computation). Columnar input is always computed link by link.
+         */
+        static std::vector<std::size_t> DispersionSources(const Job& site);
+
+        /**
+         * @brief Number of threads the computation is spread over.
+         */
+        std::size_t Threads() const { return m_pool ? m_pool->Size() : 1; }
+
+        /**
+         * @brief Partition the matrix is spread with.
+         */
+        Partition Partitioning() const { return m_partition; }
+
+        /**
+         * @brief Math functions in use.
+         */
+        const MathPolicy &Policy() const { return m_policy; }
+
+    private:
+
+        /**
+         * @brief Receptors grouped into vertical profiles (once per Compute or Stream call) for the tiles to evaluate.
+         */
+        struct Profiles;
+
+        /**
+         * @brief Receptors per tile of a streamed tile (or the matrix) of the given receptors.
+         */
+        std::size_t Block(std::size_t stream) const;
+
+        /**
+         * @brief Groups the site receptors into profiles within the tiles (streamed tiles of the given receptors).
+         */
+        Profiles GroupReceptors(const Job& site, std::size_t stream) const;
+
+        /**
+         * @brief Computes rows [first, last), columns [rfirst, rlast) of the matrix (or its tile starting at column rbase).
+         */
+        static void ComputeLinks(const Job& site, const Meteo& meteo, MathPolicy policy, const Profiles& profiles, ConcentrationMatrix& MC, std::size_t first, std::size_t last, std::size_t rfirst, std::size_t rlast, std::size_t rbase = 0);
+
+        /**
+         * @brief Computes the rows of the source links (DispersionSources) over the pool, then scales
+         * the rows of the links sharing their dispersion; columns [rbase, rbase + NR) (the matrix or its tile).
+         */
+        void ComputeShared(const Job& site, const Meteo& meteo, const Profiles& profiles, ConcentrationMatrix& MC, std::size_t NR, std::size_t rbase) const;
+
+        /**
+         * @brief Computes rows [first, last), columns [rfirst, rlast) of the columnar matrix.
+         */
+        static void ComputeLinks(const Job& site, const Meteo& meteo, MathPolicy policy, const ReceptorColumns& receptors, const LinkColumns& links, const Profiles& profiles, double *MC, std::size_t first, std::size_t last, std::size_t rfirst, std::size_t rlast);
+
+        /**
+         * @brief Runs tiles(first, last, rfirst, rlast) covering the NL x NR matrix, spread over the pool (if any).
+         * @remarks The tiles are disjoint: every cell is computed whole by one thread (its elements summed
+         * in a fixed order, MathPolicy::Sum), and nothing is reduced across tiles. The results therefore do
+         * not depend on the thread count or partition; sums over links (receptor totals) are left to the
+         * caller, over the finished matrix, in link order.
+         */
+        template<typename F>
+        void Spread(std::size_t NL, std::size_t NR, F&& tiles) const;
+
+        ThreadPool *m_pool;         /// Worker threads (or nullptr).
+        Partition m_partition;      /// Matrix partition.
+        std::size_t m_block;        /// Receptors per tile (Partition::ReceptorBlocks).
+        MathPolicy m_policy;        /// Math functions.
+    };
+}
+
+#endif /* !ENGINE_H */
@@ -0,0 +1,77 @@
+#ifndef _WIN32
+
+#include <cerrno>
+#include <unistd.h>
+
+#include "FdStream.h"
+
+namespace CALINE3
+{
+    FdStreamBuf::FdStreamBuf(int fd, std::size_t size)
+        : m_fd(fd), m_in(size), m_out(size)
+    {
+        setg(m_in.data(), m_in.data(), m_in.data());
+        setp(m_out.data(), m_out.data() + m_out.size());
+    }
+
+    FdStreamBuf::~FdStreamBuf()
+    {
+        flush();
+    }
+
+    FdStreamBuf::int_type FdStreamBuf::underflow()
+    {
+        for (;;)
+        {
+            auto count = ::read(m_fd, m_in.data(), m_in.size());
+            if (count > 0)
+            {
+                setg(m_in.data(), m_in.data(), m_in.data() + count);
+                return traits_type::to_int_type(*gptr());
+            }
+            if ((count < 0) && (errno == EINTR))
+                continue;
+            return traits_type::eof();
+        }
+    }
+
+    FdStreamBuf::int_type FdStreamBuf::overflow(int_type ch)
+    {
+        if (!flush())
+            return traits_type::eof();
+
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int FdStreamBuf::sync()
+    {
+        return flush() ? 0 : -1;
+    }
+
+    bool FdStreamBuf::flush()
+    {
+        const char *data = pbase();
+        std::size_t size = static_cast<std::size_t>(pptr() - pbase());
+        while (size > 0)
+        {
+            auto count = ::write(m_fd, data, size);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += count;
+            size -= static_cast<std::size_t>(count);
+        }
+        setp(m_out.data(), m_out.data() + m_out.size());
+        return true;
+    }
+}
+
+#endif /* !_WIN32 */
@@ -0,0 +1,70 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef FDSTREAM_H
+#define FDSTREAM_H
+
+#include <streambuf>
+#include <vector>
+
+namespace CALINE3
+{
+    /**
+     * @brief Buffered stream over a (POSIX) file descriptor, e.g. a connected socket.
+     * @remarks The descriptor is not owned (not closed by the buffer).
+     * Not available on Windows.
+     */
+    class FdStreamBuf : public std::streambuf
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Constructor(s)
+        ///
+
+        /**
+         * @brief FdStreamBuf constructor.
+         * @param fd - file descriptor to read from and write to,
+         * @param size - size of the input and output buffers.
+         */
+        explicit FdStreamBuf(int fd, std::size_t size = 64 * 1024);
+
+        FdStreamBuf(const FdStreamBuf&) = delete;
+        FdStreamBuf& operator=(const FdStreamBuf&) = delete;
+
+        /**
+         * @brief Flushes the output buffer.
+         */
+        ~FdStreamBuf() override;
+
+    protected:
+
+        int_type underflow() override;
+        int_type overflow(int_type ch) override;
+        int sync() override;
+
+    private:
+
+        bool flush();
+
+        int m_fd;                   /// File descriptor.
+        std::vector<char> m_in;     /// Input buffer.
+        std::vector<char> m_out;    /// Output buffer.
+    };
+}
+
+#endif /* !FDSTREAM_H */
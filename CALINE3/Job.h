@@ -21,12 +21,14 @@
 #include <vector>
 
 #include "Receptor.h"
+#include "Memory.h"
 #include "Meteo.h"
 #include "Link.h"
 
 // Units required/suplementary:
 #include "Centimeter.h"
 #include "Centimeter_Sec.h"
+#include "Microgram_Meter3.h"
 #include "Minute.h"
 
 namespace CALINE3
@@ -147,13 +149,13 @@ namespace CALINE3
         ///
 
         /// @brief Meteo collection.
-        std::vector<Meteo> Meteos;
+        TrackedVector<Meteo, Subsystem::Jobs> Meteos;
 
         /// @brief Link collection.
-        std::vector<Link> Links;
+        TrackedVector<Link, Subsystem::Jobs> Links;
 
         /// @brief Receptor collection.
-        std::vector<Receptor> Receptors;
+        TrackedVector<Receptor, Subsystem::Jobs> Receptors;
 
         ///////////////////////////////////////////////////////////////////
         ///
@@ -201,9 +203,6 @@ namespace CALINE3
             RFAC_3CM_007(pow(Z0 / Z0_3CM, 0.07)),
             RFAC_10CM_007(pow(Z0 / Z0_10CM, 0.07))
         {
-            Receptors = std::vector<Receptor>();
-            Links = std::vector<Link>();
-            Meteos = std::vector<Meteo>();
         }
 
         void setRUN(std::string run) { RUN = run; }
@@ -215,5 +214,8 @@ namespace CALINE3
 
         friend std::ostream& operator<<(std::ostream& os, const Job& job);
     };
+
+    /// @brief Mass concentration matrix MC[links][receptors].
+    using ConcentrationMatrix = TrackedVector<TrackedVector<Microgram_Meter3, Subsystem::Matrices>, Subsystem::Matrices>;
 }
 #endif /* !JOB_H */
@@ -1,4 +1,9 @@
+#include <sstream>
+
 #include "JobReader.h"
+#include "PerfCounters.h"
+#include "Phases.h"
+#include "Trace.h"
 
 namespace CALINE3
 {
@@ -9,12 +14,41 @@ namespace CALINE3
 
     bool JobReader::Read()
     {
+        ScopedPhase parse{ Phase::Parse };
+        TraceSpan span{ "read job", "reader" };
+        ScopedCounters counters{ Stage::Parse };
+        return m_pool ? ReadParallel() : ReadJob(m_job);
+    }
+
+    std::optional<Job> JobReader::Next()
+    {
+        ScopedPhase parse{ Phase::Parse };
+        TraceSpan span{ "read job", "reader" };
+        ScopedCounters counters{ Stage::Parse };
+        std::optional<Job> job;
+        if (m_pool)
+        {
+            if (!ReadParallel())
+                return std::nullopt;
+            job.emplace(std::move(*m_job));
+            m_job.reset();
+        }
+        else if (!ReadJob(job))
+        {
+            return std::nullopt;
+        }
+        return job;
+    }
+
+    bool JobReader::ReadJob(std::optional<Job>& place)
+    {
+        place.reset();
         try
         {
             std::string line;
             if (read_line(line))
             {
-                m_jobs.emplace_back(
+                Job& job = place.emplace(
                     /*ORDINAL*/ m_ordinal++,
                     /*JOB*/     trim(line.substr(0, 40)),
                     /*ATIM*/    Minute(stod(line.substr(40, 4))),
@@ -25,7 +59,6 @@ namespace CALINE3
                     /*SCAL*/    stod(line.substr(60, 10))
                 );
 
-                Job& job = m_jobs.back();
                 std::size_t NL, NM;
                 if (ReadReceptors(job) &&
                     ReadRunParameters(job, NL, NM) &&
@@ -38,12 +71,125 @@ namespace CALINE3
         }
         catch (std::invalid_argument const& ex)
         {
-            std::cerr << m_id << ": file corrupted at line " << m_lineno << " (" << ex.what() << ")." << std::endl;
+            m_log << m_id << ": file corrupted at line " << m_lineno << " (" << ex.what() << ")." << std::endl;
             m_error = true;
         }
+        place.reset();
         return false;
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+    /// 
+    ///      Parallel reading
+    ///
+
+    bool JobReader::ReadParallel()
+    {
+        m_job.reset();
+
+        // Keep the workers busy with the Jobs found ahead:
+        while (!m_scanned && (m_pending.size() < m_lookahead))
+        {
+            Chunk chunk;
+            if (!ScanJob(chunk))
+            {
+                m_scanned = true;
+                break;
+            }
+            m_pending.push_back(
+                m_pool->Submit([id = m_id, chunk = std::move(chunk)]() { return Parse(id, chunk); })
+            );
+        }
+
+        if (m_pending.empty())
+            return false;
+
+        Parsed parsed = m_pending.front().get();
+        m_pending.pop_front();
+
+        if (!parsed.log.empty())
+        {
+            m_log << parsed.log << std::flush;
+        }
+        m_error = m_error || parsed.error;
+
+        if (!parsed.job)
+        {
+            // Stop at the first faulty (or incomplete) Job just like the serial reader:
+            m_scanned = true;
+            m_pending.clear();
+            return false;
+        }
+
+        m_job.emplace(std::move(*parsed.job));
+        return true;
+    }
+
+    JobReader::Parsed JobReader::Parse(const char *id, const Chunk &chunk)
+    {
+        TraceSpan span{ "parse job", "reader" };
+        ScopedCounters counters{ Stage::Parse };
+        std::istringstream is{ chunk.text };
+        std::ostringstream log;
+        JobReader parser{ id, is, log, chunk };
+
+        Parsed parsed{ std::nullopt, std::string(), false };
+        parser.ReadJob(parsed.job);
+        parsed.error = parser.m_error;
+        parsed.log = log.str();
+        return parsed;
+    }
+
+    bool JobReader::ScanJob(Chunk& chunk)
+    {
+        std::string line;
+        if (!read_line(line))
+            return false;
+
+        chunk.lineno = m_lineno - 1;
+        chunk.ordinal = m_ordinal++;
+        chunk.text.assign(line).push_back('\n');
+
+        try
+        {
+            // Only the counts are decoded here; errors (if any) are left to the parser:
+            std::size_t NR = stoul(line.substr(58, 2));
+            if (!ScanLines(chunk, NR))
+                return true;
+
+            if (!read_line(line))
+                return true;
+            chunk.text.append(line).push_back('\n');
+
+            std::size_t NL = stoi(line.substr(40, 3));
+            std::size_t NM = stoi(line.substr(43, 3));
+            ScanLines(chunk, NL + NM);
+        }
+        catch (std::exception const&)
+        {
+            // The Job is corrupted; the parser will report it (and the reading stops there).
+            m_scanned = true;
+        }
+        return true;
+    }
+
+    bool JobReader::ScanLines(Chunk& chunk, std::size_t count)
+    {
+        std::string line;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (!read_line(line))
+                return false;
+            chunk.text.append(line).push_back('\n');
+        }
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// 
+    ///      Helpers
+    ///
+
     bool JobReader::read_line(std::string& line)
     {
         bool done = std::getline(m_is, line) ? true : false;
@@ -1,11 +1,17 @@
 #ifndef JOBREADER_H
 #define JOBREADER_H
 
-#include <istream>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <optional>
 #include <regex>
 #include <string>
 
 #include "Job.h"
+#include "ThreadPool.h"
 
 namespace CALINE3
 {
@@ -22,10 +28,96 @@ namespace CALINE3
          * @param is - input stream to read Job(s) from. 
         */
         JobReader(const char *id, std::istream &is)
-            : m_id(id), m_is(is), m_lineno(0), m_error(false), m_jobs(), m_ordinal(0)
+            : m_id(id), m_is(is), m_log(std::cerr), m_lineno(0), m_error(false), m_job(), m_ordinal(0),
+              m_pool(nullptr), m_lookahead(0), m_pending(), m_scanned(false)
         {
         }
 
+        /**
+         * @brief JobReader constructor (with errors reported to the given log).
+         * @param id - input stream identity (e.g. file path),
+         * @param is - input stream to read Job(s) from,
+         * @param log - error log.
+        */
+        JobReader(const char *id, std::istream &is, std::ostream &log)
+            : m_id(id), m_is(is), m_log(log), m_lineno(0), m_error(false), m_job(), m_ordinal(0),
+              m_pool(nullptr), m_lookahead(0), m_pending(), m_scanned(false)
+        {
+        }
+
+        /**
+         * @brief Parallel JobReader constructor.
+         * @param id - input stream identity (e.g. file path),
+         * @param is - input stream to read Job(s) from,
+         * @param pool - worker threads to parse Jobs on,
+         * @param lookahead - max number of Jobs being parsed ahead (0 = twice the pool size).
+         * @remarks The input is pre-scanned for Job boundaries (using NR, NL and NM counts)
+         * and the Jobs found are parsed concurrently, but handed out in the input order.
+         * Errors are reported (in order) against the global input line numbers.
+        */
+        JobReader(const char *id, std::istream &is, ThreadPool &pool, std::size_t lookahead = 0)
+            : m_id(id), m_is(is), m_log(std::cerr), m_lineno(0), m_error(false), m_job(), m_ordinal(0),
+              m_pool(&pool), m_lookahead(lookahead ? lookahead : 2 * pool.Size()), m_pending(), m_scanned(false)
+        {
+        }
+
+        JobReader(const JobReader&) = delete;
+        JobReader& operator=(const JobReader&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////////
+        /// 
+        ///      Iterator
+        ///
+        ///      Single-pass (input) iterator over the jobs of the input stream:
+        ///      each increment reads the next job in place of the previous one,
+        ///      so the reader never holds more than a single job, e.g.
+        ///
+        ///          for (Job& job : reader) { ... }
+        ///
+        ///      The job can be moved out (std::move(*it)) to take its ownership.
+        ///
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Job;
+            using difference_type = std::ptrdiff_t;
+            using pointer = Job*;
+            using reference = Job&;
+
+            /** @brief End-of-input iterator. */
+            iterator() : m_reader(nullptr) {}
+
+            /** @brief Iterator positioned at the next job read from the reader. */
+            explicit iterator(JobReader *reader) : m_reader(reader) { ++(*this); }
+
+            reference operator*() const { return *m_reader->m_job; }
+            pointer operator->() const { return &*m_reader->m_job; }
+
+            iterator& operator++()
+            {
+                if (!m_reader->Read()) m_reader = nullptr;
+                return *this;
+            }
+
+            bool operator==(const iterator& other) const { return m_reader == other.m_reader; }
+            bool operator!=(const iterator& other) const { return m_reader != other.m_reader; }
+
+        private:
+            JobReader *m_reader;    /// Reader (nullptr at the end of input).
+        };
+
+        /**
+         * @brief Reads the first (next) job and returns an iterator positioned on it.
+         */
+        iterator begin() { return iterator(this); }
+
+        /**
+         * @brief End-of-input iterator.
+         */
+        iterator end() { return iterator(); }
+
         ////////////////////////////////////////////////////////////////////////////
         /// 
         ///      Method(s)
@@ -41,15 +133,82 @@ namespace CALINE3
          */
         bool Read();
 
+        /**
+         * @brief Read the next Job and hand it over to the caller.
+         * @return Job read or @c std::nullopt at the end of input (or on error, see ErrorFound()).
+         * @remarks The reader does not retain the returned Job (nor any of the previous ones).
+         */
+        std::optional<Job> Next();
+
         /**
          * @brief Returns the last read job.
+         * @pre The last call to Read() returned @c true.
         */
-        const Job &LastJob() { return m_jobs.back(); }
+        const Job &LastJob() { return *m_job; }
 
         bool ErrorFound() { return m_error; }
 
     private:
 
+        /**
+         * @brief Job text (as found by the pre-scan) along with its position in the input.
+        */
+        struct Chunk
+        {
+            std::string text;       /// Job lines.
+            std::size_t lineno;     /// Number of input lines preceding the Job.
+            std::size_t ordinal;    /// Job ordinal number.
+        };
+
+        /**
+         * @brief Outcome of parsing a Chunk.
+        */
+        struct Parsed
+        {
+            std::optional<Job> job; /// Job read (if any),
+            std::string log;        /// error messages,
+            bool error;             /// error found?
+        };
+
+        /**
+         * @brief Chunk parser constructor (for parallel parsing).
+        */
+        JobReader(const char *id, std::istream &is, std::ostream &log, const Chunk &chunk)
+            : m_id(id), m_is(is), m_log(log), m_lineno(chunk.lineno), m_error(false), m_job(), m_ordinal(chunk.ordinal),
+              m_pool(nullptr), m_lookahead(0), m_pending(), m_scanned(false)
+        {
+        }
+
+        /**
+         * @brief Parses a Chunk (on a worker thread).
+        */
+        static Parsed Parse(const char *id, const Chunk &chunk);
+
+        /**
+         * @brief Read the next Job parsed on a worker thread (see Read()).
+        */
+        bool ReadParallel();
+
+        /**
+         * @brief Collects the lines of the next Job (without parsing them, but the counts).
+         * @param chunk - Job text and position.
+         * @return @c true when (at least a part of) Job has been found, @c false otherwise (EOF).
+        */
+        bool ScanJob(Chunk& chunk);
+
+        /**
+         * @brief Appends the given number of lines to a Chunk.
+         * @return @c true when all lines have been read, @c false otherwise (EOF).
+        */
+        bool ScanLines(Chunk& chunk, std::size_t count);
+
+        /**
+         * @brief Read the next Job into the given place (replacing its previous content).
+         * @param place - place for the Job to read.
+         * @return @c true on successfully read Job, @c false otherwise.
+        */
+        bool ReadJob(std::optional<Job>& place);
+
         /**
          * @brief Read the next line from the input stream
          * (the lines are numbered to indicate the position of a possible error).
@@ -116,16 +275,23 @@ namespace CALINE3
         ///      Fields
         ///
 
-        std::regex leading_space_regex{ "^\\s+" };
-        std::regex trailing_space_regex{ "\\s+$" };
-        std::string empty{ "" };
+        // Shared (read-only) by all readers, including those parsing on worker threads:
+        static inline const std::regex leading_space_regex{ "^\\s+" };
+        static inline const std::regex trailing_space_regex{ "\\s+$" };
+        static inline const std::string empty{ "" };
 
         const char* m_id;           /// Input stream identity (e.g. file path).
         std::istream& m_is;         /// Input stream.
+        std::ostream& m_log;        /// Error log.
         std::size_t m_lineno;       /// Input stream line number.
         bool m_error;               /// Error found while reading the input stream?
-        std::vector<Job> m_jobs;    /// List of read Jobs.
+        std::optional<Job> m_job;   /// The last read Job (the only one retained).
         std::size_t m_ordinal;      /// JOB ordinal number.
+
+        ThreadPool* m_pool;                         /// Worker threads (nullptr = serial reading).
+        std::size_t m_lookahead;                    /// Max number of Jobs parsed ahead.
+        std::deque<std::future<Parsed>> m_pending;  /// Jobs being parsed (in the input order).
+        bool m_scanned;                             /// End of input reached by the pre-scan?
     };
 }
 
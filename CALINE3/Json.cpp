@@ -0,0 +1,42 @@
+#include "Json.h"
+
+namespace CALINE3
+{
+    namespace Json
+    {
+        std::string Quoted(const std::string& text)
+        {
+            static constexpr const char *HEX = "0123456789abcdef";
+
+            std::string s{ "\"" };
+            s.reserve(text.size() + 2);
+            for (char c : text)
+            {
+                switch (c)
+                {
+                case '"':  s += "\\\""; break;
+                case '\\': s += "\\\\"; break;
+                case '\b': s += "\\b"; break;
+                case '\f': s += "\\f"; break;
+                case '\n': s += "\\n"; break;
+                case '\r': s += "\\r"; break;
+                case '\t': s += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        s += "\\u00";
+                        s.push_back(HEX[(c >> 4) & 0xF]);
+                        s.push_back(HEX[c & 0xF]);
+                    }
+                    else
+                    {
+                        s.push_back(c);
+                    }
+                    break;
+                }
+            }
+            s.push_back('"');
+            return s;
+        }
+    }
+}
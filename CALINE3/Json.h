@@ -0,0 +1,37 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+
+namespace CALINE3
+{
+    /**
+     * @brief Helpers shared by the JSON emitters (counters, phases, trace, memory).
+     */
+    namespace Json
+    {
+        /**
+         * @brief JSON string literal of a text: quotes, backslashes and control characters
+         * (below 0x20) escaped, e.g. a job title with a tab in it.
+         */
+        std::string Quoted(const std::string& text);
+    }
+}
+
+#endif /* !JSON_H */
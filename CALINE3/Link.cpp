@@ -9,20 +9,25 @@ namespace CALINE3
     ///     Methods
     ///
 
-    std::tuple<Meter, Meter, Meter> Link::TransformReceptorCoordinates(const Receptor &rcp) const
+    std::tuple<Meter, Meter, Meter> Link::TransformReceptorCoordinates(Meter XR, Meter YR, Meter ZR) const
     {
-        Meter LR = Distance(XL1, YL1, rcp.XR, rcp.YR);
+        Meter LR = Distance(XL1, YL1, XR, YR);
 
         /// Receptor angle with respect to link
         Radian lbrg = Radian(m_lbrg);
 
-        Radian GAMMA = Azimuth(XL1, YL1, rcp.XR, rcp.YR) - lbrg;
+        Radian GAMMA = Azimuth(XL1, YL1, XR, YR) - lbrg;
 
         Meter D = LR * sin(GAMMA);
         Meter L = LR * cos(GAMMA) - m_ll;
 
-        Meter Z = rcp.ZR;
-        if ((TYP != "AG") && (TYP != "BR"))
+        return std::make_tuple(D, L, ReceptorLevel(D, ZR));
+    }
+
+    Meter Link::ReceptorLevel(Meter D, Meter ZR) const
+    {
+        Meter Z = ZR;
+        if (m_slope)
         {
             Meter D1 = m_w2 + 2.0 * abs(HL);
             if (abs(D) < D1)
@@ -31,8 +36,7 @@ namespace CALINE3
                 Z -= (abs(D) <= m_w2) ? HL : HL * (1.0 - (abs(D) - m_w2) / (2.0 * abs(HL)));
             }
         }
-
-        return std::make_tuple(D, L, Z);
+        return Z;
     }
 
     double Link::DepressedSectionFactor(Meter D) const
@@ -1,6 +1,8 @@
 #ifndef LINK_H
 #define LINK_H
 
+#include <iterator>
+#include <string>
 #include <tuple>
 
 #include "Receptor.h"
@@ -47,6 +49,12 @@ namespace CALINE3
 
         static constexpr Meter DEPRESSED_SECTION_DEPTH_THRESHOLD{ -1.5 };
 
+        /// @brief Link type codes (as used by the columnar input).
+        enum TypeCode : unsigned char { AG = 0, BR = 1, FL = 2, DP = 3 };
+
+        /// @brief Link type names (indexed by TypeCode).
+        static constexpr const char *TYPE_NAME[4] = { "AG", "BR", "FL", "DP" };
+
     private:
 
         /// @brief Link tags
@@ -137,6 +145,9 @@ namespace CALINE3
         /// the empirically derived factor based on Los Angeles data. 
         double m_dstr;
 
+        /// @brief Receptor level to be adjusted for 2:1 side slopes (link types other than AG and BR)?
+        bool m_slope;
+
     public:
 
         ///////////////////////////////////////////////////////////////////
@@ -189,6 +200,9 @@ namespace CALINE3
             // Height adjusted for the link type
             m_h = ((TYP == "DP") || (TYP == "FL")) ? Meter(0.0) : HL;
 
+            // Receptor level adjusted for the link type (see TransformReceptorCoordinates):
+            m_slope = (TYP != "AG") && (TYP != "BR");
+
             // Highway half-width
             m_w2 = WL / 2.0;
 
@@ -224,9 +238,9 @@ namespace CALINE3
         ///
 
         /**
-         * @brief Link tag
+         * @brief Link tag (A..T as in CALINE3; the link number beyond the 20 links CALINE3 was limited to).
          */
-        std::string COD() const { return TAG[ORDINAL]; }
+        std::string COD() const { return (ORDINAL < std::size(TAG)) ? TAG[ORDINAL] : std::to_string(ORDINAL + 1); }
 
         /**
          * @brief Height [m] adjusted for the link type (see also HL).
@@ -271,7 +285,27 @@ namespace CALINE3
          * L - receptor offset relative to the link start position, measured parallel to the link,
          * Z - receptor level adjusted for the link type.
          */
-        std::tuple<Meter, Meter, Meter> TransformReceptorCoordinates(const Receptor &rcp) const;
+        std::tuple<Meter, Meter, Meter> TransformReceptorCoordinates(const Receptor &rcp) const
+        {
+            return TransformReceptorCoordinates(rcp.XR, rcp.YR, rcp.ZR);
+        }
+
+        /**
+         * @brief Get receptor coordinates relative to the link start position.
+         * @param XR - receptor X-coordinate,
+         * @param YR - receptor Y-coordinate,
+         * @param ZR - receptor Z-coordinate.
+         * @returns A tuple (D, L, Z) as above.
+         */
+        std::tuple<Meter, Meter, Meter> TransformReceptorCoordinates(Meter XR, Meter YR, Meter ZR) const;
+
+        /**
+         * @brief Receptor level adjusted for the link type.
+         * @param D - receptor-link distance (see TransformReceptorCoordinates),
+         * @param ZR - receptor Z-coordinate.
+         * @returns Z as returned by TransformReceptorCoordinates.
+         */
+        Meter ReceptorLevel(Meter D, Meter ZR) const;
 
         /**
          * @brief Depressed section factor for a receptor at the distance given.
@@ -34,7 +34,7 @@ namespace CALINE3
         return true;
     }
 
-    Microgram_Meter_Sec LinkElement::SourceStrength(Microgram_Meter_Sec QE, Meter SGY, Meter YE) const
+    Microgram_Meter_Sec LinkElement::SourceStrength(Microgram_Meter_Sec QE, Meter SGY, Meter YE, ErfVariant erf) const
     {
         // Constants
         static const double SQRT_2{ std::sqrt(2.0) };
@@ -52,13 +52,21 @@ namespace CALINE3
         Y[4] = Y[3] - EN2;
         Y[5] = Y[4] - EN2;
 
+        // Error function at the subelement edges (each edge shared by two subelements):
+        double X[6], E[6];
+        for (int j = 0; j < 6; j++)
+        {
+            X[j] = Y[j] / SGY / SQRT_2;
+        }
+        Erf(erf, X, E, 6);
+
         // Add up strengths of all subelements
         Microgram_Meter_Sec FAC2{ 0.0 };
         for (int j = 0; j < 5; j++)
         {
             FAC2 += QE * WT[j] *
                 /* PD = normal probability density = */
-                (Erf(Y[j] / SGY / SQRT_2) - Erf(Y[j + 1] / SGY / SQRT_2)) / 2.0;
+                (E[j] - E[j + 1]) / 2.0;
         }
 
         return FAC2;
@@ -117,10 +117,11 @@ namespace CALINE3
          * @brief Computes element source strength [microgram/(m*s)].
          * @param QE - central subelement lineal strength [microgram/(m*s)],
          * @param SGY - sigmay/horizontal dispersion parameter [m],
-         * @param YE - plume centerline offset [m].
+         * @param YE - plume centerline offset [m],
+         * @param erf - error function variant.
          * @returns Element source strength [microgram/(m*s)].
          */
-        Microgram_Meter_Sec SourceStrength(Microgram_Meter_Sec QE, Meter SGY, Meter YE) const;
+        Microgram_Meter_Sec SourceStrength(Microgram_Meter_Sec QE, Meter SGY, Meter YE, ErfVariant erf = ErfVariant::AbramowitzStegun) const;
 
         ////////////////////////////////////////////////////////////////////////////
         /// 
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+#include "LinkMerge.h"
+
+namespace CALINE3
+{
+    namespace
+    {
+        /// @brief Tolerated sine of the angle between merged links (digitizing rounding).
+        constexpr double COLLINEAR = 1e-9;
+
+        /// @brief Length of a chain of links running from (x1, y1) to (x2, y2).
+        Meter span(const Link& first, const Link& last)
+        {
+            return Meter(std::hypot((last.XL2 - first.XL1).value(), (last.YL2 - first.YL1).value()));
+        }
+
+        /// @brief Link endpoint (-0.0 folded into 0.0, so that equal points hash alike).
+        using Point = std::pair<double, double>;
+
+        Point point(Meter x, Meter y)
+        {
+            return Point{ x.value() + 0.0, y.value() + 0.0 };
+        }
+
+        struct PointHash
+        {
+            std::size_t operator()(const Point& p) const
+            {
+                const std::size_t h = std::hash<double>{}(p.first);
+                return h ^ (std::hash<double>{}(p.second) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+            }
+        };
+
+        /// @brief Links (in link order) per endpoint.
+        using Endpoints = std::unordered_map<Point, std::vector<std::size_t>, PointHash>;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Methods
+    ///
+
+    bool LinkMerger::Continues(const Link& a, const Link& b)
+    {
+        if ((a.XL2 != b.XL1) || (a.YL2 != b.YL1) ||
+            (a.TYP != b.TYP) || (a.HL != b.HL) || (a.WL != b.WL) || (a.VPHL != b.VPHL) || (a.EFL != b.EFL))
+            return false;
+
+        const double ax = (a.XL2 - a.XL1).value();
+        const double ay = (a.YL2 - a.YL1).value();
+        const double bx = (b.XL2 - b.XL1).value();
+        const double by = (b.YL2 - b.YL1).value();
+        const double cross = ax * by - ay * bx;
+        const double dot = ax * bx + ay * by;
+        return (dot > 0.0) && (std::abs(cross) <= COLLINEAR * std::hypot(ax, ay) * std::hypot(bx, by));
+    }
+
+    Job LinkMerger::Merge(const Job& site, std::vector<LinkGroup>& groups)
+    {
+        const std::size_t NL = site.Links.size();
+        const auto& links = site.Links;
+
+        // Links indexed by their start and end points (a chain grows by looking its ends up):
+        Endpoints starts, ends;
+        starts.reserve(NL);
+        ends.reserve(NL);
+        for (std::size_t L = 0; L < NL; L++)
+        {
+            starts[point(links[L].XL1, links[L].YL1)].push_back(L);
+            ends[point(links[L].XL2, links[L].YL2)].push_back(L);
+        }
+
+        // Chains grown forward, then backward, from each link not merged yet (in link order):
+        groups.clear();
+        std::vector<bool> merged(NL, false);
+        auto next = [&](const Endpoints& index, Meter x, Meter y, auto&& fits) -> std::size_t {
+            auto found = index.find(point(x, y));
+            if (found != index.end())
+            {
+                for (std::size_t K : found->second)
+                {
+                    if (!merged[K] && fits(K))
+                        return K;
+                }
+            }
+            return NL;
+        };
+        for (std::size_t L = 0; L < NL; L++)
+        {
+            if (merged[L])
+                continue;
+            merged[L] = true;
+            LinkGroup chain{ L };
+            for (;;)
+            {
+                const Link& tail = links[chain.back()];
+                const std::size_t K = next(starts, tail.XL2, tail.YL2, [&](std::size_t K) {
+                    return Continues(tail, links[K]) && (span(links[chain.front()], links[K]) <= Link::MAX_LENGTH);
+                });
+                if (K == NL)
+                    break;
+                merged[K] = true;
+                chain.push_back(K);
+            }
+            LinkGroup before;   // (links prepended, nearest first)
+            for (;;)
+            {
+                const Link& head = links[before.empty() ? L : before.back()];
+                const std::size_t K = next(ends, head.XL1, head.YL1, [&](std::size_t K) {
+                    return Continues(links[K], head) && (span(links[K], links[chain.back()]) <= Link::MAX_LENGTH);
+                });
+                if (K == NL)
+                    break;
+                merged[K] = true;
+                before.push_back(K);
+            }
+            chain.insert(chain.begin(), before.rbegin(), before.rend());
+            groups.push_back(std::move(chain));     // (in the order of the first original link, L being the lowest)
+        }
+
+        Job job{ site.ORDINAL, site.JOB, site.ATIM, site.Z0, site.VS1, site.VD1, site.NR, site.SCAL };
+        job.setRUN(site.RUN);
+        job.Links.reserve(groups.size());
+        for (auto const& group : groups)
+        {
+            const Link& first = links[group.front()];
+            const Link& last = links[group.back()];
+            const std::size_t head = *std::min_element(group.begin(), group.end());
+            std::string lnk = links[head].LNK;
+            if (group.size() > 1)
+                lnk += " +" + std::to_string(group.size() - 1);
+            job.Links.emplace_back(
+                job.Links.size(), lnk, first.TYP,
+                first.XL1, first.YL1, last.XL2, last.YL2,
+                first.VPHL, first.EFL, first.HL, first.WL
+            );
+        }
+        job.Receptors.reserve(site.Receptors.size());
+        for (auto const& receptor : site.Receptors)
+        {
+            job.Receptors.push_back(receptor);
+        }
+        job.Meteos.reserve(site.Meteos.size());
+        for (auto const& meteo : site.Meteos)
+        {
+            job.Meteos.push_back(meteo);
+        }
+        return job;
+    }
+
+    void LinkMerger::PrintSummary(std::ostream& os, const Job& site, const std::vector<LinkGroup>& groups)
+    {
+        std::ostringstream line;
+        line << "Links merged: " << site.Links.size() << " -> " << groups.size() << " :: " << site.JOB;
+        for (auto const& group : groups)
+        {
+            if (group.size() < 2)
+                continue;
+            const std::size_t head = *std::min_element(group.begin(), group.end());
+            line << " :: " << site.Links[head].LNK << " +" << group.size() - 1 << " =";
+            const char *separator = " ";
+            for (std::size_t L : group)
+            {
+                line << separator << site.Links[L].LNK;
+                separator = ", ";
+            }
+        }
+        os << line.str() << std::endl;
+    }
+}
@@ -0,0 +1,65 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef LINKMERGE_H
+#define LINKMERGE_H
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "Job.h"
+
+namespace CALINE3
+{
+    /// @brief Original links (indices, in the chain order) merged into one.
+    using LinkGroup = std::vector<std::size_t>;
+
+    /**
+     * @brief Merges contiguous collinear links into single equivalent links (optional preprocessing).
+     * @remarks Road centerlines digitized as many short segments multiply the per-link setup cost
+     * (Plume constructor, element walk from the receptor each time). Links are chained when one
+     * starts exactly where the other ends, both run in the same direction and they have the same
+     * TYP, HL, WL, VPHL and EFL; chains are cut at Link::MAX_LENGTH. The concentration of a merged
+     * link approximates the sum of its links (their elements are laid out afresh over its length).
+     */
+    class LinkMerger
+    {
+    public:
+
+        /**
+         * @brief Can the link b continue the link a (see above)?
+         */
+        static bool Continues(const Link& a, const Link& b);
+
+        /**
+         * @brief Job with the links merged (the same receptors and meteos).
+         * @param site - job,
+         * @param groups - groups[l]: original links of the merged link l (output).
+         * @returns The job; a merged link takes the place (and the description,
+         * suffixed with "+N" for N more links) of the first link of its group.
+         */
+        static Job Merge(const Job& site, std::vector<LinkGroup>& groups);
+
+        /**
+         * @brief Prints the reduction and the merged groups, e.g.
+         * "Links merged: 12 -> 5 :: JOB :: LINK A +3 = LINK A, LINK B, LINK C, LINK D".
+         */
+        static void PrintSummary(std::ostream& os, const Job& site, const std::vector<LinkGroup>& groups);
+    };
+}
+
+#endif /* !LINKMERGE_H */
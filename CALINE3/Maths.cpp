@@ -1,3 +1,5 @@
+#include <stdexcept>
+
 #include "Maths.h"
 
 namespace CALINE3::Maths
@@ -38,4 +40,67 @@ namespace CALINE3::Maths
         double erfx = exp(-x * x) * t * (0.254829592 + t * (-0.284496736 + t * (1.421413741 + t * (-1.453152027 + t * 1.061405429))));
         return (x < 0) ? erfx - 1.0 : 1.0 - erfx;
     }
+
+    double ErfFast(double x)
+    {
+        double t = 1.0 / (1.0 + 0.47047 * ((x < 0) ? -x : x));
+        double erfx = exp(-x * x) * t * (0.3480242 + t * (-0.0958798 + t * 0.7478556));
+        return (x < 0) ? erfx - 1.0 : 1.0 - erfx;
+    }
+
+    double Erf(ErfVariant variant, double x)
+    {
+        switch (variant)
+        {
+            case ErfVariant::Std:  return std::erf(x);
+            case ErfVariant::Fast: return ErfFast(x);
+            default:               return Erf(x);
+        }
+    }
+
+    void Erf(ErfVariant variant, const double *x, double *y, std::size_t n)
+    {
+        switch (variant)
+        {
+            case ErfVariant::Vector:
+                // Erf(x) with the sign applied last ((erfx - 1) == -(1 - erfx) exactly):
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    double t = 1.0 / (1.0 + 0.3275911 * std::abs(x[i]));
+                    double erfx = std::exp(-x[i] * x[i]) * t * (0.254829592 + t * (-0.284496736 + t * (1.421413741 + t * (-1.453152027 + t * 1.061405429))));
+                    double r = 1.0 - erfx;
+                    y[i] = (x[i] < 0) ? -r : r;
+                }
+                break;
+            case ErfVariant::Std:
+                for (std::size_t i = 0; i < n; i++) y[i] = std::erf(x[i]);
+                break;
+            case ErfVariant::Fast:
+                for (std::size_t i = 0; i < n; i++) y[i] = ErfFast(x[i]);
+                break;
+            default:
+                for (std::size_t i = 0; i < n; i++) y[i] = Erf(x[i]);
+                break;
+        }
+    }
+
+    ErfVariant ParseErfVariant(const std::string& name)
+    {
+        for (int v = 0; v < 4; v++)
+        {
+            if (name == ERF_VARIANT_NAME[v])
+                return static_cast<ErfVariant>(v);
+        }
+        throw std::invalid_argument("unknown erf variant \"" + name + "\" (expected as, std, fast or vector).");
+    }
+
+    Summation ParseSummation(const std::string& name)
+    {
+        for (int s = 0; s < 3; s++)
+        {
+            if (name == SUMMATION_NAME[s])
+                return static_cast<Summation>(s);
+        }
+        throw std::invalid_argument("unknown summation \"" + name + "\" (expected sequential, pairwise or compensated).");
+    }
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define MATHS_H
 
 #include <cmath>
+#include <cstddef>
+#include <string>
 
 // Units required/suplementary:
 #include "Degree.h"
@@ -21,6 +23,120 @@ namespace CALINE3::Maths
     ///  Constants
     ///
 
+    /**
+     * @brief Gauss error function implementations.
+     */
+    enum class ErfVariant
+    {
+        AbramowitzStegun,   /// A&S 7.1.26 (maximum error: 1.5e-7), as in the original CALINE3 (default).
+        Std,                /// std::erf (accurate to a few ulp, slower).
+        Fast,               /// A&S 7.1.25, lower order (maximum error: 2.5e-5).
+        Vector              /// A&S 7.1.26 evaluated branch-free over arrays (the same results as AbramowitzStegun).
+    };
+
+    /// @brief ErfVariant names (as used on the command line).
+    constexpr const char *ERF_VARIANT_NAME[] = { "as", "std", "fast", "vector" };
+
+    /**
+     * @brief Ways to add up the element contributions of a link.
+     */
+    enum class Summation
+    {
+        Sequential,     /// Left to right, as in the original CALINE3 (default).
+        Pairwise,       /// Fixed binary tree over the element order (blocks of 2^k elements summed first).
+        Compensated     /// Left to right, compensated (Neumaier): error independent of the number of elements.
+    };
+
+    /// @brief Summation names (as used on the command line).
+    constexpr const char *SUMMATION_NAME[] = { "sequential", "pairwise", "compensated" };
+
+    /**
+     * @brief Math functions (and shortcuts) the computation is to use.
+     */
+    struct MathPolicy
+    {
+        ErfVariant Erf = ErfVariant::AbramowitzStegun;
+        Summation Sum = Summation::Sequential;
+        bool SharedDispersion = false;  /// Links differing in emission only (VPHL, EFL) scaled from one dispersion (see Engine::DispersionSources).
+    };
+
+    /**
+     * @brief Left to right sum (as the original CALINE3 adds up the element contributions).
+     */
+    class SequentialSum
+    {
+    public:
+        void Add(double term) { m_sum += term; }
+        double Total() const { return m_sum; }
+        void Clear() { m_sum = 0.0; }
+
+    private:
+        double m_sum = 0.0;
+    };
+
+    /**
+     * @brief Pairwise sum: terms are added up along a fixed binary tree over their order
+     * (each aligned block of 2^k terms summed before it is added to anything else).
+     * @remarks The result depends on the terms and their order only, so the sum stays the same
+     * however the terms are split for evaluation (along 2^k blocks); the rounding error grows as log(n).
+     */
+    class PairwiseSum
+    {
+    public:
+        void Add(double term)
+        {
+            // Binary counter: a new term carries over the complete blocks of the same size.
+            double sum = term;
+            std::size_t size = 1;
+            while ((m_depth > 0) && (m_size[m_depth - 1] == size))
+            {
+                sum = m_sum[--m_depth] + sum;
+                size *= 2;
+            }
+            m_sum[m_depth] = sum;
+            m_size[m_depth++] = size;
+        }
+
+        double Total() const
+        {
+            // Incomplete blocks, the smallest (latest) first:
+            double total = 0.0;
+            for (std::size_t i = m_depth; i > 0; i--)
+            {
+                total = m_sum[i - 1] + total;
+            }
+            return total;
+        }
+
+        void Clear() { m_depth = 0; }
+
+    private:
+        double m_sum[64];
+        std::size_t m_size[64];
+        std::size_t m_depth = 0;
+    };
+
+    /**
+     * @brief Compensated (Kahan-Babuska-Neumaier) sum.
+     */
+    class CompensatedSum
+    {
+    public:
+        void Add(double term)
+        {
+            const double sum = m_sum + term;
+            m_compensation += (std::abs(m_sum) >= std::abs(term)) ? (m_sum - sum) + term : (term - sum) + m_sum;
+            m_sum = sum;
+        }
+
+        double Total() const { return m_sum + m_compensation; }
+        void Clear() { m_sum = 0.0; m_compensation = 0.0; }
+
+    private:
+        double m_sum = 0.0;
+        double m_compensation = 0.0;
+    };
+
     ///////////////////////////////////////////////////////////////////////
     ///
     ///  Metrology math
@@ -103,5 +219,35 @@ namespace CALINE3::Maths
      * @remarks See: Abramowitz and Stegun approximation in Wikipedia (http://en.wikipedia.org/wiki/Error_function).
      */
     double Erf(double x);
+
+    /**
+     * @brief Gauss error function (maximum error: 2.5e-5).
+     * @remarks Lower order Abramowitz and Stegun approximation (7.1.25).
+     */
+    double ErfFast(double x);
+
+    /**
+     * @brief Gauss error function of the given variant.
+     */
+    double Erf(ErfVariant variant, double x);
+
+    /**
+     * @brief Gauss error function of the given variant over an array: y[i] = erf(x[i]), i = 0..n-1.
+     * @remarks ErfVariant::Vector is evaluated in a branch-free loop the compiler can vectorize
+     * (given a vector exp, e.g. MSVC /O2 or GCC -ffast-math with glibc libmvec).
+     */
+    void Erf(ErfVariant variant, const double *x, double *y, std::size_t n);
+
+    /**
+     * @brief ErfVariant of the name (see ERF_VARIANT_NAME).
+     * @throws std::invalid_argument for an unknown name.
+     */
+    ErfVariant ParseErfVariant(const std::string& name);
+
+    /**
+     * @brief Summation of the name (see SUMMATION_NAME).
+     * @throws std::invalid_argument for an unknown name.
+     */
+    Summation ParseSummation(const std::string& name);
 }
 #endif /* !MATHS_H */
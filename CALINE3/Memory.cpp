@@ -0,0 +1,206 @@
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "Memory.h"
+#include "Json.h"
+
+namespace CALINE3
+{
+    namespace
+    {
+        MemoryUsage usage(const std::atomic<std::size_t> (&peak)[SUBSYSTEMS + 1])
+        {
+            MemoryUsage u;
+            for (std::size_t i = 0; i <= SUBSYSTEMS; i++)
+            {
+                u.Current[i] = Memory::Detail::s_current[i].load(std::memory_order_relaxed);
+                u.Peak[i] = peak[i].load(std::memory_order_relaxed);
+            }
+            return u;
+        }
+
+        /// @brief Usage as JSON object members.
+        void members(std::ostream& os, const MemoryUsage& u)
+        {
+            os << "\"current\": { ";
+            for (std::size_t i = 0; i < SUBSYSTEMS; i++)
+            {
+                os << '"' << SUBSYSTEM_NAME[i] << "\": " << u.Current[i] << ", ";
+            }
+            os << "\"total\": " << u.Current[SUBSYSTEMS] << " }, \"peak\": { ";
+            for (std::size_t i = 0; i < SUBSYSTEMS; i++)
+            {
+                os << '"' << SUBSYSTEM_NAME[i] << "\": " << u.Peak[i] << ", ";
+            }
+            os << "\"total\": " << u.Peak[SUBSYSTEMS] << " }";
+        }
+
+        /// @brief Peaks [KiB] as table columns.
+        void columns(std::ostream& os, const MemoryUsage& u)
+        {
+            for (std::size_t i = 0; i <= SUBSYSTEMS; i++)
+            {
+                os << std::setw(13) << u.Peak[i] / 1024.0;
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Memory accounting
+    ///
+
+    namespace Memory
+    {
+        MemoryUsage Run()
+        {
+            return usage(Detail::s_peak);
+        }
+
+        MemoryUsage Window()
+        {
+            return usage(Detail::s_window);
+        }
+
+        void BeginWindow()
+        {
+            for (std::size_t i = 0; i <= SUBSYSTEMS; i++)
+            {
+                Detail::s_window[i].store(Detail::s_current[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+
+        void SetBudget(std::size_t bytes)
+        {
+            Detail::s_budget.store(bytes, std::memory_order_relaxed);
+        }
+
+        std::size_t Budget()
+        {
+            return Detail::s_budget.load(std::memory_order_relaxed);
+        }
+
+        bool Fits(std::size_t bytes)
+        {
+            const std::size_t budget = Budget();
+            const std::size_t current = Detail::s_current[SUBSYSTEMS].load(std::memory_order_relaxed);
+            return (budget == 0) || ((current <= budget) && (bytes <= budget - current));
+        }
+
+        std::size_t Available()
+        {
+            const std::size_t budget = Budget();
+            const std::size_t current = Detail::s_current[SUBSYSTEMS].load(std::memory_order_relaxed);
+            return (budget == 0) ? SIZE_MAX : (current < budget) ? budget - current : 0;
+        }
+
+        std::size_t ParseBytes(const std::string& text)
+        {
+            std::size_t pos = 0;
+            unsigned long long count = 0;
+            try
+            {
+                count = std::stoull(text, &pos);
+            }
+            catch (std::logic_error const&)
+            {
+                throw std::invalid_argument("invalid byte count.");
+            }
+            if ((text[0] == '-') || (pos + 1 < text.size()))
+                throw std::invalid_argument("invalid byte count.");
+
+            int shift = 0;
+            if (pos < text.size())
+            {
+                switch (text[pos])
+                {
+                case 'K': case 'k': shift = 10; break;
+                case 'M': case 'm': shift = 20; break;
+                case 'G': case 'g': shift = 30; break;
+                default: throw std::invalid_argument("invalid byte count suffix (K, M or G expected).");
+                }
+            }
+            return static_cast<std::size_t>(count << shift);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      MemoryLog
+    ///
+
+    void MemoryLog::Add(std::size_t job, const Entry& entry)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs[job] = entry;
+    }
+
+    std::map<std::size_t, MemoryLog::Entry> MemoryLog::Jobs() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_jobs;
+    }
+
+    void MemoryLog::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.clear();
+    }
+
+    void MemoryLog::PrintTable(std::ostream& os) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::ostringstream table;
+        table << std::fixed << std::setprecision(1);
+        table << std::left << std::setw(24) << "JOB PEAK [KiB]" << std::right;
+        for (const char *name : SUBSYSTEM_NAME)
+        {
+            table << std::setw(13) << name;
+        }
+        table << std::setw(13) << "total" << std::setw(10) << "tile" << std::endl;
+
+        for (auto const& [job, entry] : m_jobs)
+        {
+            table << std::left << std::setw(24) << (std::to_string(job + 1) + " " + entry.Title).substr(0, 23) << std::right;
+            columns(table, entry.Usage);
+            table << std::setw(10) << (entry.Tile ? std::to_string(entry.Tile) : std::string("-")) << std::endl;
+        }
+
+        const MemoryUsage run = Memory::Run();
+        table << std::left << std::setw(24) << "RUN" << std::right;
+        columns(table, run);
+        table << std::endl;
+        if (Memory::Budget())
+            table << "Budget: " << Memory::Budget() / 1024.0 << " KiB" << std::endl;
+        os << table.str();
+    }
+
+    void MemoryLog::PrintJSON(std::ostream& os) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::ostringstream json;
+        json << "{\n  \"budget\": " << Memory::Budget() << ",\n  \"run\": { ";
+        members(json, Memory::Run());
+        json << " },\n  \"jobs\": [";
+        const char *separator = "\n";
+        for (auto const& [job, entry] : m_jobs)
+        {
+            json << separator << "    { \"job\": " << job + 1 << ", \"title\": " << Json::Quoted(entry.Title) << ", \"tile\": " << entry.Tile << ", ";
+            members(json, entry.Usage);
+            json << " }";
+            separator = ",\n";
+        }
+        json << "\n  ]\n}\n";
+        os << json.str();
+    }
+
+    MemoryLog& MemoryLog::Global()
+    {
+        static MemoryLog log;
+        return log;
+    }
+}
@@ -0,0 +1,246 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace CALINE3
+{
+    /**
+     * @brief Subsystems memory is accounted for.
+     */
+    enum class Subsystem : unsigned char
+    {
+        Jobs,       /// Job collections (meteos, links, receptors).
+        Matrices,   /// Concentration matrices (and tiles).
+        Report      /// Report page and cached job sections.
+    };
+
+    /// @brief Number of subsystems.
+    constexpr std::size_t SUBSYSTEMS = 3;
+
+    /// @brief Subsystem names.
+    constexpr const char *SUBSYSTEM_NAME[SUBSYSTEMS] = { "jobs", "matrices", "report" };
+
+    /**
+     * @brief Bytes in use per subsystem (and in total, at index SUBSYSTEMS).
+     */
+    struct MemoryUsage
+    {
+        std::size_t Current[SUBSYSTEMS + 1] = {};   /// Bytes allocated now.
+        std::size_t Peak[SUBSYSTEMS + 1] = {};      /// Most bytes allocated at once.
+    };
+
+    /**
+     * @brief Memory accounting (bytes allocated through CountingAllocator) and budget.
+     * @remarks Peaks are kept for the whole run and for a window (e.g. a job, see BeginWindow).
+     */
+    namespace Memory
+    {
+        namespace Detail
+        {
+            /// @brief Counters: per subsystem and in total (index SUBSYSTEMS).
+            inline std::atomic<std::size_t> s_current[SUBSYSTEMS + 1];
+            inline std::atomic<std::size_t> s_peak[SUBSYSTEMS + 1];
+            inline std::atomic<std::size_t> s_window[SUBSYSTEMS + 1];
+            inline std::atomic<std::size_t> s_budget{ 0 };
+
+            inline void raise(std::atomic<std::size_t>& peak, std::size_t value)
+            {
+                std::size_t seen = peak.load(std::memory_order_relaxed);
+                while ((seen < value) && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            inline void add(std::size_t i, std::size_t bytes)
+            {
+                const std::size_t now = s_current[i].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+                raise(s_peak[i], now);
+                raise(s_window[i], now);
+            }
+        }
+
+        /**
+         * @brief Accounts bytes allocated by a subsystem.
+         */
+        inline void Allocated(Subsystem subsystem, std::size_t bytes)
+        {
+            Detail::add(static_cast<std::size_t>(subsystem), bytes);
+            Detail::add(SUBSYSTEMS, bytes);
+        }
+
+        /**
+         * @brief Accounts bytes released by a subsystem.
+         */
+        inline void Released(Subsystem subsystem, std::size_t bytes)
+        {
+            Detail::s_current[static_cast<std::size_t>(subsystem)].fetch_sub(bytes, std::memory_order_relaxed);
+            Detail::s_current[SUBSYSTEMS].fetch_sub(bytes, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Bytes in use now and at the peak of the run.
+         */
+        MemoryUsage Run();
+
+        /**
+         * @brief Bytes in use now and at the peak since the last BeginWindow.
+         */
+        MemoryUsage Window();
+
+        /**
+         * @brief Starts a new window (window peaks set to the current usage).
+         */
+        void BeginWindow();
+
+        /**
+         * @brief Sets the memory budget [bytes] (0 = none).
+         * @remarks The budget is a planning limit: code that can run in less memory (e.g. streaming
+         * a concentration matrix in tiles instead of computing it whole) asks Fits before allocating.
+         */
+        void SetBudget(std::size_t bytes);
+
+        /**
+         * @brief Memory budget [bytes] (0 = none).
+         */
+        std::size_t Budget();
+
+        /**
+         * @brief Would allocating more bytes keep the total within the budget (if any)?
+         */
+        bool Fits(std::size_t bytes);
+
+        /**
+         * @brief Bytes left within the budget (SIZE_MAX if there is no budget).
+         */
+        std::size_t Available();
+
+        /**
+         * @brief Parses a byte count with an optional K, M or G suffix (binary multiples), e.g. "512M".
+         * @throws std::invalid_argument for an invalid count.
+         */
+        std::size_t ParseBytes(const std::string& text);
+    }
+
+    /**
+     * @brief Standard allocator accounting the bytes it allocates to a subsystem.
+     */
+    template<typename T, Subsystem S>
+    struct CountingAllocator
+    {
+        using value_type = T;
+
+        template<typename U>
+        struct rebind { using other = CountingAllocator<U, S>; };
+
+        CountingAllocator() noexcept = default;
+
+        template<typename U>
+        CountingAllocator(const CountingAllocator<U, S>&) noexcept {}
+
+        T *allocate(std::size_t n)
+        {
+            T *p = std::allocator<T>{}.allocate(n);
+            Memory::Allocated(S, n * sizeof(T));
+            return p;
+        }
+
+        void deallocate(T *p, std::size_t n) noexcept
+        {
+            Memory::Released(S, n * sizeof(T));
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template<typename U>
+        bool operator==(const CountingAllocator<U, S>&) const noexcept { return true; }
+
+        template<typename U>
+        bool operator!=(const CountingAllocator<U, S>&) const noexcept { return false; }
+    };
+
+    /// @brief Vector accounted to a subsystem.
+    template<typename T, Subsystem S>
+    using TrackedVector = std::vector<T, CountingAllocator<T, S>>;
+
+    /// @brief String accounted to a subsystem.
+    template<Subsystem S>
+    using TrackedString = std::basic_string<char, std::char_traits<char>, CountingAllocator<char, S>>;
+
+    /**
+     * @brief Memory usage aggregated per job.
+     */
+    class MemoryLog
+    {
+    public:
+
+        /**
+         * @brief Memory usage of a job.
+         */
+        struct Entry
+        {
+            std::string Title;          /// Job title.
+            MemoryUsage Usage;          /// Usage at the end of the job and its peaks while the job ran.
+            std::size_t Tile = 0;       /// Receptors per tile if the job was streamed to fit the budget (0 = computed whole).
+        };
+
+        /**
+         * @brief Records the memory usage of a job.
+         * @remarks Thread-safe.
+         */
+        void Add(std::size_t job, const Entry& entry);
+
+        /**
+         * @brief Entries per job ordinal.
+         */
+        std::map<std::size_t, Entry> Jobs() const;
+
+        /**
+         * @brief Forgets all the entries.
+         */
+        void Clear();
+
+        /**
+         * @brief Prints per job peaks [KiB] and the run usage as a table.
+         */
+        void PrintTable(std::ostream& os) const;
+
+        /**
+         * @brief Prints per job and run usage [bytes] as JSON.
+         */
+        void PrintJSON(std::ostream& os) const;
+
+        /**
+         * @brief Log the jobs report to.
+         */
+        static MemoryLog& Global();
+
+    private:
+        mutable std::mutex m_mutex;                 /// Entries guard.
+        std::map<std::size_t, Entry> m_jobs;        /// Entries per job.
+    };
+}
+
+#endif /* !MEMORY_H */
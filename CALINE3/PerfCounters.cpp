@@ -0,0 +1,239 @@
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "PerfCounters.h"
+
+namespace CALINE3
+{
+    namespace
+    {
+        constexpr std::size_t EVENTS = HardwareCounts::EVENTS;
+
+        /// @brief Raw values read: event counts followed by the group enabled and running times [ns].
+        using Raw = double[EVENTS + 2];
+
+        /**
+         * @brief Counter group of a thread (opened on first use, closed on thread exit).
+         */
+        class Group
+        {
+        public:
+            ~Group()
+            {
+#if defined(__linux__)
+                for (int fd : m_fd)
+                {
+                    if (fd >= 0) ::close(fd);
+                }
+#endif
+            }
+
+            /// @brief Opens the group (once); @c false if the hardware counters are not available.
+            bool Ready()
+            {
+                if (!m_opened)
+                {
+                    m_opened = true;
+                    m_ready = Open();
+                }
+                return m_ready;
+            }
+
+            /// @brief Error met opening the group (or the events missing).
+            const std::string& Error() const { return m_error; }
+
+            /// @brief Reads the current counts.
+            bool Read(Raw raw) const;
+
+        private:
+            bool Open();
+
+            bool m_opened = false;
+            bool m_ready = false;
+            std::string m_error;
+            int m_fd[EVENTS] = { -1, -1, -1, -1, -1, -1 };      /// Event descriptors (-1 = not counted).
+            int m_index[EVENTS] = { -1, -1, -1, -1, -1, -1 };   /// Event positions in the group read (-1 = not counted).
+            std::size_t m_members = 0;                          /// Events in the group.
+        };
+
+#if defined(__linux__)
+        bool Group::Open()
+        {
+            static constexpr std::uint64_t CONFIG[EVENTS] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES
+            };
+
+            // Cycles lead the group, the other events join it if the machine has them:
+            for (std::size_t e = 0; e < EVENTS; e++)
+            {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = CONFIG[e];
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0 /*this thread*/, -1 /*any cpu*/, m_fd[0], 0));
+                if (fd < 0)
+                {
+                    if (e == 0)
+                    {
+                        m_error = std::string("hardware counters not available (perf_event_open: ") + std::strerror(errno) + ")";
+                        return false;
+                    }
+                    m_error += (m_error.empty() ? "not counted: " : ", ") + std::string(HardwareCounts::EVENT_NAME[e]);
+                    continue;
+                }
+                m_fd[e] = fd;
+                m_index[e] = static_cast<int>(m_members++);
+            }
+            return true;
+        }
+
+        bool Group::Read(Raw raw) const
+        {
+            std::uint64_t buffer[3 + EVENTS];   // nr, time enabled, time running, values
+            if (::read(m_fd[0], buffer, sizeof(buffer)) < static_cast<ssize_t>((3 + m_members) * sizeof(std::uint64_t)))
+                return false;
+            for (std::size_t e = 0; e < EVENTS; e++)
+            {
+                raw[e] = (m_index[e] < 0) ? 0.0 : static_cast<double>(buffer[3 + m_index[e]]);
+            }
+            raw[EVENTS] = static_cast<double>(buffer[1]);
+            raw[EVENTS + 1] = static_cast<double>(buffer[2]);
+            return true;
+        }
+#else
+        bool Group::Open()
+        {
+            m_error = "hardware counters not supported on this platform";
+            return false;
+        }
+
+        bool Group::Read(Raw) const
+        {
+            return false;
+        }
+#endif
+
+        thread_local Group t_group;
+
+        std::mutex s_mutex;         /// Guards the totals and status.
+        StageCounts s_total;        /// Counts per stage (all threads).
+        std::string s_status;       /// Status of the counters (as opened by Enable).
+
+        /// @brief Rate as text ("n/a" if not counted).
+        void rate(std::ostream& os, const char *name, double value, bool percent)
+        {
+            char text[32];
+            if (std::isnan(value))
+                std::snprintf(text, sizeof(text), "n/a");
+            else if (percent)
+                std::snprintf(text, sizeof(text), "%.2f%%", 100.0 * value);
+            else
+                std::snprintf(text, sizeof(text), "%.2f", value);
+            os << name << ' ' << text;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Methods
+    ///
+
+    double HardwareCounts::Ratio(Event numerator, Event denominator) const
+    {
+        return (Count[denominator] > 0.0) ? Count[numerator] / Count[denominator] : std::nan("");
+    }
+
+    bool PerfCounters::Enable()
+    {
+        const bool ready = t_group.Ready();
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            s_status = t_group.Error();
+        }
+        s_enabled.store(ready, std::memory_order_relaxed);
+        return ready;
+    }
+
+    std::string PerfCounters::Status()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        return s_status;
+    }
+
+    StageCounts PerfCounters::Total()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        return s_total;
+    }
+
+    void PerfCounters::Reset()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_total = StageCounts{};
+    }
+
+    void PerfCounters::Add(Stage stage, const HardwareCounts& counts)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_total[stage] += counts;
+    }
+
+    void PerfCounters::PrintRates(std::ostream& os, const StageCounts& counts)
+    {
+        for (std::size_t s = 0; s < STAGES; s++)
+        {
+            const HardwareCounts& c = counts.Stages[s];
+            os << ((s == 0) ? "" : " :: ") << STAGE_NAME[s] << ' ';
+            rate(os, "IPC", c.IPC(), false);
+            rate(os, ", cache miss", c.CacheMissRate(), true);
+            rate(os, ", branch miss", c.BranchMissRate(), true);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      ScopedCounters
+    ///
+
+    ScopedCounters::ScopedCounters(Stage stage)
+        : m_stage(stage), m_on(PerfCounters::Enabled() && t_group.Ready())
+    {
+        if (m_on)
+            m_on = t_group.Read(m_start);
+    }
+
+    ScopedCounters::~ScopedCounters()
+    {
+        Raw end;
+        if (!m_on || !t_group.Read(end))
+            return;
+
+        // Counts scaled up by enabled/running time when the kernel multiplexed the counters:
+        const double enabled = end[EVENTS] - m_start[EVENTS];
+        const double running = end[EVENTS + 1] - m_start[EVENTS + 1];
+        const double scale = ((running > 0.0) && (enabled > running)) ? enabled / running : 1.0;
+
+        HardwareCounts counts;
+        for (std::size_t e = 0; e < EVENTS; e++)
+        {
+            counts.Count[e] = (end[e] - m_start[e]) * scale;
+        }
+        PerfCounters::Add(m_stage, counts);
+    }
+}
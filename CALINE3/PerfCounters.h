@@ -0,0 +1,181 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace CALINE3
+{
+    /**
+     * @brief Pipeline stages counted separately.
+     */
+    enum class Stage : unsigned char
+    {
+        Parse,      /// Reading and parsing jobs (JobReader).
+        Compute,    /// Concentrations (Engine::Compute and its tasks).
+        Report      /// Report formatting (Report::Print).
+    };
+
+    /// @brief Number of stages.
+    constexpr std::size_t STAGES = 3;
+
+    /// @brief Stage names.
+    constexpr const char *STAGE_NAME[STAGES] = { "parse", "compute", "report" };
+
+    /**
+     * @brief Hardware event counts (user space).
+     */
+    struct HardwareCounts
+    {
+        /// @brief Events counted.
+        enum Event : unsigned char { Cycles, Instructions, CacheReferences, CacheMisses, Branches, BranchMisses };
+
+        /// @brief Number of events.
+        static constexpr std::size_t EVENTS = 6;
+
+        /// @brief Event names.
+        static constexpr const char *EVENT_NAME[EVENTS] = { "cycles", "instructions", "cache_references", "cache_misses", "branches", "branch_misses" };
+
+        double Count[EVENTS] = {};  /// Event counts (scaled up when the kernel multiplexed the counters).
+
+        /// @brief Instructions per cycle (NaN if not counted).
+        double IPC() const { return Ratio(Instructions, Cycles); }
+
+        /// @brief Cache misses per cache reference (NaN if not counted).
+        double CacheMissRate() const { return Ratio(CacheMisses, CacheReferences); }
+
+        /// @brief Branch misses per branch instruction (NaN if not counted).
+        double BranchMissRate() const { return Ratio(BranchMisses, Branches); }
+
+        HardwareCounts& operator+=(const HardwareCounts& other)
+        {
+            for (std::size_t e = 0; e < EVENTS; e++) Count[e] += other.Count[e];
+            return *this;
+        }
+
+        HardwareCounts& operator-=(const HardwareCounts& other)
+        {
+            for (std::size_t e = 0; e < EVENTS; e++) Count[e] -= other.Count[e];
+            return *this;
+        }
+
+    private:
+        double Ratio(Event numerator, Event denominator) const;
+    };
+
+    /**
+     * @brief Hardware event counts per stage.
+     */
+    struct StageCounts
+    {
+        HardwareCounts Stages[STAGES];
+
+        const HardwareCounts& operator[](Stage stage) const { return Stages[static_cast<std::size_t>(stage)]; }
+        HardwareCounts& operator[](Stage stage) { return Stages[static_cast<std::size_t>(stage)]; }
+
+        StageCounts operator-(const StageCounts& other) const
+        {
+            StageCounts difference = *this;
+            for (std::size_t s = 0; s < STAGES; s++) difference.Stages[s] -= other.Stages[s];
+            return difference;
+        }
+    };
+
+    /**
+     * @brief Hardware performance counters (Linux perf_event_open) per pipeline stage.
+     * @remarks Each thread opens its own counter group (cycles, instructions, cache references
+     * and misses, branches and branch misses; user space only) on the first stage it enters;
+     * stage counts of all the threads are summed. Where counters cannot be opened (other platforms,
+     * perf_event_paranoid, virtual machines without a PMU) counting is off and Status tells why;
+     * events missing on a machine are left at 0 (their rates NaN).
+     */
+    class PerfCounters
+    {
+    public:
+
+        /**
+         * @brief Switches counting on if hardware counters can be opened (on the calling thread).
+         * @return @c true if counting is on, @c false otherwise (see Status).
+         */
+        static bool Enable();
+
+        /**
+         * @brief Switches counting off.
+         */
+        static void Disable() { s_enabled.store(false, std::memory_order_relaxed); }
+
+        /**
+         * @brief Is counting on?
+         */
+        static bool Enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Why counting is off (empty if on) or which events are missing.
+         */
+        static std::string Status();
+
+        /**
+         * @brief Stage counts summed over the threads so far.
+         */
+        static StageCounts Total();
+
+        /**
+         * @brief Forgets the counts.
+         */
+        static void Reset();
+
+        /**
+         * @brief Prints IPC, cache and branch miss rates per stage in a line, e.g.
+         * "parse IPC 1.52, cache miss 2.1%, branch miss 0.8% :: compute IPC ...".
+         */
+        static void PrintRates(std::ostream& os, const StageCounts& counts);
+
+        /**
+         * @brief Adds counts to a stage (thread-safe).
+         */
+        static void Add(Stage stage, const HardwareCounts& counts);
+
+    private:
+        static inline std::atomic<bool> s_enabled{ false };
+    };
+
+    /**
+     * @brief Adds the hardware events of the current thread during the lifetime of the object
+     * to the stage (if counting is on).
+     * @remarks Scopes of the same thread are not to be nested.
+     */
+    class ScopedCounters
+    {
+    public:
+        explicit ScopedCounters(Stage stage);
+        ~ScopedCounters();
+
+        ScopedCounters(const ScopedCounters&) = delete;
+        ScopedCounters& operator=(const ScopedCounters&) = delete;
+
+    private:
+        Stage m_stage;
+        bool m_on;
+        double m_start[HardwareCounts::EVENTS + 2];    /// Raw counts and the enabled/running times at start.
+    };
+}
+
+#endif /* !PERFCOUNTERS_H */
@@ -0,0 +1,137 @@
+#include <iomanip>
+#include <sstream>
+
+#include "Phases.h"
+#include "Json.h"
+
+namespace CALINE3
+{
+    namespace
+    {
+        /// @brief Phase times [s] as JSON object members.
+        void members(std::ostream& os, const PhaseTimes& times)
+        {
+            for (std::size_t p = 0; p < PHASES; p++)
+            {
+                os << '"' << PHASE_NAME[p] << "\": " << times.Seconds[p] << ", ";
+            }
+            os << "\"total\": " << times.Total();    // (CPU time, wait excluded)
+        }
+
+        /// @brief Phase times [ms] as table columns.
+        void columns(std::ostream& os, const PhaseTimes& times)
+        {
+            for (double s : times.Seconds)
+            {
+                os << std::setw(13) << s * 1e3;
+            }
+            os << std::setw(13) << times.Total() * 1e3 << std::endl;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Methods
+    ///
+
+    void PhaseLog::Add(std::size_t job, const std::string& title, const PhaseTimes& times)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs[job] += times;
+        m_titles.emplace(job, title);
+    }
+
+    std::map<std::size_t, PhaseTimes> PhaseLog::Jobs() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_jobs;
+    }
+
+    PhaseTimes PhaseLog::Total() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PhaseTimes total;
+        for (auto const& job : m_jobs)
+        {
+            total += job.second;
+        }
+        return total;
+    }
+
+    void PhaseLog::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.clear();
+        m_titles.clear();
+    }
+
+    void PhaseLog::PrintTable(std::ostream& os) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::ostringstream table;
+        table << std::fixed << std::setprecision(3);
+        table << std::left << std::setw(24) << "JOB [ms]" << std::right;
+        for (const char *name : PHASE_NAME)
+        {
+            table << std::setw(13) << name;
+        }
+        table << std::setw(13) << "total" << std::endl;
+
+        PhaseTimes total;
+        for (auto const& [job, times] : m_jobs)
+        {
+            total += times;
+            table << std::left << std::setw(24) << (std::to_string(job + 1) + " " + m_titles.at(job)).substr(0, 23) << std::right;
+            columns(table, times);
+        }
+        table << std::left << std::setw(24) << "TOTAL" << std::right;
+        columns(table, total);
+
+        // Where the CPU time goes (wait overlaps the threads waited for, so it has no share):
+        const double sum = total.Total();
+        table << std::left << std::setw(24) << "SHARE [%]" << std::right << std::setprecision(1);
+        for (std::size_t p = 0; p < PHASES; p++)
+        {
+            if (p == static_cast<std::size_t>(Phase::Wait))
+                table << std::setw(13) << "-";
+            else
+                table << std::setw(13) << ((sum > 0.0) ? 100.0 * total.Seconds[p] / sum : 0.0);
+        }
+        table << std::setw(13) << ((sum > 0.0) ? 100.0 : 0.0) << std::endl;
+        os << table.str();
+    }
+
+    void PhaseLog::PrintJSON(std::ostream& os) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        PhaseTimes total;
+        for (auto const& job : m_jobs)
+        {
+            total += job.second;
+        }
+
+        std::ostringstream json;
+        json.precision(6);
+        json << "{\n  \"total\": { ";
+        members(json, total);
+        json << " },\n  \"jobs\": [";
+        const char *separator = "\n";
+        for (auto const& [job, times] : m_jobs)
+        {
+            json << separator << "    { \"job\": " << job + 1 << ", \"title\": " << Json::Quoted(m_titles.at(job)) << ", ";
+            members(json, times);
+            json << " }";
+            separator = ",\n";
+        }
+        json << "\n  ]\n}\n";
+        os << json.str();
+    }
+
+    PhaseLog& PhaseLog::Global()
+    {
+        static PhaseLog log;
+        return log;
+    }
+}
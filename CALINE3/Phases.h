@@ -0,0 +1,195 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef PHASES_H
+#define PHASES_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace CALINE3
+{
+    /**
+     * @brief Phases of a run timed separately.
+     */
+    enum class Phase : unsigned char
+    {
+        Parse,          /// Reading jobs (JobReader::Next).
+        PlumeSetup,     /// Plume (dispersion parameters, wind flow) set up per meteo and link.
+        Elements,       /// Receptors of a link row evaluated (link frame transformation and link elements).
+        Report,         /// Report formatting (Report::Print).
+        Wait            /// Waiting for the worker threads to complete a matrix (wall-clock, not CPU time).
+    };
+
+    /// @brief Number of phases.
+    constexpr std::size_t PHASES = 5;
+
+    /// @brief Phase names.
+    constexpr const char *PHASE_NAME[PHASES] = { "parse", "plume_setup", "elements", "report", "wait" };
+
+    /**
+     * @brief Time [s] spent in each phase (summed over threads).
+     */
+    struct PhaseTimes
+    {
+        double Seconds[PHASES] = {};
+
+        /**
+         * @brief CPU time: all the phases but Wait (which overlaps the work of the threads waited for).
+         */
+        double Total() const
+        {
+            double total = 0.0;
+            for (std::size_t p = 0; p < PHASES; p++)
+            {
+                if (p != static_cast<std::size_t>(Phase::Wait)) total += Seconds[p];
+            }
+            return total;
+        }
+
+        PhaseTimes& operator+=(const PhaseTimes& other)
+        {
+            for (std::size_t p = 0; p < PHASES; p++) Seconds[p] += other.Seconds[p];
+            return *this;
+        }
+    };
+
+    /**
+     * @brief Phase times aggregated per job (from any number of threads).
+     * @remarks Timing is off until enabled (PhaseLog::Enable); timers then cost
+     * a few clock reads per link row (never per link-receptor pair).
+     */
+    class PhaseLog
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Adds phase times to the job entry.
+         * @remarks Thread-safe.
+         */
+        void Add(std::size_t job, const std::string& title, const PhaseTimes& times);
+
+        /**
+         * @brief Phase times per job ordinal.
+         */
+        std::map<std::size_t, PhaseTimes> Jobs() const;
+
+        /**
+         * @brief Phase times of the whole run.
+         */
+        PhaseTimes Total() const;
+
+        /**
+         * @brief Forgets all the entries.
+         */
+        void Clear();
+
+        /**
+         * @brief Prints per job and total phase times [ms] with the phase shares of the total as a table.
+         */
+        void PrintTable(std::ostream& os) const;
+
+        /**
+         * @brief Prints per job and total phase times [s] as JSON.
+         */
+        void PrintJSON(std::ostream& os) const;
+
+        /**
+         * @brief Log the timers report to.
+         */
+        static PhaseLog& Global();
+
+        /**
+         * @brief Switches phase timing on (or off).
+         */
+        static void Enable(bool on) { s_enabled.store(on, std::memory_order_relaxed); }
+
+        /**
+         * @brief Is phase timing on?
+         */
+        static bool Enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    private:
+
+        mutable std::mutex m_mutex;                     /// Entries guard.
+        std::map<std::size_t, PhaseTimes> m_jobs;       /// Phase times per job.
+        std::map<std::size_t, std::string> m_titles;    /// Job titles.
+
+        static inline std::atomic<bool> s_enabled{ false };
+    };
+
+    namespace Timing
+    {
+        /// @brief Phase times of the current thread (since the last Flush).
+        inline thread_local PhaseTimes t_times;
+
+        /**
+         * @brief Moves the phase times of the current thread to the global log (job entry).
+         */
+        inline void Flush(std::size_t job, const std::string& title)
+        {
+            if (PhaseLog::Enabled())
+            {
+                PhaseLog::Global().Add(job, title, t_times);
+                t_times = PhaseTimes{};
+            }
+        }
+    }
+
+    /**
+     * @brief Adds the lifetime of the object to the phase time of the current thread (if timing is on).
+     */
+    class ScopedPhase
+    {
+    public:
+        explicit ScopedPhase(Phase phase)
+            : m_phase(phase), m_on(PhaseLog::Enabled())
+        {
+            if (m_on) m_start = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedPhase() { Stop(); }
+
+        /**
+         * @brief Ends the phase before the end of the scope.
+         */
+        void Stop()
+        {
+            if (m_on)
+                Timing::t_times.Seconds[static_cast<std::size_t>(m_phase)] += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+            m_on = false;
+        }
+
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        Phase m_phase;
+        bool m_on;
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
+
+#endif /* !PHASES_H */
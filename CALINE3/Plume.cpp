@@ -1,4 +1,6 @@
 #include <tuple>
+#include <vector>
+#include "Counters.h"
 #include "Plume.h"
 
 namespace CALINE3
@@ -19,11 +21,12 @@ namespace CALINE3
     ///      Constructor(s)
     ///
 
-    Plume::Plume(const Job& site, const Meteo& meteo, const Link& link) :
+    Plume::Plume(const Job& site, const Meteo& meteo, const Link& link, MathPolicy policy) :
         _site(site),
         _meteo(meteo),
         _link(link),
-        _flow(meteo, link)
+        _flow(meteo, link),
+        _policy(policy)
     {
         /***************************************
          *
@@ -105,67 +108,146 @@ namespace CALINE3
     //      Methods
     //
 
-    Microgram_Meter3 Plume::ConcentrationAt(const Receptor& receptor)
+    Microgram_Meter3 Plume::ConcentrationAt(Meter XR, Meter YR, Meter ZR)
     {
         Meter D;    // distance (perpendicular to the link)
         Meter L;    // offset (parallel to the link, relative to its start position)
         Meter Z;    // level (adjusted for the link type)
-        std::tie(D, L, Z) = _link.TransformReceptorCoordinates(receptor);
-
-        // Assuming point 0 at the receptor orthogonal projection on link line:
-        Meter DWL = -(_link.LL() + L);
-        Meter UWL = -L;
+        std::tie(D, L, Z) = _link.TransformReceptorCoordinates(XR, YR, ZR);
 
         // Mass Concentration
         Microgram_Meter3 C{ 0.0 };
+        CALINE3_COUNT(Pairs);
 
-        // Add up the concentrations from the UPWIND elements:
-        for (Meter elemEnd{ 0.0 }, EL = _link.WL; elemEnd < UWL; EL *= _flow.BASE())
+        // Add up the concentrations from the (upwind, then downwind) elements:
+        switch (_policy.Sum)
         {
-            // Next element
-            Meter elemStart{ elemEnd };
-            elemEnd += EL;
-            // Any element reached?
-            if (elemEnd > DWL)
+        case Summation::Pairwise:
+            C = Microgram_Meter3(SumOverElements<PairwiseSum>(D, L, Z));
+            break;
+        case Summation::Compensated:
+            C = Microgram_Meter3(SumOverElements<CompensatedSum>(D, L, Z));
+            break;
+        default:
+            ForEachElement(L, [&](Meter ED1, Meter ED2)
             {
-                LinkElement elem { _link, _flow,
-                    std::max(elemStart, DWL), 
-                    std::min(elemEnd, UWL)
-                };
+                LinkElement elem{ _link, _flow, ED1, ED2 };
+                CALINE3_COUNT(Elements);
                 C += ConcentrationFrom(elem, D, Z);
-            }
+            });
+            break;
+        }
+
+        return C;
+    }
+
+    template<typename Sum>
+    double Plume::SumOverElements(Meter D, Meter L, Meter Z) const
+    {
+        Sum sum;
+        ForEachElement(L, [&](Meter ED1, Meter ED2)
+        {
+            LinkElement elem{ _link, _flow, ED1, ED2 };
+            CALINE3_COUNT(Elements);
+            sum.Add(ConcentrationFrom(elem, D, Z).value());
+        });
+        return sum.Total();
+    }
+
+    void Plume::ConcentrationProfile(Meter XR, Meter YR, const Meter *ZR, std::size_t levels, Microgram_Meter3 *C, ProfileScratch& scratch)
+    {
+        if (levels == 0)
+            return;
+        scratch.Reserve(levels, _policy.Sum);
+
+        // The receptors share D and L (XY); only their levels differ:
+        Meter D;
+        Meter L;
+        Meter *Z = scratch.Z.data();
+        std::tie(D, L, Z[0]) = _link.TransformReceptorCoordinates(XR, YR, ZR[0]);
+        for (std::size_t k = 1; k < levels; k++)
+        {
+            Z[k] = _link.ReceptorLevel(D, ZR[k]);
+        }
+
+        CALINE3_COUNT_ADD(Pairs, levels);
+
+        switch (_policy.Sum)
+        {
+        case Summation::Pairwise:
+            SumProfile(D, L, Z, levels, scratch.Pairwise.data(), C);
+            break;
+        case Summation::Compensated:
+            SumProfile(D, L, Z, levels, scratch.Compensated.data(), C);
+            break;
+        default:
+            SumProfile(D, L, Z, levels, scratch.Sequential.data(), C);
+            break;
         }
+    }
 
-        // Add up the concentrations from the DOWNWIND elements:
-        for (Meter elemStart{ 0.0 }, EL = _link.WL; elemStart > DWL; EL *= _flow.BASE())
+    template<typename Sum>
+    void Plume::SumProfile(Meter D, Meter L, const Meter *Z, std::size_t levels, Sum *sums, Microgram_Meter3 *C) const
+    {
+        for (std::size_t k = 0; k < levels; k++)
+        {
+            sums[k].Clear();
+        }
+        ElementTerms terms;
+        ForEachElement(L, [&](Meter ED1, Meter ED2)
         {
-            // Next element
-            Meter elemEnd{ elemStart };
-            elemStart -= EL;
-            // Any element reached?
-            if (elemStart < UWL)
+            // (counted per level, as if the levels were evaluated one by one)
+            LinkElement elem{ _link, _flow, ED1, ED2 };
+            CALINE3_COUNT_ADD(Elements, levels);
+            if (!ElementFactors(elem, D, terms))
             {
-                LinkElement elem { _link, _flow,
-                    std::max(elemStart, DWL),
-                    std::min(elemEnd, UWL) 
-                };
-                C += ConcentrationFrom(elem, D, Z);
+                // (zero terms still added: the pairwise tree depends on their number)
+                CALINE3_COUNT_ADD(NoProfile, levels);
+                for (std::size_t k = 0; k < levels; k++)
+                {
+                    sums[k].Add(ZERO_CONCENTRATION.value());
+                }
+                return;
             }
+            for (std::size_t k = 0; k < levels; k++)
+            {
+                sums[k].Add(LevelConcentration(terms, Z[k]).value());
+            }
+        });
+        for (std::size_t k = 0; k < levels; k++)
+        {
+            C[k] = Microgram_Meter3(sums[k].Total());
         }
+    }
 
-        return C;
+    std::size_t Plume::ElementCount(Meter XR, Meter YR, Meter ZR) const
+    {
+        Meter L = std::get<1>(_link.TransformReceptorCoordinates(XR, YR, ZR));
+
+        std::size_t count = 0;
+        ForEachElement(L, [&count](Meter, Meter) { count++; });
+        return count;
     }
 
     Microgram_Meter3 Plume::ConcentrationFrom(const LinkElement& element, Meter D, Meter Z) const
+    {
+        ElementTerms terms;
+        if (!ElementFactors(element, D, terms))
+        {
+            CALINE3_COUNT(NoProfile);
+            return ZERO_CONCENTRATION;
+        }
+        return LevelConcentration(terms, Z);
+    }
+
+    bool Plume::ElementFactors(const LinkElement& element, Meter D, ElementTerms& terms) const
     {
         // Get element profile:
         Microgram_Meter_Sec QE;  // central subelement lineal strength [microgram/(m * s)]
         Meter YE;               // plume centerline offset [m]
         Meter FET;              // element fetch [m]
         if (!element.GetProfile(D, QE, YE, FET))
-        {
-            return ZERO_CONCENTRATION;  // Element does NOT contribute.
-        }
+            return false;   // Element does NOT contribute.
 
         // Horizontal standard deviation (sigma-y) of the emission distribution:
         Meter SGY{ PY1 * pow(FET, PY2) };
@@ -177,13 +259,19 @@ namespace CALINE3
         Meter2_Sec KZ{ SGZ * SGZ / (2.0 * FET / _meteo.U) };
 
         Microgram_Meter3 FACT =
-            element.SourceStrength(QE, SGY, YE) / (SQRT_2PI * SGZ * _meteo.U);
+            element.SourceStrength(QE, SGY, YE, _policy.Erf) / (SQRT_2PI * SGZ * _meteo.U);
 
         // Adjust for depressed section wind speed
         FACT *= _link.DepressedSectionFactor(D);
 
+        terms = ElementTerms{ SGZ, KZ, FACT };
+        return true;
+    }
+
+    Microgram_Meter3 Plume::LevelConcentration(const ElementTerms& terms, Meter Z) const
+    {
         // Deposition correction
-        double FAC3 = DepositionFactor(SGZ, KZ, Z, _link.H(), _site.V1);
+        double FAC3 = DepositionFactor(terms.SGZ, terms.KZ, Z, _link.H(), _site.V1);
         if (std::isnan(FAC3))
         {
             return ZERO_CONCENTRATION;
@@ -191,10 +279,10 @@ namespace CALINE3
         else
         {
             // Settling correction
-            FACT *= SettlingFactor(SGZ, KZ, Z, _link.H(), _site.VS);
+            Microgram_Meter3 FACT = terms.FACT * SettlingFactor(terms.SGZ, terms.KZ, Z, _link.H(), _site.VS);
 
             // Incremental concentration from the element
-            double FAC5 = GaussianFactor(SGZ, Z, _link.H(), _meteo.MIXH);
+            double FAC5 = GaussianFactor(terms.SGZ, Z, _link.H(), _meteo.MIXH);
             return FACT * (FAC5 - FAC3);
         }
     }
@@ -208,13 +296,14 @@ namespace CALINE3
             if (ARG > 5.0)
             {
                 FAC3 = std::nan("");
+                CALINE3_COUNT(DepositionNaN);
             }
             else
             {
                 FAC3 =
                     SQRT_2PI * V1 * SGZ
                     * exp(V1 * (Z + H) / KZ + 0.5 * (V1 * SGZ / KZ) * (V1 * SGZ / KZ))
-                    * Erf(ARG)
+                    * Erf(_policy.Erf, ARG)
                     / KZ;
 
                 if (FAC3 > 2.0) FAC3 = 2.0;
@@ -235,6 +324,7 @@ namespace CALINE3
         double EXLS = 0.0;
         while (true)
         {
+            CALINE3_COUNT(GaussianIterations);
             double ARG1 = -0.5 * ((Z + H + 2.0 * CNT * MIXH) / SGZ) * ((Z + H + 2.0 * CNT * MIXH) / SGZ);
             double EXP1 = (ARG1 < -44.0) ? 0.0 : exp(ARG1);
 
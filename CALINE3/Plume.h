@@ -17,6 +17,9 @@
 #ifndef PLUME_H
 #define PLUME_H
 
+#include <algorithm>
+#include <vector>
+
 #include "Job.h"
 #include "WindFlow.h"
 #include "LinkElement.h"
@@ -56,6 +59,33 @@ namespace CALINE3
     using namespace Metrology;
     using namespace Maths;
 
+    /**
+     * @brief Working storage of Plume::ConcentrationProfile, owned by the caller: sized once
+     * (for the largest profile) and reused from one profile and link to the next.
+     */
+    struct ProfileScratch
+    {
+        std::vector<Meter> Z;                       /// Levels adjusted to the link type.
+        std::vector<SequentialSum> Sequential;      /// Per level sums (of the Summation in use only).
+        std::vector<PairwiseSum> Pairwise;
+        std::vector<CompensatedSum> Compensated;
+
+        /**
+         * @brief Grows the storage (if needed) to hold profiles of the given levels summed the given way.
+         */
+        void Reserve(std::size_t levels, Summation sum)
+        {
+            if (Z.size() < levels)
+                Z.resize(levels);
+            if ((sum == Summation::Pairwise) && (Pairwise.size() < levels))
+                Pairwise.resize(levels);
+            else if ((sum == Summation::Compensated) && (Compensated.size() < levels))
+                Compensated.resize(levels);
+            else if ((sum == Summation::Sequential) && (Sequential.size() < levels))
+                Sequential.resize(levels);
+        }
+    };
+
     /**
      * @brief Gaussian plume calculator.
      */
@@ -80,9 +110,10 @@ namespace CALINE3
          * @brief Plume constructor.
          * @param site,
          * @param met,
-         * @param link.
+         * @param link,
+         * @param policy - math functions to use.
          */
-        Plume(const Job& site, const Meteo& met, const Link& link);
+        Plume(const Job& site, const Meteo& met, const Link& link, MathPolicy policy = MathPolicy{});
 
         ////////////////////////////////////////////////////////////////////////////
         /// 
@@ -94,10 +125,113 @@ namespace CALINE3
          * @param receptor - receptor.
          * @returns
          */
-        Microgram_Meter3 ConcentrationAt(const Receptor& receptor);
+        Microgram_Meter3 ConcentrationAt(const Receptor& receptor)
+        {
+            return ConcentrationAt(receptor.XR, receptor.YR, receptor.ZR);
+        }
+
+        /**
+         * @brief Pollutant concentration [microgram/m3] at the receptor location.
+         * @param XR - receptor X-coordinate,
+         * @param YR - receptor Y-coordinate,
+         * @param ZR - receptor Z-coordinate.
+         * @returns
+         */
+        Microgram_Meter3 ConcentrationAt(Meter XR, Meter YR, Meter ZR);
+
+        /**
+         * @brief Pollutant concentrations [microgram/m3] at the levels of a vertical profile
+         * (receptors at the same XY location).
+         * @param XR - receptor X-coordinate,
+         * @param YR - receptor Y-coordinate,
+         * @param ZR - receptor Z-coordinates (ZR[0..levels)),
+         * @param levels - number of levels,
+         * @param C - concentrations at the levels (C[0..levels), output),
+         * @param scratch - working storage (grown if smaller than the levels; no allocation otherwise).
+         * @remarks One pass over the elements: the receptor geometry, element decomposition,
+         * dispersion parameters and source strength are evaluated once; only the deposition,
+         * settling and Gaussian factors per level. The results (and the counters) are the same
+         * (bit for bit) as the ones of ConcentrationAt at each level.
+         */
+        void ConcentrationProfile(Meter XR, Meter YR, const Meter *ZR, std::size_t levels, Microgram_Meter3 *C, ProfileScratch& scratch);
+
+        /**
+         * @brief Number of link elements evaluated for the receptor location.
+         * @param XR - receptor X-coordinate,
+         * @param YR - receptor Y-coordinate,
+         * @param ZR - receptor Z-coordinate.
+         * @remarks Walks the elements as ConcentrationAt does, without evaluating them.
+         */
+        std::size_t ElementCount(Meter XR, Meter YR, Meter ZR) const;
+
+        /**
+         * @brief Computes deposition factor.
+         */
+        double DepositionFactor(Meter SGZ, Meter2_Sec KZ, Meter Z, Meter H, Meter_Sec V1) const;
+
+        /**
+         * @brief Computes settling factor.
+         */
+        double SettlingFactor(Meter SGZ, Meter2_Sec KZ, Meter Z, Meter H, Meter_Sec VS) const;
+
+        /**
+         * @brief Computes Gaussian factor.
+         */
+        double GaussianFactor(Meter SGZ, Meter Z, Meter H, Meter MIXH) const;
 
     private:
 
+        /**
+         * @brief Element terms that do not depend on the receptor level.
+         */
+        struct ElementTerms
+        {
+            Meter SGZ;              /// Vertical standard deviation (sigma-z) [m].
+            Meter2_Sec KZ;          /// Vertical diffusivity estimate [m2/s].
+            Microgram_Meter3 FACT;  /// Concentration factor (source strength, adjusted for depressed section).
+        };
+
+        /**
+         * @brief Visits the elements (ED1, ED2) the link is divided into, as seen from
+         * the receptor at the offset L: upwind elements first, then the downwind ones.
+         * @param L - receptor offset (parallel to the link, relative to its start position),
+         * @param visit - callable (Meter ED1, Meter ED2).
+         * @remarks Elements grow (by the BASE factor) with the distance from the receptor.
+         */
+        template<typename F>
+        void ForEachElement(Meter L, F&& visit) const
+        {
+            // Assuming point 0 at the receptor orthogonal projection on link line:
+            Meter DWL = -(_link.LL() + L);
+            Meter UWL = -L;
+
+            // UPWIND elements:
+            for (Meter elemEnd{ 0.0 }, EL = _link.WL; elemEnd < UWL; EL *= _flow.BASE())
+            {
+                // Next element
+                Meter elemStart{ elemEnd };
+                elemEnd += EL;
+                // Any element reached?
+                if (elemEnd > DWL)
+                {
+                    visit(std::max(elemStart, DWL), std::min(elemEnd, UWL));
+                }
+            }
+
+            // DOWNWIND elements:
+            for (Meter elemStart{ 0.0 }, EL = _link.WL; elemStart > DWL; EL *= _flow.BASE())
+            {
+                // Next element
+                Meter elemEnd{ elemStart };
+                elemStart -= EL;
+                // Any element reached?
+                if (elemStart < UWL)
+                {
+                    visit(std::max(elemStart, DWL), std::min(elemEnd, UWL));
+                }
+            }
+        }
+
         /**
          * @brief Incremental concentration [microgram/m3] from the element
          * at the distance D and at the level Z.
@@ -109,19 +243,32 @@ namespace CALINE3
         Microgram_Meter3 ConcentrationFrom(const LinkElement& element, Meter D, Meter Z) const;
 
         /**
-         * @brief Computes deposition factor.
+         * @brief Level independent terms of the element concentration at the distance D.
+         * @returns @c false if the element does not contribute (at any level).
          */
-        double DepositionFactor(Meter SGZ, Meter2_Sec KZ, Meter Z, Meter H, Meter_Sec V1) const;
+        bool ElementFactors(const LinkElement& element, Meter D, ElementTerms& terms) const;
 
         /**
-         * @brief Computes settling factor.
+         * @brief Incremental concentration [microgram/m3] from the element (its terms) at the level Z.
          */
-        double SettlingFactor(Meter SGZ, Meter2_Sec KZ, Meter Z, Meter H, Meter_Sec VS) const;
+        Microgram_Meter3 LevelConcentration(const ElementTerms& terms, Meter Z) const;
 
         /**
-         * @brief Computes Gaussian factor.
+         * @brief Sum of the element concentrations [microgram/m3] (in the ForEachElement order)
+         * added up with the Sum accumulator (PairwiseSum or CompensatedSum).
+         * @param D - receptor-link distance [m],
+         * @param L - receptor offset along the link [m],
+         * @param Z - receptor level (adjusted to the Link type) [m].
          */
-        double GaussianFactor(Meter SGZ, Meter Z, Meter H, Meter MIXH) const;
+        template<typename Sum>
+        double SumOverElements(Meter D, Meter L, Meter Z) const;
+
+        /**
+         * @brief Sums of the element concentrations at the levels Z[0..levels) (see SumOverElements),
+         * accumulated in sums[0..levels) (cleared first).
+         */
+        template<typename Sum>
+        void SumProfile(Meter D, Meter L, const Meter *Z, std::size_t levels, Sum *sums, Microgram_Meter3 *C) const;
 
         ////////////////////////////////////////////////////////////////////////////
         /// 
@@ -140,6 +287,9 @@ namespace CALINE3
         /// @brief Wind flow geometry
         const WindFlow _flow;
 
+        /// @brief Math functions.
+        const MathPolicy _policy;
+
         ////////////////////////////////////////////////////////////////////////////
         /// 
         ///      Fields: Gaussian plume dispersion parameters
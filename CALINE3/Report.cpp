@@ -1,4 +1,10 @@
+#include <charconv>
+#include <cstdio>
+
+#include "PerfCounters.h"
+#include "Phases.h"
 #include "Report.h"
+#include "Trace.h"
 
 // Units required/suplementary:
 #include "Gram_Meter3.h"
@@ -9,7 +15,63 @@ namespace CALINE3
     using namespace Metrology;
 
     ////////////////////////////////////////////////////////////////////////////
-    /// 
+    ///
+    ///      Formatting primitives
+    ///
+    ///      Numbers are formatted with std::to_chars straight into the page
+    ///      buffer. Field widths follow std::setw semantics (padding only,
+    ///      never truncation) and fixed-point output is correctly rounded
+    ///      just like std::fixed << std::setprecision(n) so the report stays
+    ///      byte-identical to the one printed with stream manipulators.
+    ///
+
+    namespace
+    {
+        /// @brief Appends text right-aligned in a field of the given width.
+        void right(Report::Page &page, std::string_view text, std::size_t width)
+        {
+            if (text.size() < width) page.append(width - text.size(), ' ');
+            page.append(text);
+        }
+
+        /// @brief Appends text left-aligned in a field of the given width.
+        void left(Report::Page &page, std::string_view text, std::size_t width)
+        {
+            page.append(text);
+            if (text.size() < width) page.append(width - text.size(), ' ');
+        }
+
+        /// @brief Appends integer right-aligned in a field of the given width.
+        void integer(Report::Page &page, long long value, std::size_t width = 0)
+        {
+            char buf[24];
+            auto result = std::to_chars(buf, buf + sizeof(buf), value);
+            right(page, std::string_view(buf, static_cast<std::size_t>(result.ptr - buf)), width);
+        }
+
+        /// @brief Appends fixed-point number right-aligned in a field of the given width.
+        void fixed(Report::Page &page, double value, int precision, std::size_t width)
+        {
+            char buf[64];
+            auto result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, precision);
+            if (result.ec == std::errc())
+            {
+                right(page, std::string_view(buf, static_cast<std::size_t>(result.ptr - buf)), width);
+            }
+            else
+            {
+                // Huge values (hardly possible in the report) do not fit the buffer:
+                std::size_t len = static_cast<std::size_t>(std::snprintf(nullptr, 0, "%.*f", precision, value));
+                std::string text(len + 1, '\0');
+                std::snprintf(&text[0], text.size(), "%.*f", precision, value);
+                text.resize(len);
+                right(page, text, width);
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
     ///      Constants
     ///
 
@@ -17,7 +79,7 @@ namespace CALINE3
     const Microgram_Meter3 Report::FPPM { MOWT / MOVL };
 
     ////////////////////////////////////////////////////////////////////////////
-    /// 
+    ///
     ///      Methods
     ///
 
@@ -26,7 +88,7 @@ namespace CALINE3
         return round(10.0 * Ppm(Ratio{ mc / FPPM })) / 10.0;
     }
 
-    std::string Report::LinkCodes(const std::string& separator, const std::vector<Link>& links)
+    std::string Report::LinkCodes(const std::string& separator, const TrackedVector<Link, Subsystem::Jobs>& links)
     {
         std::string codes{};
         for (auto const &link: links)
@@ -37,109 +99,182 @@ namespace CALINE3
         return codes;
     }
 
-    void Report::PrintJobAndMeteo(const Job& site, const Meteo& met)
+    void Report::PrepareJob(const Job& site)
     {
-        const char *title = "                            CALINE3: CALIFORNIA LINE SOURCE DISPERSION MODEL - SEPTEMBER, 1979/2022 C++ VERSION            PAGE ";
-
-        os  << title << (++PageCount)
-            << std::endl
-            << std::endl
-            << std::endl;
-        
-        os  << "     JOB: " << std::left << std::setw(53) << site.JOB << "RUN: " << std::setw(40) << site.RUN
-            << std::endl
-            << std::endl
-            << std::endl
-            << std::endl;
-
-        os  << "       I.  SITE VARIABLES"
-            << std::endl
-            << std::endl
-            << std::endl;
-        
-        os  << "      U = " << std::right << std::setw(4) << std::setprecision(1) << std::fixed << met.U.value() << " M/S"
-            << "            CLAS = " << std::setw(3) << met.CLAS << "  (" << met.TAG() << ")"
-            << "        VS = " << std::setw(5) << std::setprecision(1) << site.VS1.value() << " CM/S"
-            << "       ATIM = " << std::setw(3) << std::setprecision(0) << site.ATIM.value() << "  MINUTES"
-            << "                   MIXH = " << std::setw(5) << std::setprecision(0) << met.MIXH.value() << " M"
-            << std::endl;
-
-        os  << "    BRG = " << std::setw(3) << std::setprecision(0) << met.BRG1.value() << "  DEGREES"
-            << "          Z0 =" << std::setw(4) << std::setprecision(0) << site.Z0.value() << "  CM"
-            << "         VD = " << std::setw(5) << std::setprecision(1) << site.VD1.value() << " CM/S"
-            << "        AMB =" << std::setw(5) << std::setprecision(1) << met.AMB.value() << " PPM"
-            << std::endl
-            << std::endl;
-    }
+        if ((m_site == &site) && (m_ordinal == site.ORDINAL))
+            return;
 
-    void Report::PrintLinks(const std::vector<Link>& links)
-    {
-        os  << std::endl
-            << std::endl
-            << std::endl
-            << "      II.  LINK VARIABLES"
-            << std::endl
-            << std::endl
-            << std::endl;
+        m_site = &site;
+        m_ordinal = site.ORDINAL;
+
+        // JOB/RUN line:
+        m_jobLine.assign("     JOB: ");
+        left(m_jobLine, site.JOB, 53);
+        m_jobLine.append("RUN: ");
+        left(m_jobLine, site.RUN, 40);
+        m_jobLine.append("\n\n\n\n");
+
+        // II.  LINK VARIABLES
+        m_linkTable.clear();
+        PrintLinks(site.Links, m_linkTable);
+
+        // III.  RECEPTOR LOCATIONS AND MODEL RESULTS
+        m_resultsHeader.assign(
+            "\n"
+            "     III.  RECEPTOR LOCATIONS AND MODEL RESULTS\n"
+            "\n"
+            "\n");
+
+        m_matrixHeader.clear();
+
+        if (site.Links.size() <= 1)
+        {
+            m_resultsHeader.append(
+                "                            *        COORDINATES (M)        *  CO\n"
+                "       RECEPTOR             *      X        Y        Z      * (PPM)\n"
+                "   -------------------------*-------------------------------*-------\n");
+        }
+        else if (site.Links.size() <= 10)
+        {
+            std::string linkCodes = LinkCodes("    ", site.Links);
+
+            m_resultsHeader.append(
+                "                            *                               * TOTAL *             CO/LINK\n"
+                "                            *        COORDINATES (M)        * + AMB *              (PPM)\n"
+                "       RECEPTOR             *      X        Y        Z      * (PPM) *   ");
+            m_resultsHeader.append(linkCodes);
+            m_resultsHeader.append("\n   -------------------------*-------------------------------*-------*---");
+            m_resultsHeader.append(linkCodes.size() + 1, '-');
+            m_resultsHeader.append("\n");
+        }
+        else
+        {
+            m_resultsHeader.append(
+                "                            *                               * TOTAL *\n"
+                "                            *        COORDINATES (M)        * + AMB *\n"
+                "       RECEPTOR             *      X        Y        Z      * (PPM) *\n"
+                "   -------------------------*-------------------------------*-------*\n");
+
+            m_matrixHeader.assign(
+                "\n"
+                "IV.  MODEL RESULTS (RECEPTOR-LINK MATRIX)\n"
+                "                            *                                                     CO/LINK"
+                "                            *        COORDINATES (M)        * + AMB *              (PPM)"
+                "       RECEPTOR             *      X        Y        Z      * (PPM) * ");
+            m_matrixHeader.append(LinkCodes("    ", site.Links));
+            m_matrixHeader.append(102, '-');
+            m_matrixHeader.append("\n");
+        }
 
-        os  << "       LINK DESCRIPTION     *      LINK COORDINATES (M)      * LINK LENGTH  LINK BRG   TYPE  VPH     EF     H    W"
-            << std::endl;
+        // Receptor descriptions:
+        m_receptorRows.resize(site.Receptors.size());
+        for (std::size_t I = 0; I < site.Receptors.size(); I++)
+        {
+            m_receptorRows[I].clear();
+            PrintReceptor(site.Receptors[I], I + 1, m_receptorRows[I]);
+        }
+    }
 
-        os  << "                            *   X1      Y1      X2      Y2   *     (M)       (DEG)                 (G/MI)  (M)  (M)"
-            << std::endl;
+    void Report::PrintJobAndMeteo(const Job& site, const Meteo& met)
+    {
+        m_page.append("                            CALINE3: CALIFORNIA LINE SOURCE DISPERSION MODEL - SEPTEMBER, 1979/2022 C++ VERSION            PAGE ");
+        integer(m_page, ++PageCount);
+        m_page.append("\n\n\n");
+
+        m_page.append(m_jobLine);
+
+        m_page.append(
+            "       I.  SITE VARIABLES\n"
+            "\n"
+            "\n");
+
+        m_page.append("      U = ");
+        fixed(m_page, met.U.value(), 1, 4);
+        m_page.append(" M/S            CLAS = ");
+        integer(m_page, met.CLAS, 3);
+        m_page.append("  (");
+        m_page.append(met.TAG());
+        m_page.append(")        VS = ");
+        fixed(m_page, site.VS1.value(), 1, 5);
+        m_page.append(" CM/S       ATIM = ");
+        fixed(m_page, site.ATIM.value(), 0, 3);
+        m_page.append("  MINUTES                   MIXH = ");
+        fixed(m_page, met.MIXH.value(), 0, 5);
+        m_page.append(" M\n");
+
+        m_page.append("    BRG = ");
+        fixed(m_page, met.BRG1.value(), 0, 3);
+        m_page.append("  DEGREES          Z0 =");
+        fixed(m_page, site.Z0.value(), 0, 4);
+        m_page.append("  CM         VD = ");
+        fixed(m_page, site.VD1.value(), 1, 5);
+        m_page.append(" CM/S        AMB =");
+        fixed(m_page, met.AMB.value(), 1, 5);
+        m_page.append(" PPM\n\n");
+    }
 
-        os  << "   -------------------------*--------------------------------*-------------------------------------------------------"
-            << std::endl;
+    void Report::PrintLinks(const TrackedVector<Link, Subsystem::Jobs>& links, Page &page)
+    {
+        page.append(
+            "\n"
+            "\n"
+            "\n"
+            "      II.  LINK VARIABLES\n"
+            "\n"
+            "\n"
+            "       LINK DESCRIPTION     *      LINK COORDINATES (M)      * LINK LENGTH  LINK BRG   TYPE  VPH     EF     H    W\n"
+            "                            *   X1      Y1      X2      Y2   *     (M)       (DEG)                 (G/MI)  (M)  (M)\n"
+            "   -------------------------*--------------------------------*-------------------------------------------------------\n");
 
         for (auto const& link : links)
         {
-            os  << std::fixed
-                << std::right << std::setw(4) << link.COD() << ". "
-                << std::left << std::setw(22) << link.LNK << "*"
-                << std::right << std::setw(6) << std::setprecision(0) << link.XL1.value()
-                << std::right << std::setw(8) << std::setprecision(0) << link.YL1.value()
-                << std::right << std::setw(8) << std::setprecision(0) << link.XL2.value()
-                << std::right << std::setw(8) << std::setprecision(0) << link.YL2.value() << "  *"
-                << std::right << std::setw(9) << std::setprecision(0) << link.LL().value()
-                << std::right << std::setw(10) << std::setprecision(0) << link.LBRG().value()
-                << std::right << std::setw(9) << link.TYP
-                << std::right << std::setw(7) << std::setprecision(0) << link.VPHL.value()
-                << std::right << std::setw(7) << std::setprecision(1) << link.EFL.value()
-                << std::right << std::setw(6) << std::setprecision(1) << link.HL.value()
-                << std::right << std::setw(6) << std::setprecision(1) << link.WL.value() << std::endl;
+            right(page, link.COD(), 4);
+            page.append(". ");
+            left(page, link.LNK, 22);
+            page.append("*");
+            fixed(page, link.XL1.value(), 0, 6);
+            fixed(page, link.YL1.value(), 0, 8);
+            fixed(page, link.XL2.value(), 0, 8);
+            fixed(page, link.YL2.value(), 0, 8);
+            page.append("  *");
+            fixed(page, link.LL().value(), 0, 9);
+            fixed(page, link.LBRG().value(), 0, 10);
+            right(page, link.TYP, 9);
+            fixed(page, link.VPHL.value(), 0, 7);
+            fixed(page, link.EFL.value(), 1, 7);
+            fixed(page, link.HL.value(), 1, 6);
+            fixed(page, link.WL.value(), 1, 6);
+            page.append("\n");
         }
-        os << std::endl;
+        page.append("\n");
     }
 
     void Report::PrintReceptorsHeader()
     {
-        os  << std::endl
-            << "     III.  RECEPTOR LOCATIONS AND MODEL RESULTS"
-            << std::endl
-            << std::endl
-            << std::endl;
+        m_page.append(m_resultsHeader);
     }
 
-    void Report::PrintReceptor(const Receptor &receptor, size_t SEQNO)
+    void Report::PrintReceptor(const Receptor &receptor, size_t SEQNO, Page &page)
     {
-        os  << std::fixed
-            << std::right << std::setw(5) << SEQNO << ". "
-            << std::left << std::setw(21) << receptor.RCP << "* "
-            << std::right << std::setw(8) << std::setprecision(0) << receptor.XR.value()
-            << std::right << std::setw(9) << std::setprecision(0) << receptor.YR.value()
-            << std::right << std::setw(10) << std::setprecision(1) <<receptor.ZR.value();
+        integer(page, static_cast<long long>(SEQNO), 5);
+        page.append(". ");
+        left(page, receptor.RCP, 21);
+        page.append("* ");
+        fixed(page, receptor.XR.value(), 0, 8);
+        fixed(page, receptor.YR.value(), 0, 9);
+        fixed(page, receptor.ZR.value(), 1, 10);
     }
 
-    void Report::PrintConcentrations(const std::vector<std::vector<Microgram_Meter3>> &MC, size_t R)
+    void Report::PrintConcentrations(const ConcentrationMatrix &MC, size_t R)
     {
         for (auto const& mass_conc : MC)
         {
             auto ppm = ToPPM(mass_conc[R]);
-            os << std::fixed << std::right << std::setw(5) << std::setprecision(1) << ppm.value();
+            fixed(m_page, ppm.value(), 1, 5);
         }
     }
 
-    void Report::PrintTotalConcentration(Ppm amb, const std::vector<std::vector<Microgram_Meter3>> &MC, size_t R)
+    void Report::PrintTotalConcentration(Ppm amb, const ConcentrationMatrix &MC, size_t R)
     {
         //auto total = TotalConcentrationAtReceptor(MC, R) + amb;
         Ppm CSUM{ 0.0 };
@@ -148,54 +283,67 @@ namespace CALINE3
             CSUM += ToPPM(mass_conc[R]);
         }
         CSUM += amb;
-        os << "   *" << std::right << std::setw(5) << std::setprecision(1) << CSUM.value();
+        m_page.append("   *");
+        fixed(m_page, CSUM.value(), 1, 5);
     }
 
-    void Report::Print(const Job& site, const Meteo& meteo, const std::vector<std::vector<Microgram_Meter3>> &MC)
+    void Report::Flush()
     {
+        os.write(m_page.data(), static_cast<std::streamsize>(m_page.size()));
+        m_page.clear();
+    }
+
+    void Report::Print(const Job& site, const Meteo& meteo, const ConcentrationMatrix &MC)
+    {
+        Print(site, meteo, [&MC, NR = site.Receptors.size()](const TileSink& sink) { sink(MC, 0, NR); });
+    }
+
+    void Report::Print(const Job& site, const Meteo& meteo, const TileSource& tiles)
+    {
+        ScopedPhase report{ Phase::Report };
+        TraceSpan span{ "report", "writer", site.ORDINAL, meteo.ORDINAL };
+        ScopedCounters counters{ Stage::Report };
+        PrepareJob(site);
+
+        m_page.clear();
+
         // CALINE3: CALIFORNIA LINE SOURCE DISPERSION MODEL - SEPTEMBER, 1979 VERSION
         // I. SITE VARIABLES
         PrintJobAndMeteo(site, meteo);
 
         // II.  LINK VARIABLES
-        PrintLinks(site.Links);
+        m_page.append(m_linkTable);
 
         // III.  RECEPTOR LOCATIONS AND MODEL RESULTS
         if (site.Links.size() <= 1)
         {
             PrintReceptorsHeader();
 
-            os  << "                            *        COORDINATES (M)        *  CO" << std::endl
-                << "       RECEPTOR             *      X        Y        Z      * (PPM)" << std::endl
-                << "   -------------------------*-------------------------------*-------" << std::endl;
-
-            for (std::size_t I = 0; I < site.Receptors.size(); I++)
-            {
-                PrintReceptor(site.Receptors[I], I + 1);
-                PrintTotalConcentration(meteo.AMB, MC, I);
-                os << std::endl;
-            }
+            tiles([&](const ConcentrationMatrix& MC, std::size_t rfirst, std::size_t rlast) {
+                for (std::size_t I = rfirst; I < rlast; I++)
+                {
+                    m_page.append(m_receptorRows[I]);
+                    PrintTotalConcentration(meteo.AMB, MC, I - rfirst);
+                    m_page.append("\n");
+                }
+                Flush();
+            });
         }
         else if (site.Links.size() <= 10)
         {
             PrintReceptorsHeader();
 
-            std::string linkCodes = LinkCodes("    ", site.Links);
-
-            os  << "                            *                               * TOTAL *             CO/LINK" << std::endl
-                << "                            *        COORDINATES (M)        * + AMB *              (PPM)" << std::endl
-                << "       RECEPTOR             *      X        Y        Z      * (PPM) *   " << linkCodes << std::endl
-                << "   -------------------------*-------------------------------*-------*---" << std::string(linkCodes.size()+1, '-')
-                << std::endl;
-
-            for (std::size_t I = 0; I < site.Receptors.size(); I++)
-            {
-                PrintReceptor(site.Receptors[I], I + 1);
-                PrintTotalConcentration(meteo.AMB, MC, I);
-                os << "  *";
-                PrintConcentrations(MC, I);
-                os << std::endl;
-            }
+            tiles([&](const ConcentrationMatrix& MC, std::size_t rfirst, std::size_t rlast) {
+                for (std::size_t I = rfirst; I < rlast; I++)
+                {
+                    m_page.append(m_receptorRows[I]);
+                    PrintTotalConcentration(meteo.AMB, MC, I - rfirst);
+                    m_page.append("  *");
+                    PrintConcentrations(MC, I - rfirst);
+                    m_page.append("\n");
+                }
+                Flush();
+            });
         }
         else
         {
@@ -203,37 +351,34 @@ namespace CALINE3
 
             PrintReceptorsHeader();
 
-            os  << "                            *                               * TOTAL *" << std::endl
-                << "                            *        COORDINATES (M)        * + AMB *" << std::endl
-                << "       RECEPTOR             *      X        Y        Z      * (PPM) *" << std::endl
-                << "   -------------------------*-------------------------------*-------*" << std::endl;
-
-            for (std::size_t I = 0; I < site.Receptors.size(); I++)
-            {
-                PrintReceptor(site.Receptors[I], I + 1);
-                PrintTotalConcentration(meteo.AMB, MC, I);
-                os<< std::endl;
-            }
+            tiles([&](const ConcentrationMatrix& MC, std::size_t rfirst, std::size_t rlast) {
+                for (std::size_t I = rfirst; I < rlast; I++)
+                {
+                    m_page.append(m_receptorRows[I]);
+                    PrintTotalConcentration(meteo.AMB, MC, I - rfirst);
+                    m_page.append("\n");
+                }
+                Flush();
+            });
 
             PrintJobAndMeteo(site, meteo);
 
-            //std::string linkCodes = LinkCodes("    ", site.Links);
-
-            os  << std::endl
-                << "IV.  MODEL RESULTS (RECEPTOR-LINK MATRIX)"
-                << std::endl
-                << "                            *                                                     CO/LINK"
-                << "                            *        COORDINATES (M)        * + AMB *              (PPM)"
-                << "       RECEPTOR             *      X        Y        Z      * (PPM) * " << LinkCodes("    ", site.Links)
-                << std::string(102, '-')
-                << std::endl;
-
-            for (std::size_t I = 0; I < site.Receptors.size(); I++)
-            {
-                os << (I + 1) << "." << site.Receptors[I].RCP;
-                PrintConcentrations(MC, I);
-                os << std::endl;
-            }
+            // IV.  MODEL RESULTS (RECEPTOR-LINK MATRIX)
+            m_page.append(m_matrixHeader);
+
+            tiles([&](const ConcentrationMatrix& MC, std::size_t rfirst, std::size_t rlast) {
+                for (std::size_t I = rfirst; I < rlast; I++)
+                {
+                    integer(m_page, static_cast<long long>(I + 1));
+                    m_page.append(".");
+                    m_page.append(site.Receptors[I].RCP);
+                    PrintConcentrations(MC, I - rfirst);
+                    m_page.append("\n");
+                }
+                Flush();
+            });
         }
+
+        Flush();
     }
 }
@@ -1,8 +1,11 @@
 #ifndef REPORT_H
 #define REPORT_H
 
-#include <iomanip>
+#include <functional>
 #include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "Job.h"
 #include "Meteo.h"
@@ -43,6 +46,22 @@ namespace CALINE3
         /// @brief PPM factor [mcg/m3] to convert concentration from [mcg/m3] to [ppm].
         static const Microgram_Meter3 FPPM;
 
+        /// @brief Page text (accounted to the report).
+        using Page = TrackedString<Subsystem::Report>;
+
+        /**
+         * @brief Tile sink: receives concentration matrix tiles (tile[links][0..rlast-rfirst)
+         * for the receptors [rfirst, rlast)).
+         */
+        using TileSink = std::function<void(const ConcentrationMatrix& tile, std::size_t rfirst, std::size_t rlast)>;
+
+        /**
+         * @brief Tile source: hands the tiles covering all the receptors, in receptor order, over to the sink.
+         * @remarks It may be asked for the tiles more than once (the report of more than 10 links
+         * goes through the receptors twice).
+         */
+        using TileSource = std::function<void(const TileSink& sink)>;
+
         ////////////////////////////////////////////////////////////////////////////
         /// 
         ///      Constructor(s)
@@ -53,7 +72,7 @@ namespace CALINE3
          * @param ostr - report output stream.
          */
         Report(std::ostream &ostr)
-            : os(ostr), PageCount(0)
+            : os(ostr), PageCount(0), m_page(), m_site(nullptr), m_ordinal(0), m_jobLine(), m_linkTable(), m_resultsHeader(), m_matrixHeader(), m_receptorRows()
         {}
 
         ////////////////////////////////////////////////////////////////////////////
@@ -67,7 +86,16 @@ namespace CALINE3
          * @param meteo - meteo conditions,
          * @param MC - mass concentration matrix.
         */
-        void Print(const Job& site, const Meteo& meteo, const std::vector<std::vector<Microgram_Meter3>> &MC);
+        void Print(const Job& site, const Meteo& meteo, const ConcentrationMatrix &MC);
+
+        /**
+         * @brief Prints concentration matrix tiles as they come (the page is written out tile by tile),
+         * so that the matrix need not be held whole; the report is the same as the one printed by Print.
+         * @param site - site conditions,
+         * @param meteo - meteo conditions,
+         * @param tiles - concentration matrix tiles.
+        */
+        void Print(const Job& site, const Meteo& meteo, const TileSource& tiles);
 
     private:
         
@@ -78,31 +106,43 @@ namespace CALINE3
          */
         Ppm ToPPM(Microgram_Meter3 mc);
 
-        std::string LinkCodes(const std::string& separator, const std::vector<Link>& links);
+        std::string LinkCodes(const std::string& separator, const TrackedVector<Link, Subsystem::Jobs>& links);
+
+        /**
+         * @brief Formats (and caches) the sections that do not change between meteos of a job:
+         * the JOB/RUN line, link table, results table header and receptor descriptions.
+         * @param site - site conditions.
+         */
+        void PrepareJob(const Job& site);
 
         void PrintJobAndMeteo(const Job& site, const Meteo& met);
 
-        void PrintLinks(const std::vector<Link>& links);
+        void PrintLinks(const TrackedVector<Link, Subsystem::Jobs>& links, Page &page);
 
         void PrintReceptorsHeader();
 
-        void PrintReceptor(const Receptor &receptor, size_t SEQNO);
+        void PrintReceptor(const Receptor &receptor, size_t SEQNO, Page &page);
 
         /**
          * @brief Print concentrations at receptor point, in cross section of Links.
-         * @param MC - mass concentration [microgram/meter3] array (MC[links][receptors]),
-         * @param R - receptor index.
+         * @param MC - mass concentration [microgram/meter3] array (MC[links][receptors]) or its tile,
+         * @param R - receptor index (in the tile).
          */
-        void PrintConcentrations(const std::vector<std::vector<Microgram_Meter3>> &MC, size_t R);
+        void PrintConcentrations(const ConcentrationMatrix &MC, size_t R);
 
         /**
          * @brief Prints total (including ambient) concentration [ppm] at receptor point.
          * @param amb - ambient concentration,
-         * @param MC - mass concentration [microgram/meter3] array (MC[links][receptors]),
-         * @param R - receptor index.
+         * @param MC - mass concentration [microgram/meter3] array (MC[links][receptors]) or its tile,
+         * @param R - receptor index (in the tile).
          * @return Total concentration [ppm] at the receptor.
          */
-        void PrintTotalConcentration(Ppm amb, const std::vector<std::vector<Microgram_Meter3>> &MC, size_t R);
+        void PrintTotalConcentration(Ppm amb, const ConcentrationMatrix &MC, size_t R);
+
+        /**
+         * @brief Writes the page out (and clears it for more).
+         */
+        void Flush();
 
         ///////////////////////////////////////////////////////////////////////////
         // 
@@ -111,6 +151,22 @@ namespace CALINE3
 
         std::ostream &os;
         int PageCount;
+
+        /// @brief Page buffer (reused from one Print to the next).
+        Page m_page;
+
+        ///////////////////////////////////////////////////////////////////////////
+        // 
+        //      Fields: job-invariant sections (cached for the job last printed)
+        //
+
+        const Job *m_site;                          /// Job the sections have been formatted for,
+        std::size_t m_ordinal;                      /// and its ordinal number.
+        Page m_jobLine;                             /// JOB/RUN line.
+        Page m_linkTable;                           /// II. LINK VARIABLES.
+        Page m_resultsHeader;                       /// III. results table header.
+        Page m_matrixHeader;                        /// IV. results table header (more than 10 links).
+        TrackedVector<Page, Subsystem::Report> m_receptorRows;  /// Receptor descriptions (SEQNO, RCP, X, Y, Z).
     };
 }
 
@@ -0,0 +1,125 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#include <iostream>
+#include <string>
+
+#include "ResultStore.h"
+
+using namespace CALINE3::ResultStore;
+
+/**
+ * @brief Parses 1-based command line index ("*" selects all).
+ * @returns 0-based index or Reader::ALL.
+ */
+static std::size_t index_arg(const char *arg)
+{
+    if (std::string(arg) == "*")
+        return Reader::ALL;
+
+    std::size_t index = std::stoul(arg);
+    if (index == 0)
+        throw std::out_of_range("indices start at 1.");
+    return index - 1;
+}
+
+static int usage(const char *app)
+{
+    const char *name = app ? app : "Caline3Query";
+    std::cerr
+        << "Usage: " << name << " /path/to/results.c3r jobs" << std::endl
+        << "       " << name << " /path/to/results.c3r get JOB METEO [LINK|*] [RECEPTOR|*]" << std::endl
+        << "       " << name << " /path/to/results.c3r series JOB RECEPTOR [LINK|*]" << std::endl
+        << "(indices start at 1; concentrations in [ug/m3]; \"*\" = all, for links: sum of all links)" << std::endl;
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        return usage(argv[0]);
+    }
+
+    try
+    {
+        Reader store{ argv[1] };
+        const std::string command{ argv[2] };
+
+        std::cout.precision(17);
+
+        if (command == "jobs")
+        {
+            for (std::size_t J = 0; J < store.JobCount(); J++)
+            {
+                const JobRecord &job = store.JobAt(J);
+                std::cout
+                    << (J + 1) << '\t'
+                    << Reader::Field(job.JOB, TITLE_SIZE) << '\t'
+                    << Reader::Field(job.RUN, TITLE_SIZE) << '\t'
+                    << job.NM << " meteo(s)\t"
+                    << job.NL << " link(s)\t"
+                    << job.NR << " receptor(s)"
+                    << std::endl;
+            }
+        }
+        else if ((command == "get") && (argc >= 5))
+        {
+            std::size_t J = index_arg(argv[3]);
+            std::size_t M = index_arg(argv[4]);
+            std::size_t L = (argc > 5) ? index_arg(argv[5]) : Reader::ALL;
+            std::size_t R = (argc > 6) ? index_arg(argv[6]) : Reader::ALL;
+
+            const JobRecord &job = store.JobAt(J);
+            std::size_t R1 = (R == Reader::ALL) ? 0 : R;
+            std::size_t R2 = (R == Reader::ALL) ? job.NR : R + 1;
+            for (std::size_t I = R1; I < R2; I++)
+            {
+                std::cout
+                    << (I + 1) << '\t'
+                    << store.ReceptorName(J, I) << '\t'
+                    << store.Concentration(J, M, L, I)
+                    << std::endl;
+            }
+        }
+        else if ((command == "series") && (argc >= 5))
+        {
+            std::size_t J = index_arg(argv[3]);
+            std::size_t R = index_arg(argv[4]);
+            std::size_t L = (argc > 5) ? index_arg(argv[5]) : Reader::ALL;
+
+            std::vector<double> series = store.ReceptorSeries(J, L, R);
+            for (std::size_t M = 0; M < series.size(); M++)
+            {
+                std::cout
+                    << (store.MatrixAt(J, M).METEO + 1) << '\t'
+                    << series[M]
+                    << std::endl;
+            }
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+    catch (std::exception const& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,404 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ResultStore.h"
+#include "Trace.h"
+
+namespace CALINE3::ResultStore
+{
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Helpers
+    ///
+
+    /**
+     * @brief Copies string into a fixed-size, space-padded field (truncated if too long).
+     */
+    static void pad(char *field, std::size_t size, const std::string &value)
+    {
+        std::memset(field, ' ', size);
+        std::memcpy(field, value.data(), std::min(size, value.size()));
+    }
+
+    /**
+     * @brief Overflow-checked a + b (false on overflow).
+     */
+    static bool add(std::uint64_t a, std::uint64_t b, std::uint64_t &sum)
+    {
+        sum = a + b;
+        return sum >= a;
+    }
+
+    /**
+     * @brief Overflow-checked a * b (false on overflow).
+     */
+    static bool mul(std::uint64_t a, std::uint64_t b, std::uint64_t &product)
+    {
+        product = a * b;
+        return (a == 0) || (product / a == b);
+    }
+
+    /**
+     * @brief Do the tables and all the records of a mapped file lie within it (and within their tables)?
+     */
+    static bool consistent(const char *data, std::uint64_t size)
+    {
+        const FileHeader *header = reinterpret_cast<const FileHeader *>(data);
+
+        // Tables (job, matrix and name) between INDEX_OFFSET and the end of file:
+        std::uint64_t jobs, matrices, names, end;
+        if ((header->INDEX_OFFSET < sizeof(FileHeader)) ||
+            (header->INDEX_OFFSET % alignof(JobRecord) != 0) ||
+            !mul(header->JOB_COUNT, sizeof(JobRecord), jobs) ||
+            !mul(header->MATRIX_COUNT, sizeof(MatrixRecord), matrices) ||
+            !mul(header->NAME_COUNT, NAME_SIZE, names) ||
+            !add(header->INDEX_OFFSET, jobs, end) ||
+            !add(end, matrices, end) ||
+            !add(end, names, end) ||
+            (end > size))
+            return false;
+
+        // Records: matrices and names of each job within their tables, matrices before the tables:
+        const JobRecord *job = reinterpret_cast<const JobRecord *>(data + header->INDEX_OFFSET);
+        const MatrixRecord *matrix = reinterpret_cast<const MatrixRecord *>(job + header->JOB_COUNT);
+        for (std::uint64_t J = 0; J < header->JOB_COUNT; J++, job++)
+        {
+            std::uint64_t last, bytes;
+            if (!add(job->FIRST_MATRIX, job->NM, last) || (last > header->MATRIX_COUNT) ||
+                !add(job->FIRST_NAME, std::uint64_t{ job->NL } + job->NR, last) || (last > header->NAME_COUNT) ||
+                !mul(std::uint64_t{ job->NL } * job->NR, sizeof(double), bytes))
+                return false;
+
+            for (std::uint64_t M = job->FIRST_MATRIX; M < job->FIRST_MATRIX + job->NM; M++)
+            {
+                const std::uint64_t offset = matrix[M].OFFSET;
+                if ((offset < sizeof(FileHeader)) || (offset % alignof(double) != 0) ||
+                    !add(offset, bytes, last) || (last > header->INDEX_OFFSET))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Writer
+    ///
+
+    Writer::Writer(const std::string &path)
+        : m_os(path, std::ios::out | std::ios::binary | std::ios::trunc), m_offset(0), m_jobs(), m_matrices(), m_names(), m_buffer()
+    {
+        if (!m_os.is_open())
+        {
+            throw std::runtime_error(path + ": failed to create.");
+        }
+
+        // Placeholder (INDEX_OFFSET == 0) until the file is closed:
+        FileHeader header{};
+        write(&header, sizeof(header));
+    }
+
+    Writer::~Writer()
+    {
+        try
+        {
+            Close();
+        }
+        catch (...)
+        {
+            // Destructor must not throw (the file is left incomplete).
+        }
+    }
+
+    void Writer::write(const void *data, std::size_t size)
+    {
+        if (!m_os.write(static_cast<const char *>(data), static_cast<std::streamsize>(size)))
+        {
+            throw std::runtime_error("result file write error.");
+        }
+        m_offset += size;
+    }
+
+    void Writer::Append(const Job& site, const Meteo& meteo, const ConcentrationMatrix &MC)
+    {
+        TraceSpan span{ "store", "writer", site.ORDINAL, meteo.ORDINAL };
+        if (m_jobs.empty() || (m_jobs.back().ORDINAL != site.ORDINAL))
+        {
+            // (the record counts are 32-bit)
+            constexpr std::size_t MAX_COUNT = std::numeric_limits<std::uint32_t>::max();
+            if ((site.Links.size() > MAX_COUNT) || (site.Receptors.size() > MAX_COUNT))
+                throw std::length_error("job " + std::to_string(site.ORDINAL + 1) + ": too many links or receptors for the result file.");
+
+            JobRecord job{};
+            job.ORDINAL = site.ORDINAL;
+            job.NL = static_cast<std::uint32_t>(site.Links.size());
+            job.NR = static_cast<std::uint32_t>(site.Receptors.size());
+            job.NM = 0;
+            job.FIRST_MATRIX = m_matrices.size();
+            job.FIRST_NAME = m_names.size() / NAME_SIZE;
+            pad(job.JOB, TITLE_SIZE, site.JOB);
+            pad(job.RUN, TITLE_SIZE, site.RUN);
+            m_jobs.push_back(job);
+
+            std::size_t at = m_names.size();
+            m_names.resize(at + (site.Links.size() + site.Receptors.size()) * NAME_SIZE);
+            for (auto const& link : site.Links)
+            {
+                pad(&m_names[at], NAME_SIZE, link.LNK);
+                at += NAME_SIZE;
+            }
+            for (auto const& receptor : site.Receptors)
+            {
+                pad(&m_names[at], NAME_SIZE, receptor.RCP);
+                at += NAME_SIZE;
+            }
+        }
+
+        JobRecord &job = m_jobs.back();
+
+        m_buffer.resize(static_cast<std::size_t>(job.NL) * job.NR);
+        for (std::size_t L = 0; L < job.NL; L++)
+        {
+            for (std::size_t R = 0; R < job.NR; R++)
+            {
+                m_buffer[L * job.NR + R] = MC[L][R].value();
+            }
+        }
+
+        m_matrices.push_back(MatrixRecord{ meteo.ORDINAL, m_offset, meteo.AMB.value(), 0.0 });
+        job.NM++;
+
+        write(m_buffer.data(), m_buffer.size() * sizeof(double));
+    }
+
+    void Writer::Close()
+    {
+        if (!m_os.is_open())
+            return;
+
+        FileHeader header{};
+        std::memcpy(header.MAGIC, MAGIC, sizeof(MAGIC));
+        header.VERSION = VERSION;
+        header.ENDIAN_MARK = ENDIAN_MARK;
+        header.INDEX_OFFSET = m_offset;
+        header.JOB_COUNT = m_jobs.size();
+        header.MATRIX_COUNT = m_matrices.size();
+        header.NAME_COUNT = m_names.size() / NAME_SIZE;
+
+        write(m_jobs.data(), m_jobs.size() * sizeof(JobRecord));
+        write(m_matrices.data(), m_matrices.size() * sizeof(MatrixRecord));
+        write(m_names.data(), m_names.size());
+
+        // Name table may end unaligned; that is fine as it is the last table.
+        m_os.seekp(0);
+        if (!m_os.write(reinterpret_cast<const char *>(&header), sizeof(header)))
+        {
+            throw std::runtime_error("result file write error.");
+        }
+        m_os.close();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Reader
+    ///
+
+    Reader::Reader(const std::string &path)
+        : m_data(nullptr), m_size(0), m_header(nullptr), m_jobs(nullptr), m_matrices(nullptr), m_names(nullptr)
+    {
+#ifdef _WIN32
+        m_file = nullptr;
+        m_mapping = nullptr;
+
+        HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error(path + ": failed to open.");
+        }
+        m_file = file;
+
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(file, &size) || (size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))))
+        {
+            ::CloseHandle(file);
+            throw std::runtime_error(path + ": not a CALINE3 result file.");
+        }
+        m_size = static_cast<std::size_t>(size.QuadPart);
+
+        HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void *view = mapping ? ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view)
+        {
+            if (mapping) ::CloseHandle(mapping);
+            ::CloseHandle(file);
+            throw std::runtime_error(path + ": failed to map.");
+        }
+        m_mapping = mapping;
+        m_data = static_cast<const char *>(view);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error(path + ": failed to open.");
+        }
+
+        struct stat st;
+        if ((::fstat(fd, &st) != 0) || (st.st_size < static_cast<off_t>(sizeof(FileHeader))))
+        {
+            ::close(fd);
+            throw std::runtime_error(path + ": not a CALINE3 result file.");
+        }
+        m_size = static_cast<std::size_t>(st.st_size);
+
+        void *view = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED)
+        {
+            throw std::runtime_error(path + ": failed to map.");
+        }
+        m_data = static_cast<const char *>(view);
+#endif
+        m_header = reinterpret_cast<const FileHeader *>(m_data);
+
+        const bool valid =
+            (std::memcmp(m_header->MAGIC, MAGIC, sizeof(MAGIC)) == 0) &&
+            (m_header->VERSION == VERSION) &&
+            (m_header->ENDIAN_MARK == ENDIAN_MARK) &&
+            consistent(m_data, m_size);
+
+        if (!valid)
+        {
+            unmap();
+            throw std::runtime_error(path + ": not a (complete) CALINE3 result file.");
+        }
+
+        m_jobs = reinterpret_cast<const JobRecord *>(m_data + m_header->INDEX_OFFSET);
+        m_matrices = reinterpret_cast<const MatrixRecord *>(m_jobs + m_header->JOB_COUNT);
+        m_names = reinterpret_cast<const char *>(m_matrices + m_header->MATRIX_COUNT);
+    }
+
+    Reader::~Reader()
+    {
+        unmap();
+    }
+
+    void Reader::unmap()
+    {
+        if (m_data)
+        {
+#ifdef _WIN32
+            ::UnmapViewOfFile(m_data);
+            ::CloseHandle(m_mapping);
+            ::CloseHandle(m_file);
+#else
+            ::munmap(const_cast<char *>(m_data), m_size);
+#endif
+            m_data = nullptr;
+        }
+    }
+
+    const JobRecord &Reader::JobAt(std::size_t job) const
+    {
+        if (job >= m_header->JOB_COUNT)
+        {
+            throw std::out_of_range("job index out of range.");
+        }
+        return m_jobs[job];
+    }
+
+    const MatrixRecord &Reader::MatrixAt(std::size_t job, std::size_t meteo) const
+    {
+        const JobRecord &rec = JobAt(job);
+        if (meteo >= rec.NM)
+        {
+            throw std::out_of_range("meteo index out of range.");
+        }
+        return m_matrices[rec.FIRST_MATRIX + meteo];
+    }
+
+    const double *Reader::Matrix(std::size_t job, std::size_t meteo) const
+    {
+        return reinterpret_cast<const double *>(m_data + MatrixAt(job, meteo).OFFSET);
+    }
+
+    double Reader::Concentration(std::size_t job, std::size_t meteo, std::size_t link, std::size_t receptor) const
+    {
+        const JobRecord &rec = JobAt(job);
+        if ((receptor >= rec.NR) || ((link != ALL) && (link >= rec.NL)))
+        {
+            throw std::out_of_range("link/receptor index out of range.");
+        }
+
+        const double *MC = Matrix(job, meteo);
+        if (link != ALL)
+        {
+            return MC[link * rec.NR + receptor];
+        }
+
+        double C = 0.0;
+        for (std::size_t L = 0; L < rec.NL; L++)
+        {
+            C += MC[L * rec.NR + receptor];
+        }
+        return C;
+    }
+
+    std::vector<double> Reader::ReceptorSeries(std::size_t job, std::size_t link, std::size_t receptor) const
+    {
+        const JobRecord &rec = JobAt(job);
+        std::vector<double> series(static_cast<std::size_t>(rec.NM));
+        for (std::size_t M = 0; M < series.size(); M++)
+        {
+            series[M] = Concentration(job, M, link, receptor);
+        }
+        return series;
+    }
+
+    const char *Reader::name(std::size_t index) const
+    {
+        if (index >= m_header->NAME_COUNT)
+        {
+            throw std::out_of_range("name index out of range.");
+        }
+        return m_names + index * NAME_SIZE;
+    }
+
+    std::string Reader::LinkName(std::size_t job, std::size_t link) const
+    {
+        const JobRecord &rec = JobAt(job);
+        if (link >= rec.NL)
+        {
+            throw std::out_of_range("link index out of range.");
+        }
+        return Field(name(rec.FIRST_NAME + link), NAME_SIZE);
+    }
+
+    std::string Reader::ReceptorName(std::size_t job, std::size_t receptor) const
+    {
+        const JobRecord &rec = JobAt(job);
+        if (receptor >= rec.NR)
+        {
+            throw std::out_of_range("receptor index out of range.");
+        }
+        return Field(name(rec.FIRST_NAME + rec.NL + receptor), NAME_SIZE);
+    }
+
+    std::string Reader::Field(const char *field, std::size_t size)
+    {
+        while ((size > 0) && (field[size - 1] == ' ')) --size;
+        return std::string(field, size);
+    }
+}
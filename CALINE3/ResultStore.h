@@ -0,0 +1,270 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Job.h"
+
+// Units required/suplementary:
+#include "Microgram_Meter3.h"
+
+namespace CALINE3::ResultStore
+{
+    using namespace Metrology;
+
+    /*
+     * Binary result file layout (native byte order, all records 8-byte aligned):
+     *
+     *   FileHeader
+     *   double MC[NL][NR]          -- one matrix per (job, meteo), in the order computed
+     *   ...
+     *   JobRecord[JOB_COUNT]       -- job table,
+     *   MatrixRecord[MATRIX_COUNT] -- matrix index (grouped by job, ordered by meteo),
+     *   char NAME[NAME_COUNT][20]  -- link names followed by receptor names (per job).
+     *
+     * Matrices are appended as they are computed; the tables are written on Close()
+     * and located through the FileHeader (patched last). A file that has not been
+     * closed properly has INDEX_OFFSET == 0 and is rejected by the Reader.
+     */
+
+    /// @brief File signature.
+    constexpr char MAGIC[8] = { 'C', 'A', 'L', 'I', 'N', 'E', '3', 'R' };
+
+    /// @brief File format version.
+    constexpr std::uint32_t VERSION = 1;
+
+    /// @brief Byte order mark (to detect files written on a machine of different endianness).
+    constexpr std::uint32_t ENDIAN_MARK = 0x01020304;
+
+    /// @brief Length of the (space-padded) title fields.
+    constexpr std::size_t TITLE_SIZE = 40;
+
+    /// @brief Length of the (space-padded) link/receptor name fields.
+    constexpr std::size_t NAME_SIZE = 20;
+
+    struct FileHeader
+    {
+        char MAGIC[8];
+        std::uint32_t VERSION;
+        std::uint32_t ENDIAN_MARK;
+        std::uint64_t INDEX_OFFSET;     /// Offset of the job table (0 = file not closed).
+        std::uint64_t JOB_COUNT;        /// Number of JobRecords.
+        std::uint64_t MATRIX_COUNT;     /// Number of MatrixRecords.
+        std::uint64_t NAME_COUNT;       /// Number of names (NAME_SIZE each).
+        std::uint64_t RESERVED[2];
+    };
+
+    struct JobRecord
+    {
+        std::uint64_t ORDINAL;          /// Job ordinal number (as read from the input).
+        std::uint32_t NL;               /// Number of links.
+        std::uint32_t NR;               /// Number of receptors.
+        std::uint64_t NM;               /// Number of meteos stored for the job.
+        std::uint64_t FIRST_MATRIX;     /// Index of the first MatrixRecord of the job.
+        std::uint64_t FIRST_NAME;       /// Index of the first (link) name of the job.
+        char JOB[TITLE_SIZE];           /// Job title.
+        char RUN[TITLE_SIZE];           /// Run title.
+    };
+
+    struct MatrixRecord
+    {
+        std::uint64_t METEO;            /// Meteo ordinal number.
+        std::uint64_t OFFSET;           /// Offset of the MC[NL][NR] matrix [µg/m3].
+        double AMB;                     /// Ambient concentration [ppm].
+        double RESERVED;
+    };
+
+    static_assert(sizeof(FileHeader) == 64, "unexpected FileHeader padding");
+    static_assert(sizeof(JobRecord) == 120, "unexpected JobRecord padding");
+    static_assert(sizeof(MatrixRecord) == 32, "unexpected MatrixRecord padding");
+
+    /**
+     * @brief Streaming writer of the binary result file.
+     */
+    class Writer
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Constructor(s)
+        ///
+
+        /**
+         * @brief Writer constructor.
+         * @param path - result file path.
+         * @throws std::runtime_error when the file cannot be created.
+         */
+        explicit Writer(const std::string &path);
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        /**
+         * @brief Closes the file (if not closed yet).
+         */
+        ~Writer();
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Appends concentration matrix computed for a given site and meteo conditions.
+         * @param site - site conditions,
+         * @param meteo - meteo conditions,
+         * @param MC - mass concentration matrix (MC[links][receptors]).
+         * @remarks Matrices of a job must be appended one after another (in any meteo order).
+         * @throws std::length_error for a job of more than UINT32_MAX links or receptors.
+         */
+        void Append(const Job& site, const Meteo& meteo, const ConcentrationMatrix &MC);
+
+        /**
+         * @brief Writes the index tables and completes the file.
+         */
+        void Close();
+
+    private:
+
+        void write(const void *data, std::size_t size);
+
+        std::ofstream m_os;                     /// Output file.
+        std::uint64_t m_offset;                 /// Current write offset.
+        std::vector<JobRecord> m_jobs;          /// Job table.
+        std::vector<MatrixRecord> m_matrices;   /// Matrix index.
+        std::vector<char> m_names;              /// Link/receptor names.
+        std::vector<double> m_buffer;           /// Matrix (row-major) staging buffer.
+    };
+
+    /**
+     * @brief Random-access (memory-mapped) reader of the binary result file.
+     */
+    class Reader
+    {
+    public:
+
+        /// @brief "All links" selector.
+        static constexpr std::size_t ALL = static_cast<std::size_t>(-1);
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Constructor(s)
+        ///
+
+        /**
+         * @brief Reader constructor: maps the file into memory.
+         * @param path - result file path.
+         * @throws std::runtime_error when the file cannot be mapped or is not a valid result file.
+         */
+        explicit Reader(const std::string &path);
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        /**
+         * @brief Unmaps the file.
+         */
+        ~Reader();
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Number of jobs stored.
+         */
+        std::size_t JobCount() const { return static_cast<std::size_t>(m_header->JOB_COUNT); }
+
+        /**
+         * @brief Job record.
+         * @param job - job index (0 <= job < JobCount()).
+         */
+        const JobRecord &JobAt(std::size_t job) const;
+
+        /**
+         * @brief Matrix record.
+         * @param job - job index,
+         * @param meteo - meteo index within the job (0 <= meteo < JobAt(job).NM).
+         */
+        const MatrixRecord &MatrixAt(std::size_t job, std::size_t meteo) const;
+
+        /**
+         * @brief Concentration matrix MC[NL][NR] [µg/m3] (row-major, pointing into the mapped file).
+         * @param job - job index,
+         * @param meteo - meteo index within the job.
+         */
+        const double *Matrix(std::size_t job, std::size_t meteo) const;
+
+        /**
+         * @brief Concentration [µg/m3] at the receptor due to the link (or all links).
+         * @param job - job index,
+         * @param meteo - meteo index within the job,
+         * @param link - link index (or ALL),
+         * @param receptor - receptor index.
+         */
+        double Concentration(std::size_t job, std::size_t meteo, std::size_t link, std::size_t receptor) const;
+
+        /**
+         * @brief Concentrations [µg/m3] at the receptor for all meteos (hours) of the job.
+         * @param job - job index,
+         * @param link - link index (or ALL),
+         * @param receptor - receptor index.
+         */
+        std::vector<double> ReceptorSeries(std::size_t job, std::size_t link, std::size_t receptor) const;
+
+        /**
+         * @brief Link name (trimmed).
+         */
+        std::string LinkName(std::size_t job, std::size_t link) const;
+
+        /**
+         * @brief Receptor name (trimmed).
+         */
+        std::string ReceptorName(std::size_t job, std::size_t receptor) const;
+
+        /**
+         * @brief Converts (space-padded) field to a string (trailing spaces removed).
+         */
+        static std::string Field(const char *field, std::size_t size);
+
+    private:
+
+        const char *name(std::size_t index) const;
+
+        void unmap();
+
+        const char *m_data;                 /// Mapped file.
+        std::size_t m_size;                 /// Mapped file size.
+        const FileHeader *m_header;         /// File header.
+        const JobRecord *m_jobs;            /// Job table.
+        const MatrixRecord *m_matrices;     /// Matrix index.
+        const char *m_names;                /// Name table.
+#ifdef _WIN32
+        void *m_file;                       /// File handle.
+        void *m_mapping;                    /// File mapping handle.
+#endif
+    };
+}
+
+#endif /* !RESULT_STORE_H */
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+
+#include "Roads.h"
+
+namespace CALINE3
+{
+    namespace
+    {
+        /// @brief Road line with its number in the input.
+        struct Line
+        {
+            std::string text;
+            std::size_t lineno;
+        };
+
+        /// @brief Outcome of segmenting a range of road lines.
+        struct Segmented
+        {
+            std::vector<Link> links;
+            RoadStats stats;
+            std::string log;
+            bool error = false;
+        };
+
+        /// @brief Link copy with the given ordinal.
+        void append(std::vector<Link>& links, const Link& l)
+        {
+            links.emplace_back(links.size(), l.LNK, l.TYP, l.XL1, l.YL1, l.XL2, l.YL2, l.VPHL, l.EFL, l.HL, l.WL);
+        }
+
+        /// @brief Next whitespace separated field of a line (empty at the end of line).
+        std::string field(const char *&p)
+        {
+            while (std::isspace(static_cast<unsigned char>(*p))) ++p;
+            const char *start = p;
+            while (*p && !std::isspace(static_cast<unsigned char>(*p))) ++p;
+            return std::string(start, p);
+        }
+
+        /// @brief Next number of a line.
+        double number(const char *&p, const char *name)
+        {
+            char *end;
+            const double value = std::strtod(p, &end);
+            if ((end == p) || (*end && !std::isspace(static_cast<unsigned char>(*end))) || !std::isfinite(value))
+                throw std::invalid_argument(std::string("invalid ") + name);
+            p = end;
+            return value;
+        }
+
+        /// @brief Distance between vertices (computed as the Link constructor computes the link length).
+        Meter distance(const Road& road, std::size_t a, std::size_t b)
+        {
+            return Distance(road.X[a], road.Y[a], road.X[b], road.Y[b]);
+        }
+
+        /// @brief Link endpoints.
+        struct Piece
+        {
+            Meter x1, y1, x2, y2;
+        };
+
+        /**
+         * @brief Chord split into equal pieces of at most Link::MAX_LENGTH.
+         * @remarks The interpolated endpoints may put a piece an ulp over the limit, so the piece
+         * lengths are measured as the link length is (Distance) and kept within Link::MAX_LENGTH
+         * (one more piece then).
+         */
+        void split(const Road& road, std::size_t a, std::size_t b, std::vector<Piece>& pieces)
+        {
+            const std::size_t first = pieces.size();
+            for (std::size_t n = static_cast<std::size_t>(std::ceil(distance(road, a, b) / Link::MAX_LENGTH)); ; n++)
+            {
+                pieces.resize(first);
+                bool fits = true;
+                for (std::size_t k = 0; k < n; k++)
+                {
+                    const double f1 = static_cast<double>(k) / n;
+                    const double f2 = static_cast<double>(k + 1) / n;
+                    const Piece piece{
+                        (k == 0) ? road.X[a] : road.X[a] + (road.X[b] - road.X[a]) * f1,
+                        (k == 0) ? road.Y[a] : road.Y[a] + (road.Y[b] - road.Y[a]) * f1,
+                        (k + 1 == n) ? road.X[b] : road.X[a] + (road.X[b] - road.X[a]) * f2,
+                        (k + 1 == n) ? road.Y[b] : road.Y[a] + (road.Y[b] - road.Y[a]) * f2
+                    };
+                    fits = fits && (Distance(piece.x1, piece.y1, piece.x2, piece.y2) <= Link::MAX_LENGTH);
+                    pieces.push_back(piece);
+                }
+                if (fits)
+                    return;
+            }
+        }
+
+        Segmented segment(const Line *first, const Line *last)
+        {
+            Segmented result;
+            std::ostringstream log;
+            for (const Line *line = first; line != last; ++line)
+            {
+                try
+                {
+                    const Road road = RoadNetwork::Parse(line->text);
+                    std::vector<Link> links = RoadNetwork::Segment(road);
+                    result.stats.Roads++;
+                    result.stats.Vertices += road.X.size();
+                    if (links.empty())
+                    {
+                        log << "road \"" << road.ID << "\" at line " << line->lineno << " is shorter than its width (skipped)." << std::endl;
+                        result.stats.Skipped++;
+                    }
+                    for (auto const& l : links)
+                    {
+                        append(result.links, l);
+                    }
+                }
+                catch (std::invalid_argument const& ex)
+                {
+                    log << "invalid road at line " << line->lineno << " (" << ex.what() << ")." << std::endl;
+                    result.error = true;
+                    break;
+                }
+            }
+            result.stats.Links = result.links.size();
+            result.log = log.str();
+            return result;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Methods
+    ///
+
+    RoadStats RoadNetwork::Read(const char *id, std::istream& is, ThreadPool *pool, std::vector<Link>& links, std::ostream& log)
+    {
+        // Road lines (the parsing and segmenting is left to the workers):
+        std::vector<Line> lines;
+        std::string text;
+        for (std::size_t lineno = 1; std::getline(is, text); lineno++)
+        {
+            const std::size_t start = text.find_first_not_of(" \t\r");
+            if ((start != std::string::npos) && (text[start] != '#'))
+                lines.push_back(Line{ std::move(text), lineno });
+        }
+
+        // Ranges of lines, a few per worker (roads differ in the number of vertices):
+        const std::size_t parts = pool ? std::min(lines.size(), 4 * pool->Size()) : 1;
+        std::vector<Segmented> segmented;
+        if (pool && (parts > 1))
+        {
+            std::vector<std::future<Segmented>> pending;
+            for (std::size_t p = 0; p < parts; p++)
+            {
+                const Line *first = lines.data() + lines.size() * p / parts;
+                const Line *last = lines.data() + lines.size() * (p + 1) / parts;
+                pending.push_back(pool->Submit([first, last]() { return segment(first, last); }));
+            }
+            for (auto& part : pending)
+            {
+                segmented.push_back(part.get());
+            }
+        }
+        else
+        {
+            segmented.push_back(segment(lines.data(), lines.data() + lines.size()));
+        }
+
+        // Links in the input order (errors reported in order, up to the first one):
+        RoadStats stats;
+        links.clear();
+        for (auto const& part : segmented)
+        {
+            std::istringstream messages{ part.log };
+            for (std::string message; std::getline(messages, message); )
+            {
+                log << id << ": " << message << std::endl;
+            }
+            stats.Roads += part.stats.Roads;
+            stats.Vertices += part.stats.Vertices;
+            stats.Skipped += part.stats.Skipped;
+            if (part.error)
+            {
+                links.clear();
+                stats.Links = 0;
+                stats.Error = true;
+                return stats;
+            }
+            links.reserve(links.size() + part.links.size());
+            for (auto const& l : part.links)
+            {
+                append(links, l);
+            }
+        }
+        stats.Links = links.size();
+        return stats;
+    }
+
+    Road RoadNetwork::Parse(const std::string& line)
+    {
+        const char *p = line.c_str();
+        Road road;
+        road.ID = field(p);
+        road.TYP = field(p);
+        if (std::none_of(std::begin(Link::TYPE_NAME), std::end(Link::TYPE_NAME), [&road](const char *name) { return road.TYP == name; }))
+            throw std::invalid_argument("invalid type \"" + road.TYP + "\" (AG, BR, FL or DP expected)");
+        road.VPH = Vehicles_Hour(number(p, "traffic volume"));
+        road.EF = Gram_Mile(number(p, "emission factor"));
+        road.H = Meter(number(p, "source height"));
+        road.W = Meter(number(p, "mixing zone width"));
+        if (road.W <= Meter(0.0))
+            throw std::invalid_argument("mixing zone width must be positive");
+
+        // Vertices (repeated ones dropped):
+        for (;;)
+        {
+            while (std::isspace(static_cast<unsigned char>(*p))) ++p;
+            if (!*p)
+                break;
+            const Meter x{ number(p, "vertex x-coordinate") };
+            const Meter y{ number(p, "vertex y-coordinate") };
+            if (!road.X.empty() && (road.X.back() == x) && (road.Y.back() == y))
+                continue;
+            road.X.push_back(x);
+            road.Y.push_back(y);
+        }
+        if (road.X.size() < 2)
+            throw std::invalid_argument("at least two distinct vertices expected");
+        return road;
+    }
+
+    std::vector<Link> RoadNetwork::Segment(const Road& road)
+    {
+        // Chords (vertex index pairs) at least W long:
+        const Meter W = road.W;
+        const std::size_t NV = road.X.size();
+        std::vector<std::pair<std::size_t, std::size_t>> chords;
+        std::size_t start = 0;
+        for (std::size_t v = 1; v < NV; v++)
+        {
+            if (distance(road, start, v) >= W)
+            {
+                chords.emplace_back(start, v);
+                start = v;
+            }
+        }
+
+        // Short tail merged into the last chord(s):
+        if (start != NV - 1)
+        {
+            std::size_t from = start;
+            while (!chords.empty() && (distance(road, from, NV - 1) < W))
+            {
+                from = chords.back().first;
+                chords.pop_back();
+            }
+            if (distance(road, from, NV - 1) >= W)
+                chords.emplace_back(from, NV - 1);
+        }
+
+        // Chords split into links of at most Link::MAX_LENGTH:
+        std::vector<Piece> pieces;
+        for (auto const& [a, b] : chords)
+        {
+            split(road, a, b, pieces);
+        }
+        std::vector<Link> links;
+        links.reserve(pieces.size());
+        for (auto const& piece : pieces)
+        {
+            const std::string lnk = (pieces.size() == 1) ? road.ID : road.ID + "/" + std::to_string(links.size() + 1);
+            links.emplace_back(0, lnk, road.TYP, piece.x1, piece.y1, piece.x2, piece.y2, road.VPH, road.EF, road.H, road.W);
+        }
+        return links;
+    }
+
+    Job RoadNetwork::Attach(const Job& site, const std::vector<Link>& links)
+    {
+        Job job{ site.ORDINAL, site.JOB, site.ATIM, site.Z0, site.VS1, site.VD1, site.NR, site.SCAL };
+        job.setRUN(site.RUN);
+        job.Links.reserve(site.Links.size() + links.size());
+        for (auto const& l : site.Links)
+        {
+            job.Links.push_back(l);
+        }
+        for (auto const& l : links)
+        {
+            job.Links.emplace_back(job.Links.size(), l.LNK, l.TYP, l.XL1, l.YL1, l.XL2, l.YL2, l.VPHL, l.EFL, l.HL, l.WL);
+        }
+        job.Receptors.reserve(site.Receptors.size());
+        for (auto const& receptor : site.Receptors)
+        {
+            job.Receptors.push_back(receptor);
+        }
+        job.Meteos.reserve(site.Meteos.size());
+        for (auto const& meteo : site.Meteos)
+        {
+            job.Meteos.push_back(meteo);
+        }
+        return job;
+    }
+
+    void RoadNetwork::PrintSummary(std::ostream& os, const RoadStats& stats)
+    {
+        os << "Roads: " << stats.Roads << " (" << stats.Vertices << " vertices) -> " << stats.Links << " links";
+        if (stats.Skipped)
+            os << " (" << stats.Skipped << " skipped)";
+        os << std::endl;
+    }
+}
@@ -0,0 +1,121 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef ROADS_H
+#define ROADS_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Job.h"
+#include "ThreadPool.h"
+
+namespace CALINE3
+{
+    /**
+     * @brief Road given as a polyline (one line of the road network input).
+     */
+    struct Road
+    {
+        std::string ID;         /// Road identifier (link names are derived from it).
+        std::string TYP;        /// Section type (AG, BR, FL, DP).
+        Vehicles_Hour VPH;      /// Traffic volume.
+        Gram_Mile EF;           /// Emission factor.
+        Meter H;                /// Source height.
+        Meter W;                /// Mixing zone width.
+        std::vector<Meter> X;   /// Vertex x-coordinates.
+        std::vector<Meter> Y;   /// Vertex y-coordinates.
+    };
+
+    /**
+     * @brief Road network counts.
+     */
+    struct RoadStats
+    {
+        std::size_t Roads = 0;      /// Roads read.
+        std::size_t Vertices = 0;   /// Vertices read.
+        std::size_t Links = 0;      /// Links the roads were segmented into.
+        std::size_t Skipped = 0;    /// Roads shorter than their width (end to end), not modeled.
+        bool Error = false;         /// Invalid road found (no links then).
+    };
+
+    /**
+     * @brief Road network given as polylines, segmented into links.
+     * @remarks Input: a road per line, with whitespace separated fields:
+     * @code{.txt}
+     * # ID   TYP  VPH    EF   H   W   X1     Y1     X2    Y2   ...
+     * MAIN   AG   7500.  30.  0.  30. -707. -707.   0.    0.   120. 175. 150. 350.
+     * @endcode
+     * i.e. identifier, section type, traffic volume [vehicles/hour], emission factor [g/mile/vehicle],
+     * source height [m], mixing zone width [m] and at least two vertices [m] (not scaled by the job SCAL).
+     * Blank lines and lines starting with '#' are skipped.
+     *
+     * A polyline is segmented into links that satisfy WL <= LL <= Link::MAX_LENGTH: vertices closer than
+     * W to the start of the current link are skipped (the link is the chord to the first vertex at least
+     * W away, a short tail extends the last link), and chords longer than Link::MAX_LENGTH are split into
+     * equal parts. Links are named after the road: ID/1, ID/2, ... (ID alone for a single link).
+     */
+    class RoadNetwork
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Reads and segments a road network.
+         * @param id - input stream identity (e.g. file path),
+         * @param is - input stream,
+         * @param pool - worker threads to parse and segment the roads on (nullptr = serially),
+         * @param links - links of the network in the input order (output; the ORDINAL is the index),
+         * @param log - error log.
+         * @returns Counts; RoadStats::Error set (and the links cleared) on error.
+         * @remarks Errors are reported against the input line numbers; roads shorter than their
+         * width are reported as warnings and skipped (a network of no links is valid).
+         */
+        static RoadStats Read(const char *id, std::istream& is, ThreadPool *pool, std::vector<Link>& links, std::ostream& log);
+
+        /**
+         * @brief Parses a road line.
+         * @throws std::invalid_argument for an invalid line.
+         */
+        static Road Parse(const std::string& line);
+
+        /**
+         * @brief Segments a road into links (see above).
+         * @returns Links (ORDINAL 0) or none if the road is shorter than its width.
+         * @throws std::invalid_argument for an invalid link (e.g. source height out of range).
+         */
+        static std::vector<Link> Segment(const Road& road);
+
+        /**
+         * @brief Job with the network links appended to its own links.
+         */
+        static Job Attach(const Job& site, const std::vector<Link>& links);
+
+        /**
+         * @brief Prints the counts, e.g. "Roads: 2 (1000 vertices) -> 86 links".
+         */
+        static void PrintSummary(std::ostream& os, const RoadStats& stats);
+    };
+}
+
+#endif /* !ROADS_H */
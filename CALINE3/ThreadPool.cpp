@@ -0,0 +1,78 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+namespace CALINE3
+{
+    ThreadPool::ThreadPool(std::size_t size)
+        : m_workers(), m_busy(), m_tasks(), m_mutex(), m_ready(), m_stop(false)
+    {
+        if (size == 0)
+        {
+            size = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        m_busy = std::make_unique<std::atomic<std::chrono::nanoseconds::rep>[]>(size);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            m_busy[i] = 0;
+        }
+
+        m_workers.reserve(size);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            m_workers.emplace_back(&ThreadPool::run, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_ready.notify_all();
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    std::vector<std::chrono::nanoseconds> ThreadPool::BusyTimes() const
+    {
+        std::vector<std::chrono::nanoseconds> times;
+        times.reserve(m_workers.size());
+        for (std::size_t i = 0; i < m_workers.size(); i++)
+        {
+            times.emplace_back(m_busy[i].load());
+        }
+        return times;
+    }
+
+    void ThreadPool::ResetBusyTimes()
+    {
+        for (std::size_t i = 0; i < m_workers.size(); i++)
+        {
+            m_busy[i] = 0;
+        }
+    }
+
+    void ThreadPool::run(std::size_t worker)
+    {
+        t_busy = &m_busy[worker];
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+                if (m_tasks.empty())
+                    return; // stop requested and nothing left to do
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+}
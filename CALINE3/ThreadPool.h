@@ -0,0 +1,135 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace CALINE3
+{
+    /**
+     * @brief Fixed-size pool of worker threads executing tasks in the order submitted.
+     */
+    class ThreadPool
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Constructor(s)
+        ///
+
+        /**
+         * @brief ThreadPool constructor.
+         * @param size - number of worker threads (0 = number of hardware threads).
+         */
+        explicit ThreadPool(std::size_t size = 0);
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief Completes the tasks already submitted and joins the worker threads.
+         */
+        ~ThreadPool();
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Number of worker threads.
+         */
+        std::size_t Size() const { return m_workers.size(); }
+
+        /**
+         * @brief Time each worker has spent running tasks (since construction or the last ResetBusyTimes).
+         * @remarks A task is accounted for by the time its future is ready; tasks still running are not.
+         */
+        std::vector<std::chrono::nanoseconds> BusyTimes() const;
+
+        /**
+         * @brief Restarts the busy time accounting.
+         */
+        void ResetBusyTimes();
+
+        /**
+         * @brief Submits a task for execution.
+         * @param task - callable object (with no arguments).
+         * @return future result of the task (exceptions thrown by the task are passed through it).
+         */
+        template<typename F>
+        auto Submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+        {
+            using R = std::invoke_result_t<std::decay_t<F>>;
+            auto packaged = std::make_shared<std::packaged_task<R()>>(
+                [task = std::forward<F>(task)]() mutable -> R { Busy busy; return task(); }    // (accounted before the result is ready)
+            );
+            std::future<R> result = packaged->get_future();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.emplace_back([packaged]() { (*packaged)(); });
+            }
+            m_ready.notify_one();
+            return result;
+        }
+
+    private:
+
+        /**
+         * @brief Adds the lifetime of the object to the busy time of the current worker.
+         */
+        class Busy
+        {
+        public:
+            Busy() : m_start(std::chrono::steady_clock::now()) {}
+            ~Busy()
+            {
+                if (t_busy)
+                    *t_busy += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+            }
+
+        private:
+            std::chrono::steady_clock::time_point m_start;
+        };
+
+        void run(std::size_t worker);
+
+        /// @brief Busy time counter of the worker running on the current thread (nullptr outside workers).
+        static inline thread_local std::atomic<std::chrono::nanoseconds::rep> *t_busy = nullptr;
+
+        std::vector<std::thread> m_workers;             /// Worker threads.
+        std::unique_ptr<std::atomic<std::chrono::nanoseconds::rep>[]> m_busy;  /// Busy time per worker [ns].
+        std::deque<std::function<void()>> m_tasks;      /// Tasks waiting for execution.
+        std::mutex m_mutex;                             /// Task queue guard.
+        std::condition_variable m_ready;                /// Task queue (or stop) signal.
+        bool m_stop;                                    /// Stop request.
+    };
+}
+
+#endif /* !THREADPOOL_H */
@@ -0,0 +1,108 @@
+#include <chrono>
+#include <memory>
+#include <sstream>
+
+#include "JobReader.h"
+#include "Phases.h"
+#include "Plume.h"
+#include "Report.h"
+#include "Throughput.h"
+
+namespace CALINE3
+{
+    // Elapsed time (in seconds)
+    using seconds_t = std::chrono::duration<double>;
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Methods
+    ///
+
+    bool Throughput::Run(const std::string &name, const std::string &input, ThreadPool *parser_pool)
+    {
+        m_stats = ThroughputStats{};
+        m_stats.InputBytes = input.size();
+        m_stats.Threads = m_engine.Threads();
+
+        std::istringstream is{ input };
+        std::unique_ptr<JobReader> rdr = parser_pool
+            ? std::make_unique<JobReader>(name.c_str(), is, *parser_pool)
+            : std::make_unique<JobReader>(name.c_str(), is);
+
+        // The report is rendered to memory (and dropped after each job):
+        std::ostringstream os;
+        Report report{ os };
+        ConcentrationMatrix MC;
+
+        for (;;)
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::optional<Job> site = rdr->Next();
+            m_stats.Parse += seconds_t(std::chrono::steady_clock::now() - start).count();
+            if (!site)
+                break;
+
+            for (auto const& meteo : site->Meteos)
+            {
+                start = std::chrono::steady_clock::now();
+                m_engine.Compute(*site, meteo, MC);
+                auto computed = std::chrono::steady_clock::now();
+                report.Print(*site, meteo, MC);
+                m_stats.Compute += seconds_t(computed - start).count();
+                m_stats.Report += seconds_t(std::chrono::steady_clock::now() - computed).count();
+
+                // Elements (untimed):
+                for (auto const& link : site->Links)
+                {
+                    const Plume plume{ *site, meteo, link };
+                    for (auto const& receptor : site->Receptors)
+                    {
+                        m_stats.Elements += plume.ElementCount(receptor.XR, receptor.YR, receptor.ZR);
+                    }
+                }
+            }
+
+            Timing::Flush(site->ORDINAL, site->JOB);
+            m_stats.Jobs++;
+            m_stats.Meteos += site->Meteos.size();
+            m_stats.Pairs += site->Meteos.size() * site->Links.size() * site->Receptors.size();
+            m_stats.ReportBytes += static_cast<std::size_t>(os.tellp());
+            os.str(std::string());
+        }
+
+        return !rdr->ErrorFound();
+    }
+
+    void Throughput::PrintJSON(std::ostream &os) const
+    {
+        const ThroughputStats &s = m_stats;
+        auto rate = [](double count, double seconds) { return (seconds > 0.0) ? count / seconds : 0.0; };
+        constexpr double MB = 1024.0 * 1024.0;
+
+        std::ostringstream json;
+        json.precision(6);
+        json
+            << "{\n"
+            << "  \"threads\": " << s.Threads << ",\n"
+            << "  \"input_bytes\": " << s.InputBytes << ",\n"
+            << "  \"report_bytes\": " << s.ReportBytes << ",\n"
+            << "  \"jobs\": " << s.Jobs << ",\n"
+            << "  \"meteos\": " << s.Meteos << ",\n"
+            << "  \"pairs\": " << s.Pairs << ",\n"
+            << "  \"elements\": " << s.Elements << ",\n"
+            << "  \"seconds\": { "
+            << "\"parse\": " << s.Parse << ", "
+            << "\"compute\": " << s.Compute << ", "
+            << "\"report\": " << s.Report << ", "
+            << "\"total\": " << s.Total() << " },\n"
+            << "  \"throughput\": {\n"
+            << "    \"pairs_per_sec\": " << rate(double(s.Pairs), s.Compute) << ",\n"
+            << "    \"elements_per_sec\": " << rate(double(s.Elements), s.Compute) << ",\n"
+            << "    \"jobs_per_sec\": " << rate(double(s.Jobs), s.Total()) << ",\n"
+            << "    \"parse_mb_per_sec\": " << rate(s.InputBytes / MB, s.Parse) << ",\n"
+            << "    \"report_mb_per_sec\": " << rate(s.ReportBytes / MB, s.Report) << "\n"
+            << "  }\n"
+            << "}\n";
+        os << json.str();
+    }
+}
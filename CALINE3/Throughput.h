@@ -0,0 +1,101 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef THROUGHPUT_H
+#define THROUGHPUT_H
+
+#include <ostream>
+#include <string>
+
+#include "Engine.h"
+#include "ThreadPool.h"
+
+namespace CALINE3
+{
+    /**
+     * @brief End-to-end throughput counts and phase times.
+     */
+    struct ThroughputStats
+    {
+        std::size_t InputBytes = 0;     /// Input size [bytes].
+        std::size_t ReportBytes = 0;    /// LST report size [bytes].
+        std::size_t Jobs = 0;           /// Jobs processed.
+        std::size_t Meteos = 0;         /// Meteos (concentration matrices) computed.
+        std::size_t Pairs = 0;          /// Link-receptor pairs evaluated (meteo x link x receptor).
+        std::size_t Elements = 0;       /// Link elements evaluated.
+        std::size_t Threads = 1;        /// Compute threads.
+        double Parse = 0.0;             /// Parse time [s].
+        double Compute = 0.0;           /// Compute time [s].
+        double Report = 0.0;            /// Report time [s].
+
+        double Total() const { return Parse + Compute + Report; }
+    };
+
+    /**
+     * @brief End-to-end benchmark: parses, computes and reports (to memory) all the jobs
+     * of an input, timing each phase, and reports normalized throughput.
+     */
+    class Throughput
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Constructor(s)
+        ///
+
+        /**
+         * @brief Throughput constructor.
+         * @param engine - engine to compute with.
+         */
+        explicit Throughput(const Engine &engine)
+            : m_engine(engine), m_stats()
+        {
+        }
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Runs all the jobs of the input.
+         * @param name - input name (for error messages),
+         * @param input - input data (read beforehand, so file I/O is not timed),
+         * @param parser_pool - parser threads (nullptr = serial parsing).
+         * @returns true if all the jobs have been processed, false on input error (reported to std::cerr).
+         * @remarks Link elements are counted in a separate (untimed) pass.
+         */
+        bool Run(const std::string &name, const std::string &input, ThreadPool *parser_pool);
+
+        /**
+         * @brief Counts and phase times of the last run.
+         */
+        const ThroughputStats &Stats() const { return m_stats; }
+
+        /**
+         * @brief Prints counts, times and throughput (pairs/s, elements/s, jobs/s, parse and report MB/s) as JSON.
+         */
+        void PrintJSON(std::ostream &os) const;
+
+    private:
+
+        const Engine &m_engine;
+        ThroughputStats m_stats;
+    };
+}
+
+#endif /* !THROUGHPUT_H */
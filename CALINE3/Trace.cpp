@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "Trace.h"
+#include "Json.h"
+
+namespace CALINE3
+{
+    namespace
+    {
+        /// @brief Capacity rounded up to a power of 2 (at least 2).
+        std::size_t ring_capacity(std::size_t capacity)
+        {
+            std::size_t n = 2;
+            while (n < capacity) n <<= 1;
+            return n;
+        }
+
+        /// @brief Spans still in a ring: the last (capacity) recorded.
+        template<typename F>
+        void for_each_span(const std::vector<TraceEvent>& events, std::uint64_t written, F&& f)
+        {
+            const std::uint64_t size = events.size();
+            for (std::uint64_t n = (written > size) ? written - size : 0; n < written; n++)
+            {
+                f(events[n & (size - 1)]);
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Constructor(s)
+    ///
+
+    TraceRecorder::TraceRecorder(std::size_t capacity) :
+        m_capacity(ring_capacity(capacity)),
+        m_generation(++s_generations),
+        m_epoch(std::chrono::steady_clock::now())
+    {
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Methods
+    ///
+
+    void TraceRecorder::Register()
+    {
+        auto ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ring->Events.resize(m_capacity);
+        ring->Tid = m_rings.size() + 1;
+        ring->Name = "thread " + std::to_string(ring->Tid);
+        m_rings.push_back(ring);
+        t_local.ring = std::move(ring);
+        t_local.Generation = m_generation.load(std::memory_order_relaxed);
+    }
+
+    void TraceRecorder::NameThread(const std::string& name)
+    {
+        Ring& ring = Local();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ring.Name = name;
+    }
+
+    void TraceRecorder::Reset(std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rings.clear();
+        m_capacity = ring_capacity(capacity);
+        m_generation.store(++s_generations, std::memory_order_relaxed);
+        m_epoch = std::chrono::steady_clock::now();
+    }
+
+    std::vector<TraceEvent> TraceRecorder::Events() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<TraceEvent> events;
+        for (auto const& ring : m_rings)
+        {
+            for_each_span(ring->Events, ring->Written.load(std::memory_order_acquire), [&events](const TraceEvent& event) { events.push_back(event); });
+        }
+        return events;
+    }
+
+    std::uint64_t TraceRecorder::Dropped() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::uint64_t dropped = 0;
+        for (auto const& ring : m_rings)
+        {
+            const std::uint64_t written = ring->Written.load(std::memory_order_acquire);
+            dropped += written - std::min<std::uint64_t>(written, ring->Events.size());
+        }
+        return dropped;
+    }
+
+    void TraceRecorder::WriteJSON(std::ostream& os) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::ostringstream json;
+        json << std::fixed << std::setprecision(3);
+        json << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        const char *separator = "\n";
+        std::uint64_t dropped = 0;
+        for (auto const& ring : m_rings)
+        {
+            json << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->Tid
+                 << ", \"args\": {\"name\": " << Json::Quoted(ring->Name) << "}}";
+            separator = ",\n";
+
+            const std::uint64_t written = ring->Written.load(std::memory_order_acquire);
+            dropped += written - std::min<std::uint64_t>(written, ring->Events.size());
+            for_each_span(ring->Events, written, [&json, &ring](const TraceEvent& event) {
+                // Times in microseconds:
+                json << ",\n{\"name\": " << Json::Quoted(event.Name) << ", \"cat\": " << Json::Quoted(event.Category)
+                     << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->Tid
+                     << ", \"ts\": " << event.Start * 1e-3 << ", \"dur\": " << event.Duration * 1e-3 << ", \"args\": {";
+                const char *comma = "";
+                if (event.Job >= 0) { json << "\"job\": " << event.Job + 1; comma = ", "; }
+                if (event.Meteo >= 0) { json << comma << "\"meteo\": " << event.Meteo + 1; comma = ", "; }
+                if (event.Link >= 0) { json << comma << "\"link\": " << event.Link + 1; }
+                json << "}}";
+            });
+        }
+        json << "\n], \"otherData\": {\"dropped\": " << dropped << "}}\n";
+        os << json.str();
+    }
+
+    TraceRecorder& TraceRecorder::Global()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+}
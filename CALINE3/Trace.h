@@ -0,0 +1,217 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace CALINE3
+{
+    /**
+     * @brief Span of activity on a thread (Chrome trace "complete" event).
+     */
+    struct TraceEvent
+    {
+        const char *Name = "";          /// Span name (string literal).
+        const char *Category = "";      /// Span category: reader, compute, plume, writer (string literal).
+        std::int64_t Start = 0;         /// Start [ns] since the recorder epoch.
+        std::int64_t Duration = 0;      /// Duration [ns].
+        std::int32_t Job = -1;          /// Job ordinal (-1 = not applicable).
+        std::int32_t Meteo = -1;        /// Meteo ordinal (-1 = not applicable).
+        std::int32_t Link = -1;         /// Link ordinal (-1 = not applicable).
+    };
+
+    /**
+     * @brief Execution timeline recorder writing Chrome/Perfetto trace-event JSON.
+     * @remarks Each thread records its spans to a ring buffer of its own (no locks, no allocation
+     * after the first span of the thread); when a ring is full the oldest spans are overwritten.
+     * Recording is off until enabled (TraceRecorder::Enable); spans then cost two clock reads.
+     * The JSON is to be written when the recording threads are idle (e.g. at the end of a run).
+     */
+    class TraceRecorder
+    {
+    public:
+
+        /// @brief Default ring buffer capacity (spans per thread).
+        static constexpr std::size_t DEFAULT_CAPACITY = std::size_t(1) << 16;
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Constructor(s)
+        ///
+
+        /**
+         * @brief Recorder constructor.
+         * @param capacity - ring buffer capacity (spans per thread; rounded up to a power of 2).
+         */
+        explicit TraceRecorder(std::size_t capacity = DEFAULT_CAPACITY);
+
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Time [ns] since the recorder epoch.
+         */
+        std::int64_t Now() const
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+        }
+
+        /**
+         * @brief Records a span on the ring of the current thread.
+         */
+        void Record(const TraceEvent& event)
+        {
+            Ring& ring = Local();
+            const std::uint64_t n = ring.Written.load(std::memory_order_relaxed);
+            ring.Events[n & (ring.Events.size() - 1)] = event;
+            ring.Written.store(n + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Names the current thread in the trace (threads are named "thread N" otherwise).
+         */
+        void NameThread(const std::string& name);
+
+        /**
+         * @brief Forgets all the spans (and starts a new epoch).
+         * @remarks Not to be called while other threads record.
+         * @param capacity - ring buffer capacity for the spans recorded from now on.
+         */
+        void Reset(std::size_t capacity = DEFAULT_CAPACITY);
+
+        /**
+         * @brief Spans still in the rings (ordered by thread, then by end time).
+         */
+        std::vector<TraceEvent> Events() const;
+
+        /**
+         * @brief Number of spans overwritten (lost) for lack of ring capacity.
+         */
+        std::uint64_t Dropped() const;
+
+        /**
+         * @brief Writes the spans as Chrome trace-event JSON (to open in chrome://tracing or ui.perfetto.dev).
+         */
+        void WriteJSON(std::ostream& os) const;
+
+        /**
+         * @brief Recorder the instrumented code records to.
+         */
+        static TraceRecorder& Global();
+
+        /**
+         * @brief Switches recording on (or off).
+         */
+        static void Enable(bool on) { s_enabled.store(on, std::memory_order_relaxed); }
+
+        /**
+         * @brief Is recording on?
+         */
+        static bool Enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    private:
+
+        /// @brief Ring buffer of a thread.
+        struct Ring
+        {
+            std::vector<TraceEvent> Events;         /// Spans (capacity a power of 2).
+            std::atomic<std::uint64_t> Written{ 0 };/// Spans recorded so far.
+            std::size_t Tid = 0;                    /// Thread number in the trace.
+            std::string Name;                       /// Thread name in the trace.
+        };
+
+        /// @brief Ring of the current thread (registered on first use).
+        Ring& Local()
+        {
+            if (t_local.Generation != m_generation.load(std::memory_order_relaxed))
+                Register();
+            return *t_local.ring;
+        }
+
+        void Register();
+
+        /// @brief The current thread ring as registered with a recorder (generation; thread storage is zero-initialized).
+        struct LocalRing
+        {
+            std::uint64_t Generation;
+            std::shared_ptr<Ring> ring;
+        };
+
+        mutable std::mutex m_mutex;                 /// Rings guard.
+        std::vector<std::shared_ptr<Ring>> m_rings; /// Rings of the recording threads.
+        std::size_t m_capacity;                     /// Ring capacity for new threads.
+        std::atomic<std::uint64_t> m_generation;    /// Recorder generation (unique, renewed on Reset).
+        std::chrono::steady_clock::time_point m_epoch;
+
+        static inline thread_local LocalRing t_local;
+        static inline std::atomic<std::uint64_t> s_generations{ 0 };
+        static inline std::atomic<bool> s_enabled{ false };
+    };
+
+    /**
+     * @brief Records the lifetime of the object as a span on the global recorder (if recording is on).
+     */
+    class TraceSpan
+    {
+    public:
+        TraceSpan(const char *name, const char *category, std::size_t job = SIZE_MAX, std::size_t meteo = SIZE_MAX, std::size_t link = SIZE_MAX)
+            : m_on(TraceRecorder::Enabled())
+        {
+            if (m_on)
+            {
+                m_event.Name = name;
+                m_event.Category = category;
+                m_event.Job = static_cast<std::int32_t>(job);
+                m_event.Meteo = static_cast<std::int32_t>(meteo);
+                m_event.Link = static_cast<std::int32_t>(link);
+                m_event.Start = TraceRecorder::Global().Now();
+            }
+        }
+
+        ~TraceSpan()
+        {
+            if (m_on)
+            {
+                TraceRecorder& recorder = TraceRecorder::Global();
+                m_event.Duration = recorder.Now() - m_event.Start;
+                recorder.Record(m_event);
+            }
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+    private:
+        bool m_on;
+        TraceEvent m_event;
+    };
+}
+
+#endif /* !TRACE_H */
@@ -0,0 +1,324 @@
+#include <charconv>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+#include "Workload.h"
+
+namespace CALINE3
+{
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Constants
+    ///
+
+    /// @brief Street grid block size [m].
+    constexpr double BLOCK = 400.0;
+
+    /// @brief Corridor segment length [m] and carriageway offset [m].
+    constexpr double SEGMENT = 500.0;
+    constexpr double CARRIAGEWAY = 15.0;
+
+    /// @brief S-curve step [m], amplitude [m] and wavelength [m].
+    constexpr double STEP = 200.0;
+    constexpr double AMPLITUDE = 300.0;
+    constexpr double WAVELENGTH = 2000.0;
+
+    /// @brief Wind speeds [m/s] to draw from.
+    constexpr double WIND_SPEED[] = { 1.0, 1.5, 2.0, 3.0, 5.0 };
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      EXP formatting helpers
+    ///
+
+    namespace
+    {
+        /// @brief Appends the number (shortest exact representation, FORTRAN-like "8500.") right-aligned in the field.
+        void number(std::string &line, double value, std::size_t width)
+        {
+            char buf[32];
+            auto result = std::to_chars(buf, buf + sizeof(buf), value);
+            std::string text(buf, static_cast<std::size_t>(result.ptr - buf));
+            if (text.find_first_of(".e") == std::string::npos)
+                text.push_back('.');
+            if (text.size() > width)
+                throw std::out_of_range("value " + text + " does not fit the EXP field of width " + std::to_string(width) + ".");
+            line.append(width - text.size(), ' ').append(text);
+        }
+
+        /// @brief Appends the integer right-aligned in the field.
+        void integer(std::string &line, std::size_t value, std::size_t width)
+        {
+            std::string text = std::to_string(value);
+            if (text.size() > width)
+                throw std::out_of_range("count " + text + " does not fit the EXP field of width " + std::to_string(width) + ".");
+            line.append(width - text.size(), ' ').append(text);
+        }
+
+        /// @brief Appends the text left-aligned in the field.
+        void text(std::string &line, const std::string& value, std::size_t width)
+        {
+            if (value.size() > width)
+                throw std::out_of_range("text \"" + value + "\" does not fit the EXP field of width " + std::to_string(width) + ".");
+            line.append(value).append(width - value.size(), ' ');
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Constructor(s)
+    ///
+
+    Workload::Workload(const WorkloadSpec& spec)
+        : m_spec(spec), m_segments(), m_random(spec.Seed)
+    {
+        if ((spec.Links == 0) || (spec.Receptors == 0) || (spec.Meteos == 0) || (spec.Lanes == 0) || (spec.Levels == 0))
+            throw std::invalid_argument("workload: links, receptors, meteos, lanes and levels must be at least 1.");
+        if (spec.Types.empty() || spec.Classes.empty() || spec.MixingHeights.empty())
+            throw std::invalid_argument("workload: link types, stability classes and mixing heights must not be empty.");
+        for (auto const& typ : spec.Types)
+        {
+            if ((typ != "AG") && (typ != "BR") && (typ != "FL") && (typ != "DP"))
+                throw std::invalid_argument("workload: link type \"" + typ + "\" not one of AG, BR, FL, DP.");
+        }
+        for (int clas : spec.Classes)
+        {
+            if ((clas < 1) || (6 < clas))
+                throw std::invalid_argument("workload: stability class " + std::to_string(clas) + " not within 1..6.");
+        }
+        for (double mixh : spec.MixingHeights)
+        {
+            if (!(mixh > 0.0))
+                throw std::invalid_argument("workload: mixing height must be positive.");
+        }
+
+        switch (spec.Geometry)
+        {
+            case Layout::Grid:     m_segments = Grid(); break;
+            case Layout::Corridor: m_segments = Corridor(); break;
+            case Layout::SCurve:   m_segments = SCurve(); break;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Methods
+    ///
+
+    Job Workload::Generate(std::size_t ordinal)
+    {
+        static const char *LAYOUT[] = { "GRID", "CORRIDOR", "S-CURVE" };
+
+        Job job{
+            ordinal,
+            std::string("SYNTHETIC ") + LAYOUT[static_cast<int>(m_spec.Geometry)],
+            Minute(60.0), Centimeter(100.0), Centimeter_Sec(m_spec.VS), Centimeter_Sec(m_spec.VD),
+            m_spec.Receptors, 1.0
+        };
+        job.setRUN("SEED " + std::to_string(m_spec.Seed) + " JOB " + std::to_string(ordinal + 1));
+
+        // Links (along the network segments; Lanes per segment):
+        job.Links.reserve(m_segments.size() * m_spec.Lanes);
+        for (auto const& s : m_segments)
+        {
+            const std::string& typ = m_spec.Types[Draw(m_spec.Types.size())];
+            double hl =
+                (typ == "BR") ? 5.0 + Draw(6) :
+                (typ == "FL") ? 1.0 + Draw(5) :
+                (typ == "DP") ? -1.0 - Draw(9) : 0.0;
+            double wl = 20.0 + 2.0 * Draw(6);
+            for (std::size_t lane = 0; lane < m_spec.Lanes; lane++)
+            {
+                double vphl = 500.0 * (1 + Draw(20));
+                double efl = 10.0 + Draw(41);
+
+                job.Links.emplace_back(
+                    job.Links.size(), "LINK " + std::to_string(job.Links.size() + 1), typ,
+                    Meter(s[0]), Meter(s[1]), Meter(s[2]), Meter(s[3]),
+                    Vehicles_Hour(vphl), Gram_Mile(efl), Meter(hl), Meter(wl)
+                );
+            }
+        }
+
+        // Receptors (either side of randomly chosen links, up to 200 m beyond the mixing zone; Levels at each location):
+        job.Receptors.reserve(m_spec.Receptors);
+        double xr = 0.0;
+        double yr = 0.0;
+        for (std::size_t r = 0; r < m_spec.Receptors; r++)
+        {
+            const std::size_t level = r % m_spec.Levels;
+            const double zr = std::round(10.0 * (1.8 + 3.0 * level)) / 10.0;    // (shortest representation, e.g. 4.8)
+            if (level > 0)
+            {
+                job.Receptors.emplace_back(r, "RECP. " + std::to_string(r + 1), Meter(xr), Meter(yr), Meter(zr));
+                continue;
+            }
+
+            const Link& link = job.Links[Draw(job.Links.size())];
+            double dx = (link.XL2 - link.XL1).value();
+            double dy = (link.YL2 - link.YL1).value();
+            double ll = std::hypot(dx, dy);
+            double along = Draw(101) / 100.0;
+            double across = (link.W2().value() + 5.0 + Draw(200)) * (Draw(2) ? 1.0 : -1.0);
+
+            xr = std::round(link.XL1.value() + along * dx - across * dy / ll) + 0.0;    // (no -0.)
+            yr = std::round(link.YL1.value() + along * dy + across * dx / ll) + 0.0;
+            job.Receptors.emplace_back(r, "RECP. " + std::to_string(r + 1), Meter(xr), Meter(yr), Meter(zr));
+        }
+
+        // Meteos:
+        job.Meteos.reserve(m_spec.Meteos);
+        for (std::size_t m = 0; m < m_spec.Meteos; m++)
+        {
+            double u = WIND_SPEED[Draw(std::size(WIND_SPEED))];
+            double brg = 10.0 * Draw(36);
+            int clas = m_spec.Classes[Draw(m_spec.Classes.size())];
+            double mixh = m_spec.MixingHeights[Draw(m_spec.MixingHeights.size())];
+            double amb = Draw(31) / 10.0;
+            job.Meteos.emplace_back(m, Meter_Sec(u), Degree(brg), clas, Meter(mixh), Ppm(amb));
+        }
+
+        return job;
+    }
+
+    void Workload::WriteEXP(std::ostream& os, const Job& job)
+    {
+        std::string page;
+        std::string line;
+
+        // Job (coordinates written in meters, i.e. SCAL = 1):
+        text(line, job.JOB, 40);
+        number(line, job.ATIM.value(), 4);
+        number(line, job.Z0.value(), 4);
+        number(line, job.VS1.value(), 5);
+        number(line, job.VD1.value(), 5);
+        integer(line, job.Receptors.size(), 2);
+        number(line, 1.0, 10);
+        page.append(line).push_back('\n');
+
+        for (auto const& r : job.Receptors)
+        {
+            line.clear();
+            text(line, r.RCP, 20);
+            number(line, r.XR.value(), 10);
+            number(line, r.YR.value(), 10);
+            number(line, r.ZR.value(), 10);
+            page.append(line).push_back('\n');
+        }
+
+        line.clear();
+        text(line, job.RUN, 40);
+        integer(line, job.Links.size(), 3);
+        integer(line, job.Meteos.size(), 3);
+        page.append(line).push_back('\n');
+
+        for (auto const& l : job.Links)
+        {
+            line.clear();
+            text(line, l.LNK, 20);
+            text(line, l.TYP, 2);
+            number(line, l.XL1.value(), 7);
+            number(line, l.YL1.value(), 7);
+            number(line, l.XL2.value(), 7);
+            number(line, l.YL2.value(), 7);
+            number(line, l.VPHL.value(), 8);
+            number(line, l.EFL.value(), 4);
+            number(line, l.HL.value(), 4);
+            number(line, l.WL.value(), 4);
+            page.append(line).push_back('\n');
+        }
+
+        for (auto const& m : job.Meteos)
+        {
+            line.clear();
+            number(line, m.U.value(), 3);
+            number(line, m.BRG1.value(), 4);
+            integer(line, static_cast<std::size_t>(m.CLAS), 1);
+            number(line, m.MIXH.value(), 6);
+            number(line, m.AMB.value(), 4);
+            page.append(line).push_back('\n');
+        }
+
+        os.write(page.data(), static_cast<std::streamsize>(page.size()));
+    }
+
+    Layout Workload::ParseLayout(const std::string& name)
+    {
+        if (name == "grid") return Layout::Grid;
+        if (name == "corridor") return Layout::Corridor;
+        if (name == "scurve") return Layout::SCurve;
+        throw std::invalid_argument("unknown layout \"" + name + "\" (expected grid, corridor or scurve).");
+    }
+
+    std::size_t Workload::Draw(std::size_t n)
+    {
+        return static_cast<std::size_t>(m_random() % n);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    ///      Geometry
+    ///
+
+    std::vector<Workload::Segment> Workload::Grid() const
+    {
+        // k x k nodes make 2k(k-1) street segments:
+        std::size_t k = 2;
+        while (2 * k * (k - 1) < m_spec.Links) k++;
+
+        // Nodes centered on the origin; segments to the east and north of each node, row by row:
+        const double origin = -BLOCK * static_cast<double>(k - 1) / 2.0;
+        std::vector<Segment> segments;
+        segments.reserve(m_spec.Links);
+        for (std::size_t j = 0; (j < k) && (segments.size() < m_spec.Links); j++)
+        {
+            for (std::size_t i = 0; (i < k) && (segments.size() < m_spec.Links); i++)
+            {
+                double x = origin + BLOCK * i;
+                double y = origin + BLOCK * j;
+                if (i + 1 < k)
+                    segments.push_back({ x, y, x + BLOCK, y });
+                if ((j + 1 < k) && (segments.size() < m_spec.Links))
+                    segments.push_back({ x, y, x, y + BLOCK });
+            }
+        }
+        return segments;
+    }
+
+    std::vector<Workload::Segment> Workload::Corridor() const
+    {
+        // Eastbound (south) and westbound (north) carriageways:
+        const std::size_t count = (m_spec.Links + 1) / 2;
+        const double origin = -SEGMENT * std::floor(count / 2.0);
+        std::vector<Segment> segments;
+        segments.reserve(m_spec.Links);
+        for (std::size_t n = 0; n < m_spec.Links; n++)
+        {
+            double x = origin + SEGMENT * (n / 2);
+            if (n % 2 == 0)
+                segments.push_back({ x, -CARRIAGEWAY, x + SEGMENT, -CARRIAGEWAY });
+            else
+                segments.push_back({ x + SEGMENT, CARRIAGEWAY, x, CARRIAGEWAY });
+        }
+        return segments;
+    }
+
+    std::vector<Workload::Segment> Workload::SCurve() const
+    {
+        // Road winding (northwards) around the Y-axis, one segment per STEP:
+        const double PI = std::acos(-1.0);
+        const double origin = -STEP * std::floor(m_spec.Links / 2.0);
+        auto x = [PI](double y) { return std::round(AMPLITUDE * std::sin(2.0 * PI * y / WAVELENGTH)) + 0.0; };  // (no -0.)
+
+        std::vector<Segment> segments;
+        segments.reserve(m_spec.Links);
+        for (std::size_t n = 0; n < m_spec.Links; n++)
+        {
+            double y1 = origin + STEP * n;
+            double y2 = y1 + STEP;
+            segments.push_back({ x(y1), y1, x(y2), y2 });
+        }
+        return segments;
+    }
+}
@@ -0,0 +1,135 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Job.h"
+
+namespace CALINE3
+{
+    /**
+     * @brief Road network geometry of a synthetic job.
+     */
+    enum class Layout
+    {
+        Grid,       /// Street grid (square blocks).
+        Corridor,   /// Straight dual carriageway split into segments.
+        SCurve      /// Winding road (as in EXAMPLE TWO) split into segments.
+    };
+
+    /**
+     * @brief Synthetic job specification.
+     */
+    struct WorkloadSpec
+    {
+        std::size_t Links = 10;                         /// Number of links (NL).
+        std::size_t Receptors = 20;                     /// Number of receptors (NR).
+        std::size_t Meteos = 4;                         /// Number of meteo conditions (NM).
+        std::size_t Lanes = 1;                          /// Links along each road segment (the same geometry, own VPHL and EFL; NL = Links * Lanes).
+        std::size_t Levels = 1;                         /// Receptors stacked at each XY location (3 m apart, from 1.8 m up).
+        Layout Geometry = Layout::Grid;                 /// Road network geometry.
+        std::vector<std::string> Types{ "AG" };         /// Link types to draw from (AG, BR, FL, DP).
+        std::vector<int> Classes{ 1, 2, 3, 4, 5, 6 };   /// Stability classes to draw from.
+        std::vector<double> MixingHeights{ 1000.0 };    /// Mixing heights [m] to draw from.
+        double VS = 0.0;                                /// Settling velocity [cm/s].
+        double VD = 0.0;                                /// Deposition velocity [cm/s].
+        std::uint64_t Seed = 1;                         /// Random generator seed.
+    };
+
+    /**
+     * @brief Deterministic (seedable) generator of synthetic jobs, for benchmarks and stress tests.
+     * @remarks Jobs are reproducible across platforms for the same spec (and seed): the values are
+     * drawn from std::mt19937_64 directly (not via implementation-defined distributions) and are
+     * all representable in the EXP format fields, so a job written with WriteEXP and read back
+     * with JobReader is identical to the one generated in memory.
+     */
+    class Workload
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Constructor(s)
+        ///
+
+        /**
+         * @brief Workload constructor.
+         * @param spec - job specification.
+         * @throws std::invalid_argument for an invalid spec (e.g. unknown link type).
+         */
+        explicit Workload(const WorkloadSpec& spec);
+
+        ////////////////////////////////////////////////////////////////////////////
+        ///
+        ///      Methods
+        ///
+
+        /**
+         * @brief Generates the next job (in memory).
+         * @param ordinal - job ordinal number.
+         * @remarks Each call continues the random sequence, so consecutive jobs differ
+         * (in link types, receptor positions and meteos) but are reproducible as a series.
+         */
+        Job Generate(std::size_t ordinal = 0);
+
+        /**
+         * @brief Writes the job in the legacy EXP (CALINE3 input) format.
+         * @param os - output stream,
+         * @param job - job to write.
+         * @throws std::out_of_range if the job does not fit in the EXP fields
+         * (e.g. more than 99 receptors or 999 links/meteos).
+         */
+        static void WriteEXP(std::ostream& os, const Job& job);
+
+        /**
+         * @brief Parses layout name: "grid", "corridor" or "scurve".
+         * @throws std::invalid_argument for an unknown name.
+         */
+        static Layout ParseLayout(const std::string& name);
+
+    private:
+
+        /// @brief Link endpoints (XL1, YL1, XL2, YL2) [m].
+        using Segment = std::vector<double>;
+
+        std::vector<Segment> Grid() const;
+        std::vector<Segment> Corridor() const;
+        std::vector<Segment> SCurve() const;
+
+        /**
+         * @brief Random integer within [0, n).
+         */
+        std::size_t Draw(std::size_t n);
+
+        ///////////////////////////////////////////////////////////////////////////
+        //
+        //      Fields
+        //
+
+        WorkloadSpec m_spec;
+        std::vector<Segment> m_segments;    /// Road network (the same for all jobs).
+        std::mt19937_64 m_random;
+    };
+}
+
+#endif /* !WORKLOAD_H */
@@ -0,0 +1,106 @@
+/*******************************************************************************
+
+    Units of Measurement for C# applications applied to
+    the CALINE3 Model algorithm.
+
+    For more information on CALINE3 and its status see:
+    * https://www.epa.gov/scram/air-quality-dispersion-modeling-alternative-models#caline3
+    * https://www.epa.gov/scram/2017-appendix-w-final-rule.
+
+    Copyright (C) mangh
+
+    This program is provided to you under the terms of the license
+    as published at https://github.com/mangh/metrology.
+
+********************************************************************************/
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Workload.h"
+
+using namespace CALINE3;
+
+/**
+ * @brief Splits comma-separated list.
+ */
+static std::vector<std::string> list_arg(const char *arg)
+{
+    std::vector<std::string> items;
+    std::istringstream is{ arg };
+    std::string item;
+    while (std::getline(is, item, ','))
+    {
+        items.push_back(item);
+    }
+    return items;
+}
+
+static int usage(const char *app)
+{
+    const char *name = app ? app : "Caline3Workload";
+    std::cerr
+        << "Usage: " << name << " [--jobs=J] [--links=N] [--receptors=M] [--meteos=K] [--lanes=N] [--levels=Z] [--layout=grid|corridor|scurve]" << std::endl
+        << "       " << std::string(std::strlen(name), ' ') << " [--types=AG,BR,FL,DP] [--classes=1,...,6] [--mixh=1000,...] [--vs=CM_S] [--vd=CM_S] [--seed=S]" << std::endl
+        << "(writes synthetic jobs in the CALINE3 input format to the standard output)" << std::endl;
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    WorkloadSpec spec;
+    std::size_t jobs = 1;
+
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const char *arg = argv[i];
+            const char *value = std::strchr(arg, '=');
+            if ((std::strncmp(arg, "--", 2) != 0) || !value)
+                return usage(argv[0]);
+            const std::string option(arg, static_cast<std::size_t>(value - arg));
+            value++;
+
+            if (option == "--jobs") jobs = std::stoul(value);
+            else if (option == "--links") spec.Links = std::stoul(value);
+            else if (option == "--receptors") spec.Receptors = std::stoul(value);
+            else if (option == "--meteos") spec.Meteos = std::stoul(value);
+            else if (option == "--lanes") spec.Lanes = std::stoul(value);
+            else if (option == "--levels") spec.Levels = std::stoul(value);
+            else if (option == "--layout") spec.Geometry = Workload::ParseLayout(value);
+            else if (option == "--types") spec.Types = list_arg(value);
+            else if (option == "--vs") spec.VS = std::stod(value);
+            else if (option == "--vd") spec.VD = std::stod(value);
+            else if (option == "--seed") spec.Seed = std::stoull(value);
+            else if (option == "--classes")
+            {
+                spec.Classes.clear();
+                for (auto const& item : list_arg(value)) spec.Classes.push_back(std::stoi(item));
+            }
+            else if (option == "--mixh")
+            {
+                spec.MixingHeights.clear();
+                for (auto const& item : list_arg(value)) spec.MixingHeights.push_back(std::stod(item));
+            }
+            else
+                return usage(argv[0]);
+        }
+
+        Workload workload{ spec };
+        for (std::size_t J = 0; J < jobs; J++)
+        {
+            Workload::WriteEXP(std::cout, workload.Generate(J));
+        }
+        std::cout.flush();
+    }
+    catch (std::exception const& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 3;
+    }
+    return 0;
+}
@@ -2,10 +2,32 @@
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 
 #include <clocale>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
 #include <sstream>
 
+#include "../CALINE3/Counters.h"
+#include "../CALINE3/Daemon.h"
+#include "../CALINE3/Engine.h"
 #include "../CALINE3/JobReader.h"
+#include "../CALINE3/Json.h"
+#include "../CALINE3/Memory.h"
+#include "../CALINE3/PerfCounters.h"
+#include "../CALINE3/Phases.h"
 #include "../CALINE3/Plume.h"
+#include "../CALINE3/Report.h"
+#include "../CALINE3/ResultStore.h"
+#include "../CALINE3/ThreadPool.h"
+#include "../CALINE3/Throughput.h"
+#include "../CALINE3/Trace.h"
 
 // Test input data (obtained using MSVC on Windows 11)
 const char* test_data = R"sample(EXAMPLE FOUR                             60.100.   0.   0.12        1.
@@ -104,4 +126,711 @@ namespace CALINE3::Metrology
             }
         }
     }
+
+    TEST_CASE( "check streaming job reader" , "[CALINE3][reader]")
+    {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        std::istringstream input_stream{ std::string(test_data) + test_data + test_data };
+        JobReader job_reader{ "INTERNAL DATA", input_stream };
+
+        SECTION("owned jobs handed out one at a time", "[CALINE3]")
+        {
+            std::optional<Job> job = job_reader.Next();
+            REQUIRE(job.has_value());
+            CHECK(job->ORDINAL == 0);
+            CHECK(job->RUN == "URBAN LOCATION: MULTIPLE LINKS, ETC.");
+
+            Job owned = std::move(*job);
+            CHECK(owned.Links.size() == 6);
+            CHECK(owned.Receptors.size() == 12);
+            CHECK(owned.Meteos.size() == 4);
+
+            std::optional<Job> next = job_reader.Next();
+            REQUIRE(next.has_value());
+            CHECK(next->ORDINAL == 1);
+        }
+
+        SECTION("jobs iterated in order", "[CALINE3]")
+        {
+            std::size_t count = 0;
+            for (auto const& job : job_reader)
+            {
+                CHECK(job.ORDINAL == count++);
+                CHECK(job.Meteos.size() == 4);
+            }
+            CHECK(count == 3);
+            CHECK(!job_reader.ErrorFound());
+            CHECK(!job_reader.Next().has_value());
+        }
+    }
+
+    TEST_CASE( "check parallel job reader" , "[CALINE3][reader]")
+    {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        ThreadPool pool{ 3 };
+
+        SECTION("jobs handed out in the input order", "[CALINE3]")
+        {
+            std::string data;
+            for (int i = 0; i < 10; i++) data += test_data;
+
+            std::istringstream input_stream{ data };
+            JobReader job_reader{ "INTERNAL DATA", input_stream, pool, 4 };
+
+            std::size_t count = 0;
+            for (auto const& job : job_reader)
+            {
+                CHECK(job.ORDINAL == count++);
+                CHECK(job.RUN == "URBAN LOCATION: MULTIPLE LINKS, ETC.");
+                CHECK(job.Receptors.size() == 12);
+                CHECK(job.Links.size() == 6);
+                CHECK(job.Meteos.size() == 4);
+                CHECK(job.Receptors[4].XR.value() == -850.0);
+            }
+            CHECK(count == 10);
+            CHECK(!job_reader.ErrorFound());
+        }
+
+        SECTION("errors reported against the global line number", "[CALINE3]")
+        {
+            // Corrupt the 5th receptor (line 5 + 1) of the 3rd job (24 lines each):
+            std::string corrupted{ test_data };
+            corrupted.replace(corrupted.find("-850."), 5, "abcd.");
+            std::istringstream input_stream{ std::string(test_data) + test_data + corrupted + test_data };
+
+            std::ostringstream log;
+            std::streambuf *cerr_buf = std::cerr.rdbuf(log.rdbuf());
+
+            JobReader job_reader{ "INTERNAL DATA", input_stream, pool };
+            std::size_t count = 0;
+            while (job_reader.Read()) count++;
+
+            std::cerr.rdbuf(cerr_buf);
+
+            CHECK(count == 2);
+            CHECK(job_reader.ErrorFound());
+            CHECK(log.str().find("INTERNAL DATA: file corrupted at line 54 ") == 0);
+        }
+    }
+
+    TEST_CASE( "check daemon protocol" , "[CALINE3][daemon]")
+    {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        ThreadPool pool{ 2 };
+        Engine engine{ &pool };
+        Daemon daemon{ engine };
+
+        const std::string input{ test_data };
+        std::istringstream requests{
+            "PING\n"
+            "RUN csv " + std::to_string(input.size()) + "\n" + input +
+            "RUN xml 0\n"
+            "QUIT\n"
+            "PING\n"
+        };
+        std::stringstream responses;
+
+        daemon.Serve(requests, responses);
+
+        std::string header;
+        REQUIRE(std::getline(responses, header));
+        CHECK(header == "OK 0");
+
+        // CSV results:
+        REQUIRE(std::getline(responses, header));
+        REQUIRE(header.rfind("OK ", 0) == 0);
+        std::string csv(std::stoul(header.substr(3)), '\0');
+        REQUIRE(responses.read(csv.data(), static_cast<std::streamsize>(csv.size())));
+
+        std::istringstream lines{ csv };
+        std::string line;
+        REQUIRE(std::getline(lines, line));
+        CHECK(line == "JOB,METEO,LINK,RECEPTOR,MC");
+
+        std::size_t count = 0;
+        while (std::getline(lines, line))
+        {
+            std::size_t job, meteo, link, receptor;
+            char comma;
+            double mc;
+            std::istringstream fields{ line };
+            REQUIRE((fields >> job >> comma >> meteo >> comma >> link >> comma >> receptor >> comma >> mc));
+            CHECK(job == 1);
+            CHECK_THAT(mc, Catch::Matchers::WithinRel(test_result[meteo - 1][link - 1][receptor - 1], 1.0e-15));
+            count++;
+        }
+        CHECK(count == 4 * 6 * 12);
+
+        // Unknown format:
+        REQUIRE(std::getline(responses, header));
+        CHECK(header.rfind("ERROR ", 0) == 0);
+        std::string error(std::stoul(header.substr(6)), '\0');
+        REQUIRE(responses.read(error.data(), static_cast<std::streamsize>(error.size())));
+
+        // Nothing served after QUIT:
+        CHECK(!std::getline(responses, header));
+
+        // Requests over the limit (or cut short) are refused and the connection closed:
+        const Daemon limited{ engine, 1024 };
+        for (const std::string& request : {
+            std::string("RUN csv 1025\n") + std::string(1025, 'x') + "PING\n",
+            std::string("RUN csv 18446744073709551615\nPING\n"),
+            std::string("RUN csv -1\nPING\n"),
+            std::string("RUN csv 100\nPING\n") })
+        {
+            std::istringstream refused{ request };
+            std::stringstream answer;
+            limited.Serve(refused, answer);
+            REQUIRE(std::getline(answer, header));
+            CHECK(header.rfind("ERROR ", 0) == 0);
+            std::string message(std::stoul(header.substr(6)), '\0');
+            REQUIRE(answer.read(message.data(), static_cast<std::streamsize>(message.size())));
+            CHECK(!std::getline(answer, header));     // (PING not served)
+        }
+
+#ifndef _WIN32
+        // A file other than a socket is not replaced by the daemon socket:
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "caline3-daemon-test.exp";
+        {
+            std::ofstream file{ path };
+            file << input;
+        }
+        CHECK(daemon.Listen(path.string()) == 5);
+        CHECK(std::filesystem::file_size(path) == input.size());
+        std::filesystem::remove(path);
+#endif
+    }
+
+    TEST_CASE( "check LST report" , "[CALINE3][report]")
+    {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        std::istringstream input_stream{test_data };
+        JobReader job_reader{ "INTERNAL DATA", input_stream };
+
+        REQUIRE(job_reader.Read());
+
+        const Job& site = job_reader.LastJob();
+
+        auto compute = [&site](const Meteo& meteo)
+        {
+            ConcentrationMatrix MC{ site.Links.size() };
+            for (auto const& link : site.Links)
+            {
+                Plume plume(site, meteo, link);
+                MC[link.ORDINAL].resize( site.Receptors.size() );
+                for (auto const& receptor : site.Receptors)
+                {
+                    MC[link.ORDINAL][receptor.ORDINAL] = plume.ConcentrationAt(receptor);
+                }
+            }
+            return MC;
+        };
+
+        std::ostringstream output;
+        Report report{ output };
+
+        // The second page reuses the sections cached for the job on the first one:
+        report.Print(site, site.Meteos[1], compute(site.Meteos[1]));
+        output.str("");
+        report.Print(site, site.Meteos[0], compute(site.Meteos[0]));
+
+        // Expected lines as found in CALINE3.LST (EXAMPLE FOUR, first meteo):
+        const char *expected[] = {
+            "PAGE 2\n",
+            "   A. LINK A                *   500       0    3000       0  *     2500        90       AG   9700   30.0   0.0  23.0\n",
+            "    1. RECP. 1              *     -350       30       1.8   * 12.0  *  0.0  0.0  0.0  0.0  0.0  0.0\n",
+            "    2. RECP. 2              *        0       30       1.8   * 12.0  *  0.0  0.0  0.0  0.0  0.0  0.0\n",
+            "    3. RECP. 3              *      750      100       1.8   * 12.0  *  0.0  0.0  0.0  0.0  0.0  0.0\n",
+            "    4. RECP. 4              *      850       30       1.8   * 14.8  *  0.0  2.8  0.0  0.0  0.0  0.0\n",
+            "    5. RECP. 5              *     -850     -100       1.8   * 21.6  *  0.0  0.0  3.6  6.0  0.0  0.0\n",
+            "    6. RECP. 6              *     -550     -100       1.8   * 21.9  *  0.0  0.0  3.6  6.0  0.3  0.0\n",
+            "    7. RECP. 7              *     -350     -100       1.8   * 21.6  *  0.0  0.0  3.6  6.0  0.0  0.0\n",
+            "    8. RECP. 8              *       50     -100       1.8   * 21.6  *  0.0  0.0  3.6  6.0  0.0  0.0\n",
+            "    9. RECP. 9              *      450     -100       1.8   * 21.6  *  0.0  0.0  3.6  6.0  0.0  0.0\n",
+            "   10. RECP. 10             *      800     -100       1.8   * 22.6  *  3.2  1.4  0.0  6.0  0.0  0.0\n",
+            "   11. RECP. 11             *     -550       25       1.8   * 12.0  *  0.0  0.0  0.0  0.0  0.0  0.0\n",
+            "   12. RECP. 12             *     -550       25       6.1   * 12.0  *  0.0  0.0  0.0  0.0  0.0  0.0\n",
+        };
+
+        const std::string page = output.str();
+        for (auto const* line : expected)
+        {
+            CHECK(page.find(line) != std::string::npos);
+        }
+    }
+
+    TEST_CASE( "check binary result store" , "[CALINE3][store]")
+    {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        std::istringstream input_stream{test_data };
+        JobReader job_reader{ "INTERNAL DATA", input_stream };
+
+        REQUIRE(job_reader.Read());
+
+        const Job& site = job_reader.LastJob();
+        const std::string path = (std::filesystem::temp_directory_path() / "caline3_test_store.c3r").string();
+
+        {
+            ResultStore::Writer writer{ path };
+            for (auto const& meteo : site.Meteos)
+            {
+                ConcentrationMatrix MC{ site.Links.size() };
+                for (auto const& link : site.Links)
+                {
+                    Plume plume(site, meteo, link);
+                    MC[link.ORDINAL].resize( site.Receptors.size() );
+                    for (auto const& receptor : site.Receptors)
+                    {
+                        MC[link.ORDINAL][receptor.ORDINAL] = plume.ConcentrationAt(receptor);
+                    }
+                }
+                writer.Append(site, meteo, MC);
+            }
+        }
+
+        {
+            ResultStore::Reader reader{ path };
+
+            REQUIRE(reader.JobCount() == 1);
+            REQUIRE(reader.JobAt(0).NM == site.Meteos.size());
+            REQUIRE(reader.JobAt(0).NL == site.Links.size());
+            REQUIRE(reader.JobAt(0).NR == site.Receptors.size());
+            CHECK(ResultStore::Reader::Field(reader.JobAt(0).JOB, ResultStore::TITLE_SIZE) == site.JOB);
+            CHECK(reader.LinkName(0, 1) == "LINK B");
+            CHECK(reader.ReceptorName(0, 11) == "RECP. 12");
+
+            for (auto const& meteo : site.Meteos)
+            {
+                CHECK(reader.MatrixAt(0, meteo.ORDINAL).AMB == meteo.AMB.value());
+                for (auto const& link : site.Links)
+                {
+                    for (auto const& receptor : site.Receptors)
+                    {
+                        CHECK_THAT(reader.Concentration(0, meteo.ORDINAL, link.ORDINAL, receptor.ORDINAL), Catch::Matchers::WithinRel(
+                                test_result[meteo.ORDINAL][link.ORDINAL][receptor.ORDINAL],
+                                1.0e-15
+                            )
+                        );
+                    }
+                }
+            }
+
+            std::vector<double> series = reader.ReceptorSeries(0, ResultStore::Reader::ALL, 3);
+            REQUIRE(series.size() == site.Meteos.size());
+            CHECK(series[0] == reader.Concentration(0, 0, ResultStore::Reader::ALL, 3));
+        }
+
+        // Truncated or corrupt files are rejected on open (rather than read out of bounds later):
+        std::string bytes;
+        {
+            std::ifstream file{ path, std::ios::binary };
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        ResultStore::FileHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        const std::size_t job_at = static_cast<std::size_t>(header.INDEX_OFFSET);
+        const std::size_t matrix_at = job_at + static_cast<std::size_t>(header.JOB_COUNT) * sizeof(ResultStore::JobRecord);
+
+        auto rejected = [&path](std::string corrupted) {
+            {
+                std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+                file.write(corrupted.data(), static_cast<std::streamsize>(corrupted.size()));
+            }
+            CHECK_THROWS_AS(ResultStore::Reader{ path }, std::runtime_error);
+        };
+        auto patched = [&bytes](std::size_t at, std::uint64_t value) {
+            std::string corrupted{ bytes };
+            std::memcpy(&corrupted[at], &value, sizeof(value));
+            return corrupted;
+        };
+        rejected(bytes.substr(0, bytes.size() - 1));
+        rejected(patched(offsetof(ResultStore::FileHeader, MATRIX_COUNT), std::uint64_t{ 1 } << 61));   // (count * size overflows)
+        rejected(patched(offsetof(ResultStore::FileHeader, INDEX_OFFSET), ~std::uint64_t{ 0 } - 7));
+        rejected(patched(job_at + offsetof(ResultStore::JobRecord, FIRST_MATRIX), 1));
+        rejected(patched(job_at + offsetof(ResultStore::JobRecord, NM), ~std::uint64_t{ 0 }));
+        rejected(patched(job_at + offsetof(ResultStore::JobRecord, FIRST_NAME), header.NAME_COUNT));
+        rejected(patched(matrix_at + offsetof(ResultStore::MatrixRecord, OFFSET), header.INDEX_OFFSET - 8));
+        rejected(patched(matrix_at + offsetof(ResultStore::MatrixRecord, OFFSET), ~std::uint64_t{ 0 } - 7));
+
+        std::remove(path.c_str());
+    }
+
+    TEST_CASE( "check throughput benchmark" , "[CALINE3][throughput]")
+    {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        const std::string input = std::string(test_data) + test_data;
+        const Engine engine;
+        Throughput throughput{ engine };
+
+        REQUIRE(throughput.Run("INTERNAL DATA", input, nullptr));
+
+        const ThroughputStats &stats = throughput.Stats();
+        CHECK(stats.InputBytes == input.size());
+        CHECK(stats.Jobs == 2);
+        CHECK(stats.Meteos == 8);
+        CHECK(stats.Pairs == 2 * 4 * 6 * 12);
+        CHECK(stats.Elements > stats.Pairs);
+        CHECK(stats.ReportBytes > 0);
+        CHECK(stats.Threads == 1);
+
+        std::ostringstream json;
+        throughput.PrintJSON(json);
+        CHECK(json.str().find("\"pairs\": 576,") != std::string::npos);
+        CHECK(json.str().find("\"pairs_per_sec\": ") != std::string::npos);
+    }
+
+    TEST_CASE( "check erf variants" , "[CALINE3][erf]")
+    {
+        CHECK(Maths::ParseErfVariant("vector") == ErfVariant::Vector);
+        CHECK_THROWS_AS(Maths::ParseErfVariant("exact"), std::invalid_argument);
+
+        std::vector<double> x;
+        for (double v = -6.0; v <= 6.0; v += 1.0 / 64.0)
+        {
+            x.push_back(v);
+        }
+        x.push_back(-0.0);
+
+        std::vector<double> y(x.size());
+        Maths::Erf(ErfVariant::Vector, x.data(), y.data(), x.size());
+        for (std::size_t i = 0; i < x.size(); i++)
+        {
+            CHECK(y[i] == Maths::Erf(x[i]));    // (bit for bit)
+            CHECK_THAT(Maths::Erf(ErfVariant::Std, x[i]), Catch::Matchers::WithinAbs(Maths::Erf(x[i]), 1.5e-7));
+            CHECK_THAT(Maths::Erf(ErfVariant::Fast, x[i]), Catch::Matchers::WithinAbs(Maths::Erf(x[i]), 2.5e-5 + 1.5e-7));
+        }
+
+        // Concentrations (as reported, to 0.1 ppm) do not tell the variants apart:
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        std::istringstream is{ test_data };
+        std::ostringstream log;
+        JobReader job_reader{ "INTERNAL DATA", is, log };
+        auto job = job_reader.Next();
+        REQUIRE(job.has_value());
+
+        const Engine reference;
+        ConcentrationMatrix expected, actual;
+        for (ErfVariant variant : { ErfVariant::Std, ErfVariant::Fast, ErfVariant::Vector })
+        {
+            const Engine engine{ nullptr, Partition::Links, 0, MathPolicy{ variant } };
+            for (auto const& meteo : job->Meteos)
+            {
+                reference.Compute(*job, meteo, expected);
+                engine.Compute(*job, meteo, actual);
+                for (auto const& link : job->Links)
+                {
+                    for (auto const& receptor : job->Receptors)
+                    {
+                        if (variant == ErfVariant::Vector)
+                            CHECK(actual[link.ORDINAL][receptor.ORDINAL] == expected[link.ORDINAL][receptor.ORDINAL]);
+                        else
+                            CHECK_THAT(actual[link.ORDINAL][receptor.ORDINAL].value(), Catch::Matchers::WithinAbs(expected[link.ORDINAL][receptor.ORDINAL].value(), 1.0));  // (< 0.001 ppm)
+                    }
+                }
+            }
+        }
+    }
+
+    TEST_CASE( "check hot path counters" , "[CALINE3][counters]")
+    {
+        CounterLog log;
+        Counters counts;
+        counts.Pairs = 12;
+        counts.Elements = 100;
+        counts.NoProfile = 40;
+        log.Add(0, "EXAMPLE \"Q\"", 1, 2, counts);
+        log.Add(0, "EXAMPLE \"Q\"", 1, 2, counts);
+        log.Add(1, "OTHER", 0, 0, counts);
+
+        CHECK(log.Entries().size() == 2);
+        CHECK(log.Total().Elements == 300);
+        CHECK(log.Entries().at(CounterLog::Key{ 0, 1, 2 }).Pairs == 24);
+
+        std::ostringstream json;
+        log.PrintJSON(json);
+        CHECK(json.str().find("\"total\": { \"pairs\": 36, \"elements\": 300, \"no_profile\": 120,") != std::string::npos);
+        CHECK(json.str().find("{ \"job\": 1, \"title\": \"EXAMPLE \\\"Q\\\"\", \"meteo\": 2, \"link\": 3, \"pairs\": 24,") != std::string::npos);
+
+        std::ostringstream text;
+        log.PrintText(text, 1);
+        CHECK(text.str().find("1 / 2 / 3") != std::string::npos);
+        CHECK(text.str().find("2 / 1 / 1") == std::string::npos);   // (not in the top 1)
+
+        log.Clear();
+        CHECK(log.Entries().empty());
+
+#ifdef CALINE3_COUNTERS
+        // Counts do not depend on the threads:
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        std::istringstream is{ test_data };
+        JobReader job_reader{ "INTERNAL DATA", is };
+        auto job = job_reader.Next();
+        REQUIRE(job.has_value());
+
+        ThreadPool pool{ 3 };
+        ConcentrationMatrix MC;
+        for (const Engine& engine : { Engine{}, Engine{ &pool, Partition::ReceptorBlocks, 5 } })
+        {
+            CounterLog::Global().Clear();
+            for (auto const& meteo : job->Meteos)
+            {
+                engine.Compute(*job, meteo, MC);
+            }
+            const Counters total = CounterLog::Global().Total();
+            CHECK(total.Pairs == 4 * 6 * 12);
+            CHECK(total.Elements == 4458);
+            CHECK(total.NoProfile == 2198);
+            CHECK(total.DepositionNaN == 0);
+            CHECK(total.GaussianIterations == 2260);
+            CHECK(CounterLog::Global().Entries().size() == 4 * 6);
+        }
+#endif
+    }
+
+    TEST_CASE( "check JSON strings" , "[CALINE3][json]")
+    {
+        CHECK(Json::Quoted("EXAMPLE ONE") == "\"EXAMPLE ONE\"");
+        CHECK(Json::Quoted("A \"B\" C:\\D") == "\"A \\\"B\\\" C:\\\\D\"");
+        CHECK(Json::Quoted("A\tB\nC\rD\bE\fF") == "\"A\\tB\\nC\\rD\\bE\\fF\"");
+        CHECK(Json::Quoted(std::string("\x01\x1f\0", 3)) == "\"\\u0001\\u001f\\u0000\"");
+        CHECK(Json::Quoted("\xc5\x82") == "\"\xc5\x82\"");     // (UTF-8 passed through)
+
+        // Job titles are emitted through it:
+        MemoryLog log;
+        log.Add(0, MemoryLog::Entry{ "TAB\tTITLE", MemoryUsage{}, 0 });
+        std::ostringstream json;
+        log.PrintJSON(json);
+        CHECK(json.str().find("\"title\": \"TAB\\tTITLE\"") != std::string::npos);
+        CHECK(json.str().find('\t') == std::string::npos);
+    }
+
+    TEST_CASE( "check phase timers" , "[CALINE3][phases]")
+    {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+
+        PhaseLog::Global().Clear();
+        PhaseLog::Enable(true);
+
+        std::istringstream is{ test_data };
+        JobReader job_reader{ "INTERNAL DATA", is };
+        auto job = job_reader.Next();
+        REQUIRE(job.has_value());
+
+        ThreadPool pool{ 2 };
+        const Engine engine{ &pool };
+        ConcentrationMatrix MC;
+        std::ostringstream os;
+        Report report{ os };
+        for (auto const& meteo : job->Meteos)
+        {
+            engine.Compute(*job, meteo, MC);
+            report.Print(*job, meteo, MC);
+        }
+        Timing::Flush(job->ORDINAL, job->JOB);
+        PhaseLog::Enable(false);
+
+        const PhaseTimes total = PhaseLog::Global().Total();
+        CHECK(total.Seconds[static_cast<std::size_t>(Phase::Parse)] > 0.0);
+        CHECK(total.Seconds[static_cast<std::size_t>(Phase::PlumeSetup)] > 0.0);
+        CHECK(total.Seconds[static_cast<std::size_t>(Phase::Elements)] > 0.0);
+        CHECK(total.Seconds[static_cast<std::size_t>(Phase::Report)] > 0.0);
+        CHECK(PhaseLog::Global().Jobs().size() == 1);
+
+        // Waiting overlaps the work waited for; it is not CPU time:
+        PhaseTimes waited;
+        waited.Seconds[static_cast<std::size_t>(Phase::Elements)] = 2.0;
+        waited.Seconds[static_cast<std::size_t>(Phase::Wait)] = 1.5;
+        CHECK(waited.Total() == 2.0);
+
+        std::ostringstream json;
+        PhaseLog::Global().PrintJSON(json);
+        CHECK(json.str().find("\"plume_setup\": ") != std::string::npos);
+        CHECK(json.str().find("\"title\": \"EXAMPLE FOUR\"") != std::string::npos);
+
+        std::ostringstream table;
+        PhaseLog::Global().PrintTable(table);
+        CHECK(table.str().find("SHARE [%]") != std::string::npos);
+
+        // Off: nothing recorded.
+        PhaseLog::Global().Clear();
+        engine.Compute(*job, job->Meteos.front(), MC);
+        Timing::Flush(job->ORDINAL, job->JOB);
+        CHECK(PhaseLog::Global().Jobs().empty());
+    }
+
+    TEST_CASE( "check trace recorder" , "[CALINE3][trace]")
+    {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+
+        TraceRecorder& recorder = TraceRecorder::Global();
+        recorder.Reset();
+        TraceRecorder::Enable(true);
+        recorder.NameThread("main \"test\"");
+
+        std::istringstream is{ test_data };
+        JobReader job_reader{ "INTERNAL DATA", is };
+        auto job = job_reader.Next();
+        REQUIRE(job.has_value());
+
+        ThreadPool pool{ 2 };
+        const Engine engine{ &pool };
+        ConcentrationMatrix MC;
+        std::ostringstream os;
+        Report report{ os };
+        for (auto const& meteo : job->Meteos)
+        {
+            engine.Compute(*job, meteo, MC);
+            report.Print(*job, meteo, MC);
+        }
+        TraceRecorder::Enable(false);
+
+        // Spans per category (a plume per meteo and link, a task per worker and meteo):
+        std::map<std::string, std::size_t> spans;
+        for (auto const& event : recorder.Events())
+        {
+            spans[event.Category]++;
+            CHECK(event.Duration >= 0);
+        }
+        CHECK(spans["reader"] == 1);
+        CHECK(spans["plume"] == 4 * 6);
+        CHECK(spans["compute"] == 4 * (1 + 2 + 1));     // compute, tasks, wait
+        CHECK(spans["writer"] == 4);
+        CHECK(recorder.Dropped() == 0);
+
+        std::ostringstream json;
+        recorder.WriteJSON(json);
+        CHECK(json.str().find("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"main \\\"test\\\"\"}}") != std::string::npos);
+        CHECK(json.str().find("\"cat\": \"plume\", \"ph\": \"X\"") != std::string::npos);
+        CHECK(json.str().find("\"args\": {\"job\": 1, \"meteo\": 4, \"link\": 6}}") != std::string::npos);
+
+        // Full rings keep the latest spans:
+        recorder.Reset(4);
+        TraceRecorder::Enable(true);
+        for (std::size_t i = 0; i < 10; i++)
+        {
+            TraceSpan span{ "span", "test", i };
+        }
+        TraceRecorder::Enable(false);
+        auto events = recorder.Events();
+        REQUIRE(events.size() == 4);
+        CHECK(events.front().Job == 6);
+        CHECK(events.back().Job == 9);
+        CHECK(recorder.Dropped() == 6);
+
+        // Off: nothing recorded.
+        recorder.Reset();
+        engine.Compute(*job, job->Meteos.front(), MC);
+        CHECK(recorder.Events().empty());
+    }
+
+    TEST_CASE( "check hardware counters" , "[CALINE3][perf]")
+    {
+        StageCounts counts;
+        counts[Stage::Compute].Count[HardwareCounts::Cycles] = 1000.0;
+        counts[Stage::Compute].Count[HardwareCounts::Instructions] = 2500.0;
+        counts[Stage::Compute].Count[HardwareCounts::Branches] = 400.0;
+        counts[Stage::Compute].Count[HardwareCounts::BranchMisses] = 10.0;
+        CHECK(counts[Stage::Compute].IPC() == 2.5);
+        CHECK(counts[Stage::Compute].BranchMissRate() == 0.025);
+        CHECK(std::isnan(counts[Stage::Compute].CacheMissRate()));     // (not counted)
+        CHECK((counts - counts)[Stage::Compute].Count[HardwareCounts::Cycles] == 0.0);
+
+        std::ostringstream rates;
+        PerfCounters::PrintRates(rates, counts);
+        CHECK(rates.str() ==
+            "parse IPC n/a, cache miss n/a, branch miss n/a"
+            " :: compute IPC 2.50, cache miss n/a, branch miss 2.50%"
+            " :: report IPC n/a, cache miss n/a, branch miss n/a");
+
+        // Counting where the machine lets us (not in most containers and VMs), nothing otherwise:
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        PerfCounters::Reset();
+        const bool counting = PerfCounters::Enable();
+        INFO("status: " << PerfCounters::Status());
+
+        std::istringstream is{ test_data };
+        JobReader job_reader{ "INTERNAL DATA", is };
+        auto job = job_reader.Next();
+        REQUIRE(job.has_value());
+        ConcentrationMatrix MC;
+        for (auto const& meteo : job->Meteos)
+        {
+            Engine{}.Compute(*job, meteo, MC);
+        }
+        PerfCounters::Disable();
+
+        const StageCounts total = PerfCounters::Total();
+        if (counting)
+        {
+            CHECK(total[Stage::Parse].Count[HardwareCounts::Instructions] > 0.0);
+            CHECK(total[Stage::Compute].Count[HardwareCounts::Instructions] > 0.0);
+            CHECK(total[Stage::Compute].IPC() > 0.0);
+        }
+        else
+        {
+            CHECK(!PerfCounters::Status().empty());
+            CHECK(total[Stage::Compute].Count[HardwareCounts::Cycles] == 0.0);
+        }
+        PerfCounters::Reset();
+    }
+
+    TEST_CASE( "check memory accounting" , "[CALINE3][memory]")
+    {
+        const MemoryUsage before = Memory::Run();
+        const std::size_t matrices = static_cast<std::size_t>(Subsystem::Matrices);
+        {
+            TrackedVector<double, Subsystem::Matrices> v(1000);
+            Memory::BeginWindow();
+            {
+                TrackedVector<double, Subsystem::Matrices> w(500);
+                CHECK(Memory::Run().Current[matrices] == before.Current[matrices] + 1500 * sizeof(double));
+            }
+            const MemoryUsage window = Memory::Window();
+            CHECK(window.Current[matrices] == before.Current[matrices] + 1000 * sizeof(double));
+            CHECK(window.Peak[matrices] == before.Current[matrices] + 1500 * sizeof(double));
+            CHECK(window.Peak[SUBSYSTEMS] >= window.Peak[matrices]);
+        }
+        CHECK(Memory::Run().Current[matrices] == before.Current[matrices]);
+
+        // Job collections and report pages are accounted for as well:
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        std::istringstream is{ test_data };
+        JobReader job_reader{ "INTERNAL DATA", is };
+        auto job = job_reader.Next();
+        REQUIRE(job.has_value());
+        CHECK(Memory::Run().Current[static_cast<std::size_t>(Subsystem::Jobs)] >= job->Links.size() * sizeof(Link) + job->Receptors.size() * sizeof(Receptor));
+        std::ostringstream os;
+        Report report{ os };
+        ConcentrationMatrix MC;
+        Engine{}.Compute(*job, job->Meteos.front(), MC);
+        report.Print(*job, job->Meteos.front(), MC);
+        CHECK(Memory::Run().Current[static_cast<std::size_t>(Subsystem::Report)] >= os.str().size() / 2);
+
+        // Budget:
+        CHECK(Memory::Budget() == 0);
+        CHECK(Memory::Fits(SIZE_MAX));
+        Memory::SetBudget(Memory::Run().Current[SUBSYSTEMS] + 100);
+        CHECK(Memory::Fits(100));
+        CHECK(!Memory::Fits(101));
+        CHECK(Memory::Available() == 100);
+        Memory::SetBudget(0);
+        CHECK(Memory::Available() == SIZE_MAX);
+
+        CHECK(Memory::ParseBytes("4096") == 4096);
+        CHECK(Memory::ParseBytes("512K") == 512 * 1024);
+        CHECK(Memory::ParseBytes("2g") == std::size_t(2) << 30);
+        CHECK_THROWS_AS(Memory::ParseBytes("12MB"), std::invalid_argument);
+        CHECK_THROWS_AS(Memory::ParseBytes("-1"), std::invalid_argument);
+        CHECK_THROWS_AS(Memory::ParseBytes("M"), std::invalid_argument);
+
+        // Job log:
+        MemoryLog log;
+        log.Add(0, MemoryLog::Entry{ "EXAMPLE \"M\"", Memory::Run(), 5 });
+        std::ostringstream json;
+        log.PrintJSON(json);
+        CHECK(json.str().find("{ \"job\": 1, \"title\": \"EXAMPLE \\\"M\\\"\", \"tile\": 5, \"current\": { \"jobs\": ") != std::string::npos);
+        std::ostringstream table;
+        log.PrintTable(table);
+        CHECK(table.str().find("1 EXAMPLE \"M\"") != std::string::npos);
+    }
 }
@@ -0,0 +1,163 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <string>
+#include <vector>
+
+#include "../CALINE3/CApi.h"
+
+// Expected EXAMPLE FOUR results (see CALINE3.cpp)
+extern double test_result[4][6][12];
+
+TEST_CASE( "check CALINE3 C API" , "[CALINE3][capi]")
+{
+    // EXAMPLE FOUR (as in CALINE3.EXP):
+    const caline3_receptor receptors[] = {
+        { "RECP. 1", -350.0, 30.0, 1.8 },
+        { "RECP. 2", 0.0, 30.0, 1.8 },
+        { "RECP. 3", 750.0, 100.0, 1.8 },
+        { "RECP. 4", 850.0, 30.0, 1.8 },
+        { "RECP. 5", -850.0, -100.0, 1.8 },
+        { "RECP. 6", -550.0, -100.0, 1.8 },
+        { "RECP. 7", -350.0, -100.0, 1.8 },
+        { "RECP. 8", 50.0, -100.0, 1.8 },
+        { "RECP. 9", 450.0, -100.0, 1.8 },
+        { "RECP. 10", 800.0, -100.0, 1.8 },
+        { "RECP. 11", -550.0, 25.0, 1.8 },
+        { "RECP. 12", -550.0, 25.0, 6.1 }
+    };
+    const caline3_link links[] = {
+        { "LINK A", "AG", 500.0, 0.0, 3000.0, 0.0, 9700.0, 30.0, 0.0, 23.0 },
+        { "LINK B", "DP", 500.0, 0.0, 1000.0, 100.0, 1200.0, 150.0, -2.0, 13.0 },
+        { "LINK C", "AG", -3000.0, 0.0, 500.0, 0.0, 10900.0, 30.0, 0.0, 23.0 },
+        { "LINK D", "AG", -3000.0, -75.0, 3000.0, -75.0, 9300.0, 30.0, 0.0, 23.0 },
+        { "LINK E", "BR", -500.0, 200.0, -500.0, -300.0, 4000.0, 50.0, 6.1, 27.0 },
+        { "LINK F", "BR", -100.0, 200.0, -100.0, -200.0, 5000.0, 50.0, 6.1, 27.0 }
+    };
+    const caline3_meteo meteos[] = {
+        { 1.0, 0.0, 6, 1000.0, 12.0 },
+        { 1.0, 90.0, 6, 1000.0, 7.0 },
+        { 1.0, 180.0, 6, 1000.0, 5.0 },
+        { 1.0, 270.0, 6, 1000.0, 6.7 }
+    };
+
+    caline3_session *session = caline3_session_create(GENERATE(1u, 3u));
+    REQUIRE(session != nullptr);
+
+    CHECK(caline3_add_links(session, links, 6) == CALINE3_INVALID_STATE);
+    CHECK(std::string(caline3_last_error(session)) == "no site created.");
+
+    REQUIRE(caline3_site_create(session, "EXAMPLE FOUR", 60.0, 100.0, 0.0, 0.0) == CALINE3_OK);
+    REQUIRE(caline3_add_receptors(session, receptors, 12) == CALINE3_OK);
+    REQUIRE(caline3_add_links(session, links, 2) == CALINE3_OK);
+    REQUIRE(caline3_add_links(session, links + 2, 4) == CALINE3_OK);
+    REQUIRE(caline3_add_meteos(session, meteos, 4) == CALINE3_OK);
+
+    size_t NL = 0, NR = 0, NM = 0;
+    REQUIRE(caline3_get_dims(session, &NL, &NR, &NM) == CALINE3_OK);
+    CHECK(NL == 6);
+    CHECK(NR == 12);
+    CHECK(NM == 4);
+
+    std::vector<double> mc(NL * NR);
+    CHECK(caline3_get_matrix(session, 0, mc.data(), mc.size()) == CALINE3_INVALID_STATE);
+
+    REQUIRE(caline3_evaluate(session) == CALINE3_OK);
+    CHECK(caline3_get_matrix(session, 0, mc.data(), mc.size() - 1) == CALINE3_BUFFER_TOO_SMALL);
+
+    for (size_t M = 0; M < NM; M++)
+    {
+        REQUIRE(caline3_get_matrix(session, M, mc.data(), mc.size()) == CALINE3_OK);
+        for (size_t L = 0; L < NL; L++)
+        {
+            for (size_t R = 0; R < NR; R++)
+            {
+                CHECK_THAT(mc[L * NR + R], Catch::Matchers::WithinRel(test_result[M][L][R], 1.0e-15));
+            }
+        }
+    }
+
+    // Invalid input is rejected as a whole:
+    caline3_link invalid = links[0];
+    invalid.type = "XX";
+    const caline3_link mixed[] = { links[0], invalid };
+    CHECK(caline3_add_links(session, mixed, 2) == CALINE3_INVALID_ARGUMENT);
+    invalid.type = "AG";
+    invalid.wl = 5000.0;
+    CHECK(caline3_add_links(session, &invalid, 1) == CALINE3_INVALID_ARGUMENT);
+    caline3_meteo unstable = meteos[0];
+    unstable.clas = 7;
+    CHECK(caline3_add_meteos(session, &unstable, 1) == CALINE3_INVALID_ARGUMENT);
+    REQUIRE(caline3_get_dims(session, &NL, &NR, &NM) == CALINE3_OK);
+    CHECK(NL == 6);
+    CHECK(NM == 4);
+
+    // Another hour, same layout:
+    REQUIRE(caline3_clear_meteos(session) == CALINE3_OK);
+    REQUIRE(caline3_add_meteos(session, meteos + 3, 1) == CALINE3_OK);
+    REQUIRE(caline3_evaluate(session) == CALINE3_OK);
+    REQUIRE(caline3_get_matrix(session, 0, mc.data(), mc.size()) == CALINE3_OK);
+    CHECK_THAT(mc[3 * NR + 4], Catch::Matchers::WithinRel(test_result[3][3][4], 1.0e-15));
+    CHECK(caline3_get_matrix(session, 1, mc.data(), mc.size()) == CALINE3_INVALID_ARGUMENT);
+
+    caline3_session_destroy(session);
+}
+
+TEST_CASE( "check CALINE3 C API columns" , "[CALINE3][capi]")
+{
+    // EXAMPLE FOUR (as above) in columns:
+    const double xr[] = { -350.0, 0.0, 750.0, 850.0, -850.0, -550.0, -350.0, 50.0, 450.0, 800.0, -550.0, -550.0 };
+    const double yr[] = { 30.0, 30.0, 100.0, 30.0, -100.0, -100.0, -100.0, -100.0, -100.0, -100.0, 25.0, 25.0 };
+    const double zr[] = { 1.8, 1.8, 1.8, 1.8, 1.8, 1.8, 1.8, 1.8, 1.8, 1.8, 1.8, 6.1 };
+    const double xl1[] = { 500.0, 500.0, -3000.0, -3000.0, -500.0, -100.0 };
+    const double yl1[] = { 0.0, 0.0, 0.0, -75.0, 200.0, 200.0 };
+    const double xl2[] = { 3000.0, 1000.0, 500.0, 3000.0, -500.0, -100.0 };
+    const double yl2[] = { 0.0, 100.0, 0.0, -75.0, -300.0, -200.0 };
+    const double vphl[] = { 9700.0, 1200.0, 10900.0, 9300.0, 4000.0, 5000.0 };
+    const double efl[] = { 30.0, 150.0, 30.0, 30.0, 50.0, 50.0 };
+    const double hl[] = { 0.0, -2.0, 0.0, 0.0, 6.1, 6.1 };
+    const double wl[] = { 23.0, 13.0, 23.0, 23.0, 27.0, 27.0 };
+    unsigned char type[] = { CALINE3_AG, CALINE3_DP, CALINE3_AG, CALINE3_AG, CALINE3_BR, CALINE3_BR };
+    const caline3_meteo meteos[] = {
+        { 1.0, 0.0, 6, 1000.0, 12.0 },
+        { 1.0, 90.0, 6, 1000.0, 7.0 },
+        { 1.0, 180.0, 6, 1000.0, 5.0 },
+        { 1.0, 270.0, 6, 1000.0, 6.7 }
+    };
+
+    const caline3_receptor_columns receptors = { xr, yr, zr, 12 };
+    const caline3_link_columns links = { xl1, yl1, xl2, yl2, vphl, efl, hl, wl, type, 6 };
+    const size_t NL = 6, NR = 12;
+
+    caline3_session *session = caline3_session_create(GENERATE(1u, 3u));
+    REQUIRE(session != nullptr);
+
+    std::vector<double> mc(NL * NR);
+    CHECK(caline3_evaluate_columns(session, &receptors, &links, meteos, mc.data(), mc.size()) == CALINE3_INVALID_STATE);
+
+    REQUIRE(caline3_site_create(session, "EXAMPLE FOUR", 60.0, 100.0, 0.0, 0.0) == CALINE3_OK);
+    CHECK(caline3_evaluate_columns(session, &receptors, &links, meteos, mc.data(), mc.size() - 1) == CALINE3_BUFFER_TOO_SMALL);
+
+    for (size_t M = 0; M < 4; M++)
+    {
+        REQUIRE(caline3_evaluate_columns(session, &receptors, &links, meteos + M, mc.data(), mc.size()) == CALINE3_OK);
+        for (size_t L = 0; L < NL; L++)
+        {
+            for (size_t R = 0; R < NR; R++)
+            {
+                CHECK_THAT(mc[L * NR + R], Catch::Matchers::WithinRel(test_result[M][L][R], 1.0e-15));
+            }
+        }
+    }
+
+    // Session contents are not affected:
+    size_t nl = 1, nr = 1, nm = 1;
+    REQUIRE(caline3_get_dims(session, &nl, &nr, &nm) == CALINE3_OK);
+    CHECK((nl + nr + nm) == 0);
+
+    type[1] = 4;
+    CHECK(caline3_evaluate_columns(session, &receptors, &links, meteos, mc.data(), mc.size()) == CALINE3_INVALID_ARGUMENT);
+
+    caline3_session_destroy(session);
+}
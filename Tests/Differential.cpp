@@ -0,0 +1,390 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../CALINE3/Engine.h"
+#include "../CALINE3/JobReader.h"
+#include "../CALINE3/Plume.h"
+#include "../CALINE3/Workload.h"
+
+#ifndef CALINE3_DIFF_REPRO_DIR
+#define CALINE3_DIFF_REPRO_DIR "."
+#endif
+
+/*
+ * Differential testing: randomized synthetic jobs are run through the reference path (a Plume per
+ * meteo and link, evaluated receptor by receptor, as in the original CALINE3) and through every
+ * accelerated execution mode; each mode is to agree with the reference within its declared tolerance
+ * (|C - reference| <= Abs + Rel * |reference| for every link-receptor pair). A failing job is minimized
+ * (meteos, links and receptors dropped while the mode still fails) and written as an EXP reproducer.
+ * Configured with environment variables:
+ *
+ *   CALINE3_DIFF_SEED      - seed of the job series (default 1),
+ *   CALINE3_DIFF_JOBS      - number of jobs (default 64),
+ *   CALINE3_DIFF_REPRO     - directory the reproducers are written to (default: the test build directory).
+ */
+
+namespace
+{
+    using namespace CALINE3;
+
+    /// @brief Computes the concentration matrix of a job for a meteo.
+    using Compute = std::function<void(const Job& job, const Meteo& meteo, ConcentrationMatrix& MC)>;
+
+    struct Mode
+    {
+        const char *Name;
+        double Abs;             /// Tolerated absolute deviation [ug/m3].
+        double Rel;             /// Tolerated relative deviation.
+        Compute Run;
+    };
+
+    std::string Env(const char *name, const char *fallback)
+    {
+        const char *value = std::getenv(name);
+        return (value && *value) ? value : fallback;
+    }
+
+    /**
+     * @brief Reference: a Plume per meteo and link, receptor by receptor.
+     */
+    void Reference(const Job& job, const Meteo& meteo, ConcentrationMatrix& MC)
+    {
+        MC.resize(job.Links.size());
+        for (auto const& link : job.Links)
+        {
+            Plume plume{ job, meteo, link };
+            auto& row = MC[link.ORDINAL];
+            row.resize(job.Receptors.size());
+            for (auto const& receptor : job.Receptors)
+            {
+                row[receptor.ORDINAL] = plume.ConcentrationAt(receptor);
+            }
+        }
+    }
+
+    Compute Computing(std::shared_ptr<const Engine> engine)
+    {
+        return [engine](const Job& job, const Meteo& meteo, ConcentrationMatrix& MC) { engine->Compute(job, meteo, MC); };
+    }
+
+    Compute Streaming(std::shared_ptr<const Engine> engine, std::size_t block)
+    {
+        return [engine, block](const Job& job, const Meteo& meteo, ConcentrationMatrix& MC) {
+            MC.assign(job.Links.size(), {});
+            for (auto& row : MC) row.resize(job.Receptors.size());
+            ConcentrationMatrix tile;
+            engine->Stream(job, meteo, block, tile, [&MC](const ConcentrationMatrix& tile, std::size_t rfirst, std::size_t rlast) {
+                for (std::size_t l = 0; l < MC.size(); l++)
+                {
+                    std::copy(tile[l].begin(), tile[l].begin() + (rlast - rfirst), MC[l].begin() + rfirst);
+                }
+            });
+        };
+    }
+
+    Compute Columnar(std::shared_ptr<const Engine> engine)
+    {
+        return [engine](const Job& job, const Meteo& meteo, ConcentrationMatrix& MC) {
+            std::vector<double> xr, yr, zr;
+            for (auto const& r : job.Receptors)
+            {
+                xr.push_back(r.XR.value()); yr.push_back(r.YR.value()); zr.push_back(r.ZR.value());
+            }
+            std::vector<double> xl1, yl1, xl2, yl2, vphl, efl, hl, wl;
+            std::vector<std::uint8_t> typ;
+            for (auto const& l : job.Links)
+            {
+                xl1.push_back(l.XL1.value()); yl1.push_back(l.YL1.value());
+                xl2.push_back(l.XL2.value()); yl2.push_back(l.YL2.value());
+                vphl.push_back(l.VPHL.value()); efl.push_back(l.EFL.value());
+                hl.push_back(l.HL.value()); wl.push_back(l.WL.value());
+                typ.push_back(static_cast<std::uint8_t>(std::find_if(std::begin(Link::TYPE_NAME), std::end(Link::TYPE_NAME),
+                    [&l](const char *name) { return l.TYP == name; }) - std::begin(Link::TYPE_NAME)));
+            }
+            const ReceptorColumns receptors{ xr.data(), yr.data(), zr.data(), xr.size() };
+            const LinkColumns links{ xl1.data(), yl1.data(), xl2.data(), yl2.data(), vphl.data(), efl.data(), hl.data(), wl.data(), typ.data(), typ.size() };
+
+            std::vector<double> mc(links.NL * receptors.NR);
+            engine->Compute(job, meteo, receptors, links, mc.data());
+            MC.assign(links.NL, {});
+            for (std::size_t l = 0; l < links.NL; l++)
+            {
+                MC[l].resize(receptors.NR);
+                for (std::size_t r = 0; r < receptors.NR; r++)
+                {
+                    MC[l][r] = Microgram_Meter3(mc[l * receptors.NR + r]);
+                }
+            }
+        };
+    }
+
+    std::shared_ptr<const Engine> MakeEngine(ThreadPool *pool, Partition partition, std::size_t block, ErfVariant erf, Summation sum = Summation::Sequential, bool shared = false)
+    {
+        MathPolicy policy;
+        policy.Erf = erf;
+        policy.Sum = sum;
+        policy.SharedDispersion = shared;
+        return std::make_shared<const Engine>(pool, partition, block, policy);
+    }
+
+    /**
+     * @brief Execution modes under test (with their tolerances).
+     */
+    std::vector<Mode> Modes(ThreadPool *pool)
+    {
+        constexpr ErfVariant AS = ErfVariant::AbramowitzStegun;
+        return {
+            { "serial",      0.0,   0.0,   Computing(MakeEngine(nullptr, Partition::Links, 0, AS)) },
+            { "threads",     0.0,   0.0,   Computing(MakeEngine(pool, Partition::Links, 0, AS)) },
+            { "blocks",      0.0,   0.0,   Computing(MakeEngine(pool, Partition::ReceptorBlocks, 3, AS)) },
+            { "columns",     0.0,   0.0,   Columnar(MakeEngine(pool, Partition::Links, 0, AS)) },
+            { "stream",      0.0,   0.0,   Streaming(MakeEngine(pool, Partition::Links, 0, AS), 4) },
+            { "vector",      0.0,   0.0,   Computing(MakeEngine(nullptr, Partition::Links, 0, ErfVariant::Vector)) },
+            { "pairwise",    1e-12, 1e-12, Computing(MakeEngine(nullptr, Partition::Links, 0, AS, Summation::Pairwise)) },
+            { "compensated", 1e-12, 1e-12, Computing(MakeEngine(nullptr, Partition::Links, 0, AS, Summation::Compensated)) },
+            { "shared",      1e-12, 1e-12, Computing(MakeEngine(pool, Partition::ReceptorBlocks, 3, AS, Summation::Sequential, true)) },
+            { "std",         1e-3,  1e-3,  Computing(MakeEngine(nullptr, Partition::Links, 0, ErfVariant::Std)) },
+            { "fast",        1e-2,  1e-2,  Computing(MakeEngine(nullptr, Partition::Links, 0, ErfVariant::Fast)) },
+        };
+    }
+
+    /**
+     * @brief Largest deviations of a mode from the reference.
+     */
+    struct Deviation
+    {
+        double Abs = 0.0;           /// Largest absolute deviation [ug/m3].
+        double Rel = 0.0;           /// Largest relative deviation (over non-zero reference values).
+        std::size_t Pairs = 0;      /// Link-receptor pairs compared.
+        std::size_t Failures = 0;   /// Pairs out of the tolerance.
+
+        void Add(const Deviation& other)
+        {
+            Abs = std::max(Abs, other.Abs);
+            Rel = std::max(Rel, other.Rel);
+            Pairs += other.Pairs;
+            Failures += other.Failures;
+        }
+    };
+
+    /**
+     * @brief Runs a job through a mode and the reference.
+     */
+    Deviation Compare(const Mode& mode, const Job& job)
+    {
+        Deviation deviation;
+        ConcentrationMatrix expected, actual;
+        for (auto const& meteo : job.Meteos)
+        {
+            Reference(job, meteo, expected);
+            mode.Run(job, meteo, actual);
+            REQUIRE(actual.size() == expected.size());
+            for (std::size_t l = 0; l < expected.size(); l++)
+            {
+                REQUIRE(actual[l].size() == expected[l].size());
+                for (std::size_t r = 0; r < expected[l].size(); r++)
+                {
+                    const double c = expected[l][r].value();
+                    const double a = std::abs(actual[l][r].value() - c);
+                    deviation.Abs = std::max(deviation.Abs, a);
+                    if (c != 0.0)
+                        deviation.Rel = std::max(deviation.Rel, a / std::abs(c));
+                    if (!(a <= mode.Abs + mode.Rel * std::abs(c)))     // (NaN fails)
+                        deviation.Failures++;
+                    deviation.Pairs++;
+                }
+            }
+        }
+        return deviation;
+    }
+
+    /**
+     * @brief Job made of the selected meteos, links and receptors of another job (renumbered).
+     */
+    Job Subset(const Job& job, const std::vector<std::size_t>& meteos, const std::vector<std::size_t>& links, const std::vector<std::size_t>& receptors)
+    {
+        Job subset{ job.ORDINAL, job.JOB, job.ATIM, job.Z0, job.VS1, job.VD1, receptors.size(), job.SCAL };
+        subset.setRUN(job.RUN);
+        for (std::size_t i : links)
+        {
+            const Link& l = job.Links[i];
+            subset.Links.emplace_back(subset.Links.size(), l.LNK, l.TYP, l.XL1, l.YL1, l.XL2, l.YL2, l.VPHL, l.EFL, l.HL, l.WL);
+        }
+        for (std::size_t i : receptors)
+        {
+            const Receptor& r = job.Receptors[i];
+            subset.Receptors.emplace_back(subset.Receptors.size(), r.RCP, r.XR, r.YR, r.ZR);
+        }
+        for (std::size_t i : meteos)
+        {
+            const Meteo& m = job.Meteos[i];
+            subset.Meteos.emplace_back(subset.Meteos.size(), m.U, m.BRG1, m.CLAS, m.MIXH, m.AMB);
+        }
+        return subset;
+    }
+
+    std::vector<std::size_t> Indices(std::size_t n)
+    {
+        std::vector<std::size_t> indices(n);
+        for (std::size_t i = 0; i < n; i++) indices[i] = i;
+        return indices;
+    }
+
+    /**
+     * @brief Smallest job (of the meteos, links and receptors of a failing one) the mode still fails:
+     * chunks of each collection (halves, quarters, ... single items) are dropped while the failure persists.
+     */
+    Job Minimize(const Mode& mode, const Job& job)
+    {
+        std::vector<std::size_t> sets[3] = { Indices(job.Meteos.size()), Indices(job.Links.size()), Indices(job.Receptors.size()) };
+        auto fails = [&]() { return Compare(mode, Subset(job, sets[0], sets[1], sets[2])).Failures > 0; };
+
+        for (bool reduced = true; reduced; )
+        {
+            reduced = false;
+            for (auto& set : sets)
+            {
+                for (std::size_t chunk = set.size() / 2; chunk > 0; chunk /= 2)
+                {
+                    for (std::size_t first = 0; (first < set.size()) && (set.size() > 1); )
+                    {
+                        std::vector<std::size_t> kept = set;
+                        kept.erase(kept.begin() + first, kept.begin() + std::min(first + chunk, kept.size()));
+                        std::swap(set, kept);
+                        if (!set.empty() && fails())
+                        {
+                            reduced = true;     // (retry the chunk at the same position)
+                        }
+                        else
+                        {
+                            std::swap(set, kept);
+                            first += chunk;
+                        }
+                    }
+                }
+            }
+        }
+        return Subset(job, sets[0], sets[1], sets[2]);
+    }
+
+    /**
+     * @brief Synthetic job spec drawn at random (any layout, link types, stabilities, mixing heights and velocities).
+     */
+    WorkloadSpec RandomSpec(std::mt19937_64& random)
+    {
+        auto draw = [&random](std::size_t n) { return static_cast<std::size_t>(random() % n); };
+
+        WorkloadSpec spec;
+        spec.Links = 1 + draw(12);
+        spec.Receptors = 1 + draw(20);
+        spec.Meteos = 1 + draw(3);
+        spec.Levels = 1 + draw(4);
+        spec.Lanes = draw(2) ? 1 : 2 + draw(2);
+        spec.Geometry = static_cast<Layout>(draw(3));
+        spec.Types = { "AG", "BR", "FL", "DP" };
+        spec.MixingHeights = { 50.0, 300.0, 1000.0, 5000.0 };
+        spec.VD = static_cast<double>(draw(3));
+        spec.VS = draw(2) ? spec.VD : 0.0;
+        spec.Seed = random();
+        return spec;
+    }
+
+    /**
+     * @brief Writes the reproducer of a failing job; returns its path.
+     */
+    std::string WriteReproducer(const Mode& mode, const Job& job)
+    {
+        std::string path = Env("CALINE3_DIFF_REPRO", CALINE3_DIFF_REPRO_DIR) + "/differential-" + mode.Name + ".exp";
+        std::ofstream os{ path };
+        Workload::WriteEXP(os, job);
+        return path;
+    }
+}
+
+TEST_CASE( "check differential execution modes" , "[CALINE3][differential]")
+{
+    const std::uint64_t seed = std::stoull(Env("CALINE3_DIFF_SEED", "1"));
+    const std::size_t jobs = std::stoul(Env("CALINE3_DIFF_JOBS", "64"));
+
+    ThreadPool pool{ 3 };
+    const std::vector<Mode> modes = Modes(&pool);
+    std::vector<Deviation> deviations(modes.size());
+
+    std::mt19937_64 random{ seed };
+    for (std::size_t j = 0; j < jobs; j++)
+    {
+        const Job job = Workload{ RandomSpec(random) }.Generate(j);
+        for (std::size_t m = 0; m < modes.size(); m++)
+        {
+            const Deviation deviation = Compare(modes[m], job);
+            if ((deviation.Failures > 0) && (deviations[m].Failures == 0))
+            {
+                // Reproducer of the first failing job of the mode:
+                const Job minimal = Minimize(modes[m], job);
+                std::ostringstream exp;
+                Workload::WriteEXP(exp, minimal);
+                FAIL_CHECK("mode " << modes[m].Name << " out of tolerance (seed " << seed << ", job " << j + 1
+                    << "); reproducer written to " << WriteReproducer(modes[m], minimal) << ":\n" << exp.str());
+            }
+            deviations[m].Add(deviation);
+        }
+    }
+
+    std::cout << std::endl << std::left << std::setw(14) << "mode" << std::right
+        << std::setw(10) << "pairs" << std::setw(14) << "max abs" << std::setw(14) << "max rel"
+        << std::setw(12) << "tol abs" << std::setw(12) << "tol rel" << std::setw(10) << "failures" << std::endl;
+    for (std::size_t m = 0; m < modes.size(); m++)
+    {
+        std::cout << std::left << std::setw(14) << modes[m].Name << std::right << std::setw(10) << deviations[m].Pairs
+            << std::scientific << std::setprecision(3)
+            << std::setw(14) << deviations[m].Abs << std::setw(14) << deviations[m].Rel
+            << std::setprecision(0) << std::setw(12) << modes[m].Abs << std::setw(12) << modes[m].Rel
+            << std::defaultfloat << std::setw(10) << deviations[m].Failures << std::endl;
+    }
+}
+
+TEST_CASE( "check differential reproducer" , "[CALINE3][differential]")
+{
+    WorkloadSpec spec;
+    spec.Links = 6;
+    spec.Receptors = 9;
+    spec.Meteos = 3;
+    spec.Types = { "AG", "FL", "DP" };
+    spec.Seed = 5;
+    const Job job = Workload{ spec }.Generate();
+
+    // The fast Erf held to the exact results fails on (nearly) any pair, so a single one is enough:
+    const Mode strict{ "strict", 0.0, 0.0, Computing(MakeEngine(nullptr, Partition::Links, 0, ErfVariant::Fast)) };
+    REQUIRE(Compare(strict, job).Failures > 0);
+
+    const Job minimal = Minimize(strict, job);
+    CHECK(minimal.Meteos.size() == 1);
+    CHECK(minimal.Links.size() == 1);
+    CHECK(minimal.Receptors.size() == 1);
+    CHECK(minimal.NR == 1);
+
+    // The reproducer reads back as the same job and still fails:
+    std::ostringstream exp;
+    Workload::WriteEXP(exp, minimal);
+    std::istringstream is{ exp.str() };
+    JobReader rdr{ "reproducer.exp", is };
+    auto repro = rdr.Next();
+    REQUIRE(repro);
+    CHECK(!rdr.ErrorFound());
+    CHECK(repro->Links[0].XL1 == minimal.Links[0].XL1);
+    CHECK(repro->Receptors[0].YR == minimal.Receptors[0].YR);
+    CHECK(Compare(strict, *repro).Failures == 1);
+}
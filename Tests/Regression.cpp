@@ -0,0 +1,279 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <clocale>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CALINE3/Engine.h"
+#include "../CALINE3/JobReader.h"
+#include "../CALINE3/Report.h"
+
+// Expected EXAMPLE FOUR results (see CALINE3.cpp)
+extern double test_result[4][6][12];
+
+/*
+ * Regression gate: the full CALINE3.EXP run through the Engine in each execution mode is checked
+ * against CALINE3.LST (report lines) and the exact EXAMPLE FOUR matrix, and its throughput against
+ * a baseline file. Configured with environment variables (set by ctest, see CMakeLists.txt):
+ *
+ *   CALINE3_EXP, CALINE3_LST          - input data and expected report,
+ *   CALINE3_BASELINE                  - baseline file ("mode pairs/s" lines; stored with the sources, the gate fails without it),
+ *   CALINE3_REGRESSION_THRESHOLD      - tolerated throughput loss (fraction of the baseline, default 0.25),
+ *   CALINE3_BASELINE_UPDATE=1         - rewrite the baseline with the current throughput.
+ *
+ * Threaded modes are not gated on machines with fewer cores than their threads (timings too noisy).
+ */
+
+namespace
+{
+    using namespace CALINE3;
+
+    // Minimum measuring time per mode [s] (the EXP is run over and over until then; best run taken):
+    constexpr double MEASURE_TIME = 0.25;
+
+    // Measurements of a mode that fails the gate (to rule out noise from other processes):
+    constexpr int RETRIES = 2;
+
+    struct Mode
+    {
+        const char *Name;
+        std::size_t Threads;    /// Compute threads (1 = serial).
+        Partition Partitioning;
+        ErfVariant Erf;
+        bool Exact;             /// Results bit for bit as the serial (original) mode?
+    };
+
+    const Mode MODES[] = {
+        { "serial",  1, Partition::Links,          ErfVariant::AbramowitzStegun, true },
+        { "threads", 4, Partition::Links,          ErfVariant::AbramowitzStegun, true },
+        { "blocks",  4, Partition::ReceptorBlocks, ErfVariant::AbramowitzStegun, true },
+        { "vector",  1, Partition::Links,          ErfVariant::Vector,           true },
+        { "fast",    1, Partition::Links,          ErfVariant::Fast,             false },
+    };
+
+    std::string Env(const char *name, const char *fallback)
+    {
+        const char *value = std::getenv(name);
+        return (value && *value) ? value : fallback;
+    }
+
+    /**
+     * @brief Report lines as compared: non-blank, trailing blanks trimmed, computation times dropped.
+     */
+    std::vector<std::string> ReportLines(std::istream& is)
+    {
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(is, line))
+        {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (!line.empty() && (line.find("omputation time") == std::string::npos))
+                lines.push_back(line);
+        }
+        return lines;
+    }
+
+    struct Outcome
+    {
+        std::string Report;             /// Report text.
+        std::vector<Job> Jobs;          /// Jobs read.
+        std::vector<std::vector<ConcentrationMatrix>> MC;   /// Matrices [job][meteo].
+        std::size_t Pairs = 0;          /// Link-receptor pairs per run.
+        double Seconds = 0.0;           /// Compute time [s] (best run).
+    };
+
+    Outcome Run(const Mode& mode, const std::string& input)
+    {
+        std::unique_ptr<ThreadPool> pool;
+        if (mode.Threads > 1)
+            pool = std::make_unique<ThreadPool>(mode.Threads);
+        const Engine engine{ pool.get(), mode.Partitioning, 0, MathPolicy{ mode.Erf } };
+
+        Outcome outcome;
+        {
+            std::istringstream is{ input };
+            JobReader rdr{ "CALINE3.EXP", is };
+            while (auto job = rdr.Next())
+            {
+                outcome.Jobs.push_back(std::move(*job));
+            }
+            REQUIRE(!rdr.ErrorFound());
+        }
+
+        outcome.MC.resize(outcome.Jobs.size());
+        for (std::size_t J = 0; J < outcome.Jobs.size(); J++)
+        {
+            outcome.MC[J].resize(outcome.Jobs[J].Meteos.size());
+            outcome.Pairs += outcome.Jobs[J].Meteos.size() * outcome.Jobs[J].Links.size() * outcome.Jobs[J].Receptors.size();
+        }
+
+        double total = 0.0;
+        for (int run = 0; (run < 3) || (total < MEASURE_TIME); run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (std::size_t J = 0; J < outcome.Jobs.size(); J++)
+            {
+                for (auto const& meteo : outcome.Jobs[J].Meteos)
+                {
+                    engine.Compute(outcome.Jobs[J], meteo, outcome.MC[J][meteo.ORDINAL]);
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            total += seconds;
+            if ((run == 0) || (seconds < outcome.Seconds))
+                outcome.Seconds = seconds;
+        }
+
+        std::ostringstream os;
+        Report report{ os };
+        for (std::size_t J = 0; J < outcome.Jobs.size(); J++)
+        {
+            for (auto const& meteo : outcome.Jobs[J].Meteos)
+            {
+                report.Print(outcome.Jobs[J], meteo, outcome.MC[J][meteo.ORDINAL]);
+            }
+        }
+        outcome.Report = os.str();
+        return outcome;
+    }
+
+    std::map<std::string, double> ReadBaseline(const std::string& path)
+    {
+        std::map<std::string, double> baseline;
+        std::ifstream is{ path };
+        std::string line;
+        while (std::getline(is, line))
+        {
+            std::istringstream fields{ line };
+            std::string mode;
+            double rate;
+            if ((line.rfind('#', 0) != 0) && (fields >> mode >> rate))
+                baseline[mode] = rate;
+        }
+        return baseline;
+    }
+
+    void WriteBaseline(const std::string& path, const std::map<std::string, double>& rates)
+    {
+        std::ofstream os{ path };
+        os << "# CALINE3 regression baseline: mode, link-receptor pairs per second" << std::endl;
+        for (auto const& [mode, rate] : rates)
+        {
+            os << mode << ' ' << std::fixed << std::setprecision(0) << rate << std::endl;
+        }
+    }
+}
+
+TEST_CASE( "check regression gate" , "[.][regression]")
+{
+    std::setlocale(LC_ALL, "en_US.UTF-8");
+
+    const std::string exp_path = Env("CALINE3_EXP", "CALINE3.EXP");
+    const std::string lst_path = Env("CALINE3_LST", "CALINE3.LST");
+    const std::string baseline_path = Env("CALINE3_BASELINE", "CALINE3.baseline");
+    const double threshold = std::stod(Env("CALINE3_REGRESSION_THRESHOLD", "0.25"));
+    const bool update = Env("CALINE3_BASELINE_UPDATE", "0") == "1";
+
+    std::ifstream exp{ exp_path };
+    REQUIRE(exp.is_open());
+    const std::string input{ std::istreambuf_iterator<char>(exp), std::istreambuf_iterator<char>() };
+
+    std::ifstream lst{ lst_path };
+    REQUIRE(lst.is_open());
+    const std::vector<std::string> expected = ReportLines(lst);
+
+    std::map<std::string, double> baseline = ReadBaseline(baseline_path);
+    std::map<std::string, double> rates;
+    if (baseline.empty() && !update)
+        FAIL("no baseline in " << baseline_path << " (record one with CALINE3_BASELINE_UPDATE=1)");
+
+    std::cout << std::endl << std::left << std::setw(10) << "mode" << std::right
+        << std::setw(16) << "pairs/s" << std::setw(16) << "baseline" << std::setw(10) << "ratio" << std::endl;
+
+    for (auto const& mode : MODES)
+    {
+        const Outcome outcome = Run(mode, input);
+        INFO("mode: " << mode.Name);
+
+        // Report as in CALINE3.LST:
+        std::istringstream report{ outcome.Report };
+        CHECK(ReportLines(report) == expected);
+
+        // EXAMPLE FOUR matrix:
+        bool found = false;
+        for (std::size_t J = 0; J < outcome.Jobs.size(); J++)
+        {
+            if (outcome.Jobs[J].JOB != "EXAMPLE FOUR")
+                continue;
+            found = true;
+            for (auto const& meteo : outcome.Jobs[J].Meteos)
+            {
+                for (auto const& link : outcome.Jobs[J].Links)
+                {
+                    for (auto const& receptor : outcome.Jobs[J].Receptors)
+                    {
+                        double mc = outcome.MC[J][meteo.ORDINAL][link.ORDINAL][receptor.ORDINAL].value();
+                        double exact = test_result[meteo.ORDINAL][link.ORDINAL][receptor.ORDINAL];
+                        if (mode.Exact)
+                            CHECK_THAT(mc, Catch::Matchers::WithinRel(exact, 1.0e-15));
+                        else
+                            CHECK_THAT(mc, Catch::Matchers::WithinAbs(exact, 1.0));    // [ug/m3] (< 0.001 ppm)
+                    }
+                }
+            }
+        }
+        CHECK(found);
+
+        // Throughput:
+        double rate = static_cast<double>(outcome.Pairs) / outcome.Seconds;
+        auto base = baseline.find(mode.Name);
+
+        // A slow run is measured again (up to RETRIES times) before it counts as a regression:
+        for (int retry = 0; (base != baseline.end()) && !update && (rate < base->second * (1.0 - threshold)) && (retry < RETRIES); retry++)
+        {
+            rate = std::max(rate, static_cast<double>(outcome.Pairs) / Run(mode, input).Seconds);
+        }
+        rates[mode.Name] = rate;
+        std::cout << std::left << std::setw(10) << mode.Name << std::right << std::fixed << std::setprecision(0)
+            << std::setw(16) << rate;
+        if (base != baseline.end())
+        {
+            std::cout << std::setw(16) << base->second << std::setw(10) << std::setprecision(2) << rate / base->second << std::endl;
+            if (mode.Threads > std::thread::hardware_concurrency())
+            {
+                WARN("mode " << mode.Name << ": not gated (" << mode.Threads << " threads on " << std::thread::hardware_concurrency() << " cores)");
+            }
+            else if (!update)
+            {
+                INFO("throughput " << rate << " pairs/s, baseline " << base->second << " pairs/s, threshold " << threshold);
+                CHECK(rate >= base->second * (1.0 - threshold));
+            }
+        }
+        else
+        {
+            std::cout << std::setw(16) << "-" << std::setw(10) << "-" << std::endl;
+            if (!update)
+                FAIL_CHECK("mode " << mode.Name << ": no baseline in " << baseline_path << " (record one with CALINE3_BASELINE_UPDATE=1)");
+        }
+    }
+    std::cout << std::defaultfloat;
+
+    // The baseline is rewritten on request only:
+    if (update)
+    {
+        WriteBaseline(baseline_path, rates);
+        WARN("baseline written to " << baseline_path);
+    }
+}
@@ -0,0 +1,640 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "../CALINE3/Engine.h"
+#include "../CALINE3/JobReader.h"
+#include "../CALINE3/LinkMerge.h"
+#include "../CALINE3/Plume.h"
+#include "../CALINE3/Report.h"
+#include "../CALINE3/Roads.h"
+#include "../CALINE3/Workload.h"
+
+using namespace CALINE3;
+
+TEST_CASE( "check synthetic workload" , "[CALINE3][workload]")
+{
+    WorkloadSpec spec;
+    spec.Links = 40;
+    spec.Receptors = 30;
+    spec.Meteos = 5;
+    spec.Geometry = GENERATE(Layout::Grid, Layout::Corridor, Layout::SCurve);
+    spec.Types = { "AG", "BR", "FL", "DP" };
+    spec.MixingHeights = { 1000.0, 300.0 };
+    spec.VS = 1.0;
+    spec.VD = 2.0;
+    spec.Seed = 42;
+
+    // Deterministic (for the same seed):
+    Workload first{ spec };
+    Workload second{ spec };
+    std::ostringstream exp1, exp2;
+    Workload::WriteEXP(exp1, first.Generate(0));
+    Workload::WriteEXP(exp2, second.Generate(0));
+    CHECK(exp1.str() == exp2.str());
+
+    spec.Seed = 43;
+    Workload other{ spec };
+    std::ostringstream exp3;
+    Workload::WriteEXP(exp3, other.Generate(0));
+    CHECK(exp1.str() != exp3.str());
+
+    // The same job in memory and read back from its EXP form:
+    spec.Seed = 42;
+    Workload workload{ spec };
+    const Job job = workload.Generate(0);
+    CHECK(job.Links.size() == 40);
+    CHECK(job.Receptors.size() == 30);
+    CHECK(job.Meteos.size() == 5);
+
+    std::istringstream is{ exp1.str() };
+    std::ostringstream log;
+    JobReader rdr{ "synthetic", is, log };
+    auto read = rdr.Next();
+    REQUIRE(read.has_value());
+    CHECK(!rdr.Next().has_value());
+    CHECK(log.str().empty());
+    REQUIRE(read->Links.size() == job.Links.size());
+    REQUIRE(read->Receptors.size() == job.Receptors.size());
+    REQUIRE(read->Meteos.size() == job.Meteos.size());
+
+    const Engine engine;
+    ConcentrationMatrix expected, actual;
+    for (std::size_t M = 0; M < job.Meteos.size(); M++)
+    {
+        CHECK(read->Meteos[M].BRG() == job.Meteos[M].BRG());
+        engine.Compute(job, job.Meteos[M], expected);
+        engine.Compute(*read, read->Meteos[M], actual);
+        CHECK(actual == expected);
+    }
+}
+
+TEST_CASE( "check synthetic workload limits" , "[CALINE3][workload]")
+{
+    WorkloadSpec spec;
+    spec.Types = { "XX" };
+    CHECK_THROWS_AS(Workload{ spec }, std::invalid_argument);
+    spec.Types = { "AG" };
+    spec.Levels = 0;
+    CHECK_THROWS_AS(Workload{ spec }, std::invalid_argument);
+    spec.Levels = 1;
+
+    // EXP format fits 99 receptors at most (the job itself is fine in memory):
+    spec.Types = { "AG" };
+    spec.Receptors = 100;
+    Workload workload{ spec };
+    const Job job = workload.Generate();
+    CHECK(job.Receptors.size() == 100);
+    std::ostringstream exp;
+    CHECK_THROWS_AS(Workload::WriteEXP(exp, job), std::out_of_range);
+}
+
+TEST_CASE( "check engine partitions" , "[CALINE3][engine]")
+{
+    WorkloadSpec spec;
+    spec.Links = 7;
+    spec.Receptors = 37;
+    spec.Meteos = 2;
+    spec.Types = { "AG", "BR", "FL", "DP" };
+    spec.Seed = 3;
+    const Job job = Workload{ spec }.Generate();
+
+    // Any partition and block size must give the serial results (bit for bit):
+    ThreadPool pool{ 3 };
+    const Engine serial;
+    const Engine links{ &pool, Partition::Links };
+    const Engine blocks{ &pool, Partition::ReceptorBlocks, 5 };
+    const Engine tiles{ &pool, Partition::ReceptorBlocks, 1 };
+    CHECK(blocks.Partitioning() == Partition::ReceptorBlocks);
+
+    ConcentrationMatrix expected, actual;
+    for (auto const& meteo : job.Meteos)
+    {
+        serial.Compute(job, meteo, expected);
+        for (const Engine *engine : { &links, &blocks, &tiles })
+        {
+            actual.clear();
+            engine->Compute(job, meteo, actual);
+            CHECK(actual == expected);
+        }
+    }
+
+    // The workers have been kept busy for a while:
+    auto times = pool.BusyTimes();
+    REQUIRE(times.size() == 3);
+    CHECK((times[0] + times[1] + times[2]).count() > 0);
+    pool.ResetBusyTimes();
+    for (auto busy : pool.BusyTimes())
+    {
+        CHECK(busy.count() == 0);
+    }
+}
+
+TEST_CASE( "check deterministic summation" , "[CALINE3][engine]")
+{
+    WorkloadSpec spec;
+    spec.Links = 6;
+    spec.Receptors = 29;
+    spec.Meteos = 2;
+    spec.Types = { "AG", "BR", "FL", "DP" };
+    spec.Seed = 11;
+    const Job job = Workload{ spec }.Generate();
+
+    CHECK(Maths::ParseSummation("pairwise") == Summation::Pairwise);
+    CHECK_THROWS_AS(Maths::ParseSummation("kahan"), std::invalid_argument);
+
+    // The accumulators do better than left to right addition where it cancels:
+    PairwiseSum pairwise;
+    CompensatedSum compensated;
+    for (double term : { 1.0, 1e16, 1.0, -1e16 })
+    {
+        pairwise.Add(term);
+        compensated.Add(term);
+    }
+    CHECK(pairwise.Total() == 0.0);     // (1 + 1e16) + (1 - 1e16), rounded
+    CHECK(compensated.Total() == 2.0);
+
+    ThreadPool pool1{ 1 }, pool2{ 2 }, pool3{ 3 }, pool4{ 4 };
+    const Engine original;
+    for (Summation sum : { Summation::Sequential, Summation::Pairwise, Summation::Compensated })
+    {
+        MathPolicy policy;
+        policy.Sum = sum;
+
+        // Every summation gives the same results (bit for bit) whatever the thread count and partition
+        // (each cell is summed whole by one thread; nothing is accumulated across the partitions):
+        const Engine serial{ nullptr, Partition::Links, 0, policy };
+        std::vector<Engine> engines;
+        for (ThreadPool *pool : { &pool1, &pool2, &pool3, &pool4 })
+        {
+            engines.emplace_back(pool, Partition::Links, 0, policy);
+            engines.emplace_back(pool, Partition::ReceptorBlocks, 4, policy);
+            engines.emplace_back(pool, Partition::ReceptorBlocks, 1, policy);
+        }
+
+        ConcentrationMatrix reference, expected, actual, tile;
+        for (auto const& meteo : job.Meteos)
+        {
+            serial.Compute(job, meteo, expected);
+            std::ostringstream serial_report;
+            Report{ serial_report }.Print(job, meteo, expected);
+            for (auto const& engine : engines)
+            {
+                actual.clear();
+                engine.Compute(job, meteo, actual);
+                CHECK(actual == expected);
+
+                // ... streamed in tiles too:
+                engine.Stream(job, meteo, 5, tile, [&](const ConcentrationMatrix& t, std::size_t rfirst, std::size_t rlast) {
+                    for (std::size_t l = 0; l < expected.size(); l++)
+                    {
+                        for (std::size_t r = rfirst; r < rlast; r++)
+                        {
+                            CHECK(t[l][r - rfirst] == expected[l][r]);
+                        }
+                    }
+                });
+
+                // ... and the receptor totals (summed over the links in link order, once the matrix is done):
+                std::ostringstream report;
+                Report{ report }.Print(job, meteo, actual);
+                CHECK(report.str() == serial_report.str());
+            }
+
+            // ... and agrees with the original (left to right) summation but for rounding:
+            original.Compute(job, meteo, reference);
+            for (std::size_t l = 0; l < reference.size(); l++)
+            {
+                for (std::size_t r = 0; r < reference[l].size(); r++)
+                {
+                    const double c = reference[l][r].value();
+                    CHECK(std::abs(expected[l][r].value() - c) <= 1e-12 * std::abs(c));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE( "check vertical profiles" , "[CALINE3][engine]")
+{
+    WorkloadSpec spec;
+    spec.Links = 5;
+    spec.Receptors = 33;    // (2 columns of 15 levels and 3 levels at a third location)
+    spec.Levels = 15;
+    spec.Meteos = 3;
+    spec.Types = { "AG", "BR", "FL", "DP" };
+    spec.MixingHeights = { 30.0, 1000.0 };
+    spec.VS = 1.0;
+    spec.VD = 1.0;
+    spec.Seed = 8;
+    const Job job = Workload{ spec }.Generate();
+
+    REQUIRE(job.Receptors.size() == 33);
+    CHECK(job.Receptors[1].XR == job.Receptors[0].XR);
+    CHECK(job.Receptors[1].YR == job.Receptors[0].YR);
+    CHECK(job.Receptors[1].ZR == Meter(4.8));
+    CHECK(job.Receptors[14].ZR == Meter(43.8));
+    CHECK(job.Receptors[15].ZR == Meter(1.8));
+
+    std::vector<Meter> ZR;
+    for (std::size_t r = 0; r < 15; r++)
+    {
+        ZR.push_back(job.Receptors[r].ZR);
+    }
+
+    for (Summation sum : { Summation::Sequential, Summation::Pairwise, Summation::Compensated })
+    {
+        MathPolicy policy;
+        policy.Sum = sum;
+
+        // A profile evaluated in one pass is the same (bit for bit) as its levels one by one
+        // (the scratch reused from one link to the next):
+        ProfileScratch scratch;
+        for (auto const& meteo : job.Meteos)
+        {
+            for (auto const& link : job.Links)
+            {
+                Plume plume{ job, meteo, link, policy };
+                std::vector<Microgram_Meter3> profile(ZR.size());
+                plume.ConcentrationProfile(job.Receptors[0].XR, job.Receptors[0].YR, ZR.data(), ZR.size(), profile.data(), scratch);
+                for (std::size_t k = 0; k < ZR.size(); k++)
+                {
+                    CHECK(profile[k] == plume.ConcentrationAt(job.Receptors[k]));
+                }
+            }
+        }
+
+        // ... and so are the matrices the engine computes a profile at a time:
+        ThreadPool pool{ 2 };
+        const Engine serial{ nullptr, Partition::Links, 0, policy };
+        const Engine blocks{ &pool, Partition::ReceptorBlocks, 4, policy };
+        ConcentrationMatrix expected, actual;
+        for (auto const& meteo : job.Meteos)
+        {
+            expected.assign(job.Links.size(), {});
+            for (auto const& link : job.Links)
+            {
+                Plume plume{ job, meteo, link, policy };
+                for (auto const& receptor : job.Receptors)
+                {
+                    expected[link.ORDINAL].push_back(plume.ConcentrationAt(receptor));
+                }
+            }
+            for (const Engine *engine : { &serial, &blocks })
+            {
+                actual.clear();
+                engine->Compute(job, meteo, actual);
+                CHECK(actual == expected);
+
+                // ... streamed in tiles that split the profiles (grouped once per call, within the tiles):
+                ConcentrationMatrix tile;
+                engine->Stream(job, meteo, 7, tile, [&](const ConcentrationMatrix& t, std::size_t rfirst, std::size_t rlast) {
+                    for (std::size_t l = 0; l < expected.size(); l++)
+                    {
+                        for (std::size_t r = rfirst; r < rlast; r++)
+                        {
+                            CHECK(t[l][r - rfirst] == expected[l][r]);
+                        }
+                    }
+                });
+            }
+        }
+    }
+}
+
+TEST_CASE( "check shared dispersion" , "[CALINE3][engine]")
+{
+    WorkloadSpec spec;
+    spec.Links = 4;
+    spec.Lanes = 3;
+    spec.Receptors = 17;
+    spec.Levels = 2;
+    spec.Meteos = 2;
+    spec.Types = { "AG", "BR", "FL", "DP" };
+    spec.VS = 1.0;
+    spec.VD = 1.0;
+    spec.Seed = 9;
+    const Job generated = Workload{ spec }.Generate();
+    REQUIRE(generated.Links.size() == 12);
+
+    // The same job with the first lane of no traffic:
+    Job job{ generated.ORDINAL, generated.JOB, generated.ATIM, generated.Z0, generated.VS1, generated.VD1, generated.NR, generated.SCAL };
+    for (auto const& l : generated.Links)
+    {
+        job.Links.emplace_back(l.ORDINAL, l.LNK, l.TYP, l.XL1, l.YL1, l.XL2, l.YL2, (l.ORDINAL == 0) ? Vehicles_Hour(0.0) : l.VPHL, l.EFL, l.HL, l.WL);
+    }
+    for (auto const& r : generated.Receptors) job.Receptors.push_back(r);
+    for (auto const& m : generated.Meteos) job.Meteos.push_back(m);
+
+    // Lanes of a segment share the dispersion of the first lane with traffic:
+    const std::vector<std::size_t> sources = Engine::DispersionSources(job);
+    const std::vector<std::size_t> expected_sources = { 1, 1, 1, 3, 3, 3, 6, 6, 6, 9, 9, 9 };
+    CHECK(sources == expected_sources);
+
+    ThreadPool pool{ 3 };
+    MathPolicy policy;
+    policy.SharedDispersion = true;
+    const Engine serial;
+    const Engine shared{ nullptr, Partition::Links, 0, policy };
+    const Engine links{ &pool, Partition::Links, 0, policy };
+    const Engine blocks{ &pool, Partition::ReceptorBlocks, 4, policy };
+
+    ConcentrationMatrix expected, actual, tile;
+    for (auto const& meteo : job.Meteos)
+    {
+        serial.Compute(job, meteo, expected);
+        for (const Engine *engine : { &shared, &links, &blocks })
+        {
+            actual.clear();
+            engine->Compute(job, meteo, actual);
+            for (std::size_t L = 0; L < expected.size(); L++)
+            {
+                for (std::size_t R = 0; R < expected[L].size(); R++)
+                {
+                    if (sources[L] == L)
+                        CHECK(actual[L][R] == expected[L][R]);  // (source links computed as usual)
+                    else
+                        CHECK(std::abs(actual[L][R].value() - expected[L][R].value()) <= 1e-12 * std::abs(expected[L][R].value()));
+                }
+            }
+            CHECK(actual[0][0].value() == 0.0);
+        }
+
+        // Streamed tiles are scaled alike:
+        ConcentrationMatrix whole;
+        shared.Compute(job, meteo, whole);
+        links.Stream(job, meteo, 5, tile, [&whole](const ConcentrationMatrix& tile, std::size_t rfirst, std::size_t rlast) {
+            for (std::size_t L = 0; L < whole.size(); L++)
+            {
+                for (std::size_t R = rfirst; R < rlast; R++)
+                {
+                    CHECK(tile[L][R - rfirst] == whole[L][R]);
+                }
+            }
+        });
+    }
+}
+
+TEST_CASE( "check link merging" , "[CALINE3][engine]")
+{
+    // A straight road digitized as 6 segments, a bend, a busier segment and a road back:
+    Job job{ 0, "MERGE", Minute(60.0), Centimeter(10.0), Centimeter_Sec(0.0), Centimeter_Sec(0.0), 3, 1.0 };
+    auto link = [&job](double x1, double y1, double x2, double y2, double vphl) {
+        job.Links.emplace_back(job.Links.size(), "LINK " + std::to_string(job.Links.size() + 1), "AG",
+            Meter(x1), Meter(y1), Meter(x2), Meter(y2), Vehicles_Hour(vphl), Gram_Mile(30.0), Meter(0.0), Meter(30.0));
+    };
+    link(1000.0, 0.0, 1500.0, 0.0, 5000.0);     // (segments listed out of order)
+    link(0.0, 0.0, 500.0, 0.0, 5000.0);
+    link(500.0, 0.0, 1000.0, 0.0, 5000.0);
+    link(2000.0, 0.0, 2500.0, 0.0, 5000.0);
+    link(1500.0, 0.0, 2000.0, 0.0, 5000.0);
+    link(2500.0, 0.0, 3000.0, 0.0, 5000.0);
+    link(3000.0, 0.0, 3000.0, 500.0, 5000.0);   // bend
+    link(3000.0, 500.0, 3000.0, 1000.0, 8000.0);// busier
+    link(3000.0, 1000.0, 3000.0, 500.0, 8000.0);// back
+    job.Receptors.emplace_back(0, "RECP. 1", Meter(1500.0), Meter(30.0), Meter(1.8));
+    job.Receptors.emplace_back(1, "RECP. 2", Meter(1200.0), Meter(-100.0), Meter(1.8));
+    job.Receptors.emplace_back(2, "RECP. 3", Meter(2900.0), Meter(50.0), Meter(1.8));
+    job.Meteos.emplace_back(0, Meter_Sec(1.0), Degree(0.0), 6, Meter(1000.0), Ppm(0.0));
+    job.Meteos.emplace_back(1, Meter_Sec(2.0), Degree(200.0), 4, Meter(1000.0), Ppm(0.0));
+
+    CHECK(LinkMerger::Continues(job.Links[1], job.Links[2]));
+    CHECK_FALSE(LinkMerger::Continues(job.Links[2], job.Links[1]));
+    CHECK_FALSE(LinkMerger::Continues(job.Links[5], job.Links[6]));    // (not collinear)
+    CHECK_FALSE(LinkMerger::Continues(job.Links[6], job.Links[7]));    // (other traffic)
+    CHECK_FALSE(LinkMerger::Continues(job.Links[7], job.Links[8]));    // (opposite direction)
+
+    std::vector<LinkGroup> groups;
+    const Job merged = LinkMerger::Merge(job, groups);
+    const std::vector<LinkGroup> expected_groups = { { 1, 2, 0, 4, 3, 5 }, { 6 }, { 7 }, { 8 } };
+    REQUIRE(groups == expected_groups);
+    REQUIRE(merged.Links.size() == 4);
+    CHECK(merged.Links[0].LNK == "LINK 1 +5");
+    CHECK(merged.Links[0].XL1 == Meter(0.0));
+    CHECK(merged.Links[0].XL2 == Meter(3000.0));
+    CHECK(merged.Links[0].LL() == Meter(3000.0));
+    CHECK(merged.Links[1].LNK == "LINK 7");
+    CHECK(merged.Receptors.size() == job.Receptors.size());
+    CHECK(merged.Meteos.size() == job.Meteos.size());
+
+    std::ostringstream summary;
+    LinkMerger::PrintSummary(summary, job, groups);
+    CHECK(summary.str() == "Links merged: 9 -> 4 :: MERGE :: LINK 1 +5 = LINK 2, LINK 3, LINK 1, LINK 5, LINK 4, LINK 6\n");
+
+    // Merged link concentrations approximate the sum over their groups:
+    const Engine engine;
+    ConcentrationMatrix expected, actual;
+    for (auto const& meteo : job.Meteos)
+    {
+        engine.Compute(job, meteo, expected);
+        engine.Compute(merged, meteo, actual);
+        for (std::size_t G = 0; G < groups.size(); G++)
+        {
+            for (std::size_t R = 0; R < job.Receptors.size(); R++)
+            {
+                double sum = 0.0;
+                for (std::size_t L : groups[G]) sum += expected[L][R].value();
+                if (groups[G].size() == 1)
+                    CHECK(actual[G][R] == expected[groups[G][0]][R]);
+                else
+                    CHECK(std::abs(actual[G][R].value() - sum) <= 0.05 * sum + 1e-9);
+            }
+        }
+    }
+
+    // Chains are cut at the maximum link length:
+    Job road{ 1, "LONG ROAD", Minute(60.0), Centimeter(10.0), Centimeter_Sec(0.0), Centimeter_Sec(0.0), 0, 1.0 };
+    for (std::size_t L = 0; L < 6; L++)
+    {
+        road.Links.emplace_back(L, "LINK " + std::to_string(L + 1), "AG",
+            Meter(3000.0 * L), Meter(0.0), Meter(3000.0 * (L + 1)), Meter(0.0), Vehicles_Hour(5000.0), Gram_Mile(30.0), Meter(0.0), Meter(30.0));
+    }
+    const Job cut = LinkMerger::Merge(road, groups);
+    const std::vector<LinkGroup> cut_groups = { { 0, 1, 2 }, { 3, 4, 5 } };
+    CHECK(groups == cut_groups);
+    for (auto const& l : cut.Links)
+    {
+        CHECK(l.LL() <= Link::MAX_LENGTH);
+    }
+
+    // Networks of many short segments (listed backwards) merge in linear time:
+    Job digitized{ 2, "DIGITIZED", Minute(60.0), Centimeter(10.0), Centimeter_Sec(0.0), Centimeter_Sec(0.0), 0, 1.0 };
+    constexpr std::size_t SEGMENTS = 20000;
+    for (std::size_t L = 0; L < SEGMENTS; L++)
+    {
+        const double x = 10.0 * (SEGMENTS - 1 - L);
+        digitized.Links.emplace_back(L, "SEG " + std::to_string(L + 1), "AG",
+            Meter(x), Meter(0.0), Meter(x + 10.0), Meter(0.0), Vehicles_Hour(5000.0), Gram_Mile(30.0), Meter(0.0), Meter(10.0));
+    }
+    const Job few = LinkMerger::Merge(digitized, groups);
+    REQUIRE(few.Links.size() == SEGMENTS / 1000);
+    CHECK(groups[0].size() == 1000);
+    CHECK(groups[0].front() == 999);    // (chains run from west to east)
+    CHECK(groups[0].back() == 0);
+    for (auto const& l : few.Links)
+    {
+        CHECK(l.LL() == Meter(10000.0));
+    }
+}
+
+TEST_CASE( "check road segmentation" , "[CALINE3][roads]")
+{
+    // Vertices closer than W skipped, a short tail joined to the last link, long chords split:
+    const Road road = RoadNetwork::Parse("MAIN AG 7500. 30. 0. 30.  0 0  5 5  5 5  120 175  150 350  150 1350  150 22000  150 22010");
+    CHECK(road.ID == "MAIN");
+    CHECK(road.TYP == "AG");
+    CHECK(road.W == Meter(30.0));
+    CHECK(road.X.size() == 7);     // (repeated vertex dropped)
+
+    const std::vector<Link> links = RoadNetwork::Segment(road);
+    REQUIRE(links.size() == 6);
+    CHECK(links[0].LNK == "MAIN/1");
+    CHECK(links[0].XL2 == Meter(120.0));
+    CHECK(links[0].YL2 == Meter(175.0));
+    CHECK(links[2].YL2 == Meter(1350.0));
+    CHECK(links[5].YL2 == Meter(22010.0));
+    for (std::size_t L = 0; L < links.size(); L++)
+    {
+        CHECK(links[L].WL <= links[L].LL());
+        CHECK(links[L].LL() <= Link::MAX_LENGTH);
+        if (L > 0)
+        {
+            CHECK(links[L].XL1 == links[L - 1].XL2);
+            CHECK(links[L].YL1 == links[L - 1].YL2);
+        }
+    }
+
+    CHECK(RoadNetwork::Segment(RoadNetwork::Parse("ONE BR 100 30 5 20 0 0 100 0"))[0].LNK == "ONE");
+
+    // A chord of (about) twice the maximum length whose interpolated midpoint is an ulp too far from its ends:
+    const std::vector<Link> split = RoadNetwork::Segment(RoadNetwork::Parse("SPLIT AG 100 30 0 30 34743.37369372326 26377.4618976614 48029.43277232718 41326.730580772506"));
+    CHECK(split.size() == 3);
+    for (auto const& l : split)
+    {
+        CHECK(l.LL() <= Link::MAX_LENGTH);
+    }
+    CHECK(RoadNetwork::Segment(RoadNetwork::Parse("STUB AG 100 30 0 30 0 0 10 10 20 0")).empty());
+    CHECK_THROWS_AS(RoadNetwork::Parse("BAD XX 100 30 0 30 0 0 100 0"), std::invalid_argument);
+    CHECK_THROWS_AS(RoadNetwork::Parse("BAD AG 100 30 0 30 0 0 100"), std::invalid_argument);
+    CHECK_THROWS_AS(RoadNetwork::Parse("BAD AG 100 30 0 30 0 0 0 0"), std::invalid_argument);
+    CHECK_THROWS_AS(RoadNetwork::Parse("BAD AG 100 30 0 0 0 0 100 0"), std::invalid_argument);
+    CHECK_THROWS_AS(RoadNetwork::Segment(RoadNetwork::Parse("BAD AG 100 30 20 30 0 0 100 0")), std::invalid_argument);
+
+    // The network segmented in parallel as serially (in the input order):
+    std::ostringstream network;
+    network << "# ID TYP VPH EF H W vertices\n\n";
+    for (int r = 0; r < 40; r++)
+    {
+        network << "R" << r << " AG 5000 20 0 30";
+        for (int v = 0; v < 50 + 10 * r; v++)
+        {
+            network << ' ' << r * 100 + 30 * std::sin(v / 7.0) << ' ' << 7.0 * v;
+        }
+        network << (r == 17 ? " \nSTUB AG 1 1 0 30 0 0 1 1\n" : "\n");
+    }
+
+    std::vector<Link> serial, parallel;
+    std::ostringstream log;
+    std::istringstream is1{ network.str() };
+    const RoadStats stats = RoadNetwork::Read("roads", is1, nullptr, serial, log);
+    CHECK(stats.Roads == 41);
+    CHECK(stats.Skipped == 1);
+    CHECK(stats.Links == serial.size());
+    CHECK_FALSE(stats.Error);
+    CHECK(log.str() == "roads: road \"STUB\" at line 21 is shorter than its width (skipped).\n");
+
+    ThreadPool pool{ 3 };
+    std::istringstream is2{ network.str() };
+    RoadNetwork::Read("roads", is2, &pool, parallel, log);
+    REQUIRE(parallel.size() == serial.size());
+    for (std::size_t L = 0; L < serial.size(); L++)
+    {
+        CHECK(parallel[L].ORDINAL == L);
+        CHECK(parallel[L].LNK == serial[L].LNK);
+        CHECK(parallel[L].XL1 == serial[L].XL1);
+        CHECK(parallel[L].YL2 == serial[L].YL2);
+    }
+
+    // Errors are reported against the input lines:
+    std::ostringstream errors;
+    std::istringstream is3{ "A AG 1 1 0 30 0 0 100 0\n\nB AG 1 1 0 30 0 0 100\n" };
+    CHECK(RoadNetwork::Read("roads", is3, &pool, serial, errors).Error);
+    CHECK(serial.empty());
+    CHECK(errors.str() == "roads: invalid road at line 3 (invalid vertex y-coordinate).\n");
+
+    // A network of no links is no error:
+    std::istringstream is4{ "# nothing but\nSTUB AG 1 1 0 30 0 0 1 1\n" };
+    const RoadStats none = RoadNetwork::Read("roads", is4, &pool, serial, errors);
+    CHECK_FALSE(none.Error);
+    CHECK(none.Links == 0);
+    CHECK(none.Skipped == 1);
+    std::istringstream is5{ "" };
+    CHECK_FALSE(RoadNetwork::Read("roads", is5, nullptr, serial, errors).Error);
+
+    // Network links follow the links of a job:
+    WorkloadSpec spec;
+    spec.Links = 3;
+    const Job generated = Workload{ spec }.Generate();
+    const Job job = RoadNetwork::Attach(generated, links);
+    REQUIRE(job.Links.size() == 9);
+    CHECK(job.Links[2].LNK == generated.Links[2].LNK);
+    CHECK(job.Links[3].LNK == "MAIN/1");
+    CHECK(job.Links[8].ORDINAL == 8);
+    CHECK(job.Receptors.size() == generated.Receptors.size());
+}
+
+TEST_CASE( "check streaming execution" , "[CALINE3][memory]")
+{
+    WorkloadSpec spec;
+    spec.Links = 12;        // (report of more than 10 links goes through the receptors twice)
+    spec.Receptors = 37;
+    spec.Meteos = 2;
+    spec.Types = { "AG", "BR", "FL", "DP" };
+    spec.Seed = 5;
+    const Job job = Workload{ spec }.Generate();
+
+    CHECK(Engine::TileFor(12, 37, Engine::MatrixBytes(12, 37)) == 37);
+    CHECK(Engine::TileFor(12, 37, Engine::MatrixBytes(12, 5)) == 5);
+    CHECK(Engine::TileFor(12, 37, 0) == 1);
+
+    // Tiles of any size give the results (and report) of the matrix computed whole:
+    ThreadPool pool{ 3 };
+    const Engine engine{ &pool };
+    ConcentrationMatrix MC, tile;
+    for (auto const& meteo : job.Meteos)
+    {
+        engine.Compute(job, meteo, MC);
+        std::ostringstream expected;
+        Report{ expected }.Print(job, meteo, MC);
+
+        for (std::size_t block : { 1, 5, 37, 100 })
+        {
+            std::size_t next = 0, passes = 0;
+            std::ostringstream actual;
+            Report{ actual }.Print(job, meteo, [&](const Report::TileSink& sink) {
+                passes++;
+                next = 0;
+                engine.Stream(job, meteo, block, tile, [&](const ConcentrationMatrix& part, std::size_t rfirst, std::size_t rlast) {
+                    CHECK(rfirst == next);
+                    next = rlast;
+                    for (std::size_t L = 0; L < MC.size(); L++)
+                    {
+                        for (std::size_t R = rfirst; R < rlast; R++)
+                        {
+                            CHECK(part[L][R - rfirst] == MC[L][R]);
+                        }
+                    }
+                    sink(part, rfirst, rlast);
+                });
+                CHECK(next == job.Receptors.size());
+            });
+            CHECK(passes == 2);
+            CHECK(actual.str() == expected.str());
+        }
+    }
+}
+